@@ -0,0 +1,143 @@
+#include "AmbientBacklight.h"
+#include "AttributeTable.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <time.h>
+
+namespace {
+
+int64_t monotonicMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+} // namespace
+
+AmbientBacklightPolicy::AmbientBacklightPolicy(const Settings& settings)
+    : settings(settings)
+{
+}
+
+void AmbientBacklightPolicy::setMaximum(int maximum)
+{
+    max_level = std::max(0, maximum);
+    current = std::min(current, max_level);
+}
+
+int AmbientBacklightPolicy::levelFor(double lux) const
+{
+    if (max_level <= 0 || lux >= settings.bright_lux) {
+        return 0;
+    }
+    if (lux <= settings.dark_lux) {
+        return max_level;
+    }
+    // max_level + 1 equal bands between dark and bright on a log scale
+    double position = std::log(lux / settings.dark_lux) / std::log(settings.bright_lux / settings.dark_lux);
+    int level = static_cast<int>((1 - position) * (max_level + 1));
+    return std::clamp(level, 0, max_level);
+}
+
+double AmbientBacklightPolicy::filteredLux() const
+{
+    return std::exp(filtered_log) - 1;
+}
+
+int AmbientBacklightPolicy::update(int64_t now_ms, double lux)
+{
+    // Exponential smoothing of log(lux); the eye is logarithmic too
+    double sample = std::log(std::max(0.0, lux) + 1);
+    if (!decided) {
+        filtered_log = sample;
+    } else {
+        double elapsed = static_cast<double>(std::max<int64_t>(0, now_ms - last_sample_ms));
+        filtered_log += elapsed / (settings.time_constant_ms + elapsed) * (sample - filtered_log);
+    }
+    last_sample_ms = now_ms;
+
+    double smoothed = filteredLux();
+    int target = levelFor(smoothed);
+    if (decided && target != current) {
+        // Brighter light means a lower level; stay while either edge of
+        // the margin still maps to the current one
+        int brighter = levelFor(smoothed * (1 + settings.hysteresis));
+        int darker = levelFor(smoothed / (1 + settings.hysteresis));
+        if (current >= brighter && current <= darker) {
+            return current;
+        }
+        if (now_ms - last_change_ms < settings.min_interval_ms) {
+            return current;
+        }
+    }
+    if (!decided || target != current) {
+        decided = true;
+        current = target;
+        last_change_ms = now_ms;
+    }
+    return current;
+}
+
+AmbientBacklight::AmbientBacklight(const AmbientBacklightPolicy::Settings& settings, QObject *parent)
+    : QObject(parent)
+    , backlightPolicy(settings)
+{
+    connect(&lightSensor, &AmbientLightSensor::samplesReady, this, &AmbientBacklight::process);
+}
+
+bool AmbientBacklight::start(const AmbientLightSensor::Settings& sensor_settings)
+{
+    ControlResult<int> level = AttributeTable::tryGet<AttributeTable::KeyboardBrightness>();
+    if (!level.ok()) {
+        error = level.status().message(AttributeTable::rows[AttributeTable::KeyboardBrightness].name);
+        return false;
+    }
+    if (!lightSensor.open(sensor_settings)) {
+        error = lightSensor.errorString();
+        return false;
+    }
+    backlightPolicy.setMaximum(AttributeTable::maximum<AttributeTable::KeyboardBrightness>());
+    applied = level.value();
+    return true;
+}
+
+void AmbientBacklight::stop()
+{
+    lightSensor.close();
+}
+
+void AmbientBacklight::process(const QVector<AmbientLightSensor::Sample>& batch)
+{
+    if (batch.isEmpty()) {
+        return;
+    }
+    // Device timestamps are only used from the monotonic clock; otherwise
+    // the batch ends now and its samples are spaced by the sampling rate
+    const bool device_time = lightSensor.timestampsMonotonic();
+    const double period_ms = lightSensor.samplingHz() > 0 ? 1000 / lightSensor.samplingHz() : 0;
+    int64_t now = monotonicMs();
+    int level = applied;
+    for (int i = 0; i < batch.size(); ++i) {
+        const AmbientLightSensor::Sample& sample = batch[i];
+        int64_t at = now - static_cast<int64_t>((batch.size() - 1 - i) * period_ms);
+        if (device_time && sample.timestamp_ns > 0) {
+            at = sample.timestamp_ns / 1000000;
+        }
+        level = backlightPolicy.update(at, sample.lux);
+    }
+    // Only the batch's last decision is written
+    if (level == applied) {
+        return;
+    }
+    ControlStatus status = AttributeTable::trySet<AttributeTable::KeyboardBrightness>(level);
+    if (!status.ok()) {
+        qDebug() << "Error: AmbientBacklight::process "
+                 << status.message(AttributeTable::rows[AttributeTable::KeyboardBrightness].name, QString::number(level));
+        return;
+    }
+    applied = level;
+    ++writes;
+    emit levelChanged(level, backlightPolicy.filteredLux());
+}
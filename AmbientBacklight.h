@@ -0,0 +1,92 @@
+#ifndef AMBIENTBACKLIGHT_H
+#define AMBIENTBACKLIGHT_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <cstdint>
+#include "AmbientLightSensor.h"
+
+// Chooses a keyboard backlight level from ambient light: full brightness
+// in the dark, off in daylight, spaced evenly on a log scale in between.
+// Pure decision logic with no I/O, so a recorded trace can be fed in.
+// Readings are smoothed in the log domain; a level only changes once the
+// light has moved past the boundary by the hysteresis margin, and changes
+// are at least min_interval_ms apart, so a passing shadow or a flickering
+// screen does not make the keyboard blink.
+class AmbientBacklightPolicy
+{
+public:
+    struct Settings
+    {
+        double dark_lux = 5;            // at or below: the maximum level
+        double bright_lux = 300;        // at or above: off
+        double hysteresis = 0.3;        // fraction of lux beyond a boundary
+        int time_constant_ms = 2000;    // of the smoothing filter
+        int min_interval_ms = 3000;     // between two level changes
+    };
+
+    explicit AmbientBacklightPolicy(const Settings& settings = Settings());
+
+    // Levels run from 0 to maximum, as in max_brightness
+    void setMaximum(int maximum);
+    int maximum() const { return max_level; }
+
+    // Feeds one reading and returns the level to show from now on
+    int update(int64_t now_ms, double lux);
+
+    // The level for lux without smoothing or hysteresis
+    int levelFor(double lux) const;
+
+    int level() const { return current; }
+    double filteredLux() const;
+
+private:
+    Settings settings;
+    int max_level = 0;
+    int current = 0;
+    bool decided = false;
+    double filtered_log = 0;
+    int64_t last_sample_ms = 0;
+    int64_t last_change_ms = 0;
+};
+
+// Runs AmbientBacklightPolicy on the samples of an AmbientLightSensor and
+// writes the keyboard backlight when the level changes, and only then. A
+// level set by hand stays until the light moves far enough to change the
+// chosen level.
+class AmbientBacklight : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AmbientBacklight(const AmbientBacklightPolicy::Settings& settings = AmbientBacklightPolicy::Settings(),
+                              QObject *parent = nullptr);
+
+    // False without a keyboard backlight or a usable sensor
+    bool start(const AmbientLightSensor::Settings& sensor_settings = AmbientLightSensor::Settings());
+    void stop();
+    bool isRunning() const { return lightSensor.isOpen(); }
+    QString errorString() const { return error; }
+
+    // One batch of samples, the last taken as now unless the sensor's
+    // timestamps are monotonic
+    void process(const QVector<AmbientLightSensor::Sample>& batch);
+
+    const AmbientBacklightPolicy& policy() const { return backlightPolicy; }
+    const AmbientLightSensor& sensor() const { return lightSensor; }
+    int currentLevel() const { return applied; }
+    quint64 writeCount() const { return writes; }
+
+signals:
+    void levelChanged(int level, double lux);
+
+private:
+    AmbientBacklightPolicy backlightPolicy;
+    AmbientLightSensor lightSensor;
+    int applied = -1;
+    quint64 writes = 0;
+    QString error;
+};
+
+#endif // AMBIENTBACKLIGHT_H
@@ -0,0 +1,328 @@
+#include "AmbientLightSensor.h"
+#include "SysfsAttribute.h"
+#include "SysfsRoot.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+QByteArray readText(const QString& path)
+{
+    SysfsAttribute attribute(path);
+    char buffer[SysfsAttribute::buffer_size];
+    ssize_t length = attribute.read(buffer, sizeof(buffer));
+    return length < 0 ? QByteArray() : QByteArray(buffer, static_cast<int>(length));
+}
+
+bool writeText(const QString& path, const QByteArray& text)
+{
+    return SysfsAttribute(path).write(text.constData(), static_cast<size_t>(text.size()));
+}
+
+// The scan element file that enables the illuminance channel, e.g.
+// in_illuminance_en or in_illuminance0_en
+QString illuminanceElement(const QString& device_directory)
+{
+    const QStringList elements = QDir(device_directory + "/scan_elements")
+                                     .entryList({"in_illuminance*_en"}, QDir::Files, QDir::Name);
+    return elements.isEmpty() ? QString() : elements.first();
+}
+
+} // namespace
+
+AmbientLightSensor::AmbientLightSensor(QObject *parent)
+    : QObject(parent)
+{
+}
+
+AmbientLightSensor::~AmbientLightSensor()
+{
+    close();
+}
+
+QString AmbientLightSensor::find()
+{
+    const QString devices = SysfsRoot::path("/sys/bus/iio/devices");
+    for (const QString& name : QDir(devices).entryList({"iio:device*"}, QDir::Dirs | QDir::Files, QDir::Name)) {
+        if (!illuminanceElement(devices + "/" + name).isEmpty()) {
+            return devices + "/" + name;
+        }
+    }
+    return QString();
+}
+
+bool AmbientLightSensor::open(const Settings& settings)
+{
+    QString device = find();
+    if (device.isEmpty()) {
+        error = "No IIO ambient light sensor with a buffered illuminance channel";
+        return false;
+    }
+    return open(device, settings);
+}
+
+bool AmbientLightSensor::open(const QString& device_directory, const Settings& settings)
+{
+    close();
+    directory = device_directory;
+    if (!configure(settings)) {
+        return false;
+    }
+
+    const QString node = SysfsRoot::path("/dev/" + QFileInfo(directory).fileName());
+    device_fd = ::open(QFile::encodeName(node).constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (device_fd < 0) {
+        error = QString("Cannot open %1: %2").arg(node, strerror(errno));
+        writeText(directory + "/buffer/enable", "0");
+        return false;
+    }
+    // Room for everything the kernel may hold, so one read drains it
+    read_capacity = record_size * std::max(settings.buffer_length, settings.watermark);
+    pending.reserve(read_capacity);
+    batch.reserve(std::max(settings.buffer_length, settings.watermark));
+
+    notifier = new QSocketNotifier(device_fd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &AmbientLightSensor::onActivated);
+    return true;
+}
+
+void AmbientLightSensor::close()
+{
+    if (device_fd < 0) {
+        return;
+    }
+    delete notifier;
+    notifier = nullptr;
+    ::close(device_fd);
+    device_fd = -1;
+    writeText(directory + "/buffer/enable", "0");
+    pending.clear();
+}
+
+bool AmbientLightSensor::configure(const Settings& settings)
+{
+    // The buffer cannot be reconfigured while it runs
+    if (!QFileInfo::exists(directory + "/buffer/enable")) {
+        error = directory + " has no buffered interface";
+        return false;
+    }
+    writeText(directory + "/buffer/enable", "0");
+
+    const QString element = illuminanceElement(directory);
+    if (element.isEmpty()) {
+        error = directory + " has no illuminance scan element";
+        return false;
+    }
+    const QString prefix = element.chopped(3);
+    const QString elements = directory + "/scan_elements/";
+    for (const QString& name : QDir(elements).entryList({"*_en"}, QDir::Files)) {
+        bool wanted = name == element || name == "in_timestamp_en";
+        writeText(elements + name, wanted ? "1" : "0");
+    }
+    if (!readChannel(elements + prefix, illuminance)) {
+        error = "Cannot parse the scan type of " + elements + prefix;
+        return false;
+    }
+    // Without a usable timestamp it must not take up room in the record
+    if (QFileInfo::exists(elements + "in_timestamp_en") && !readChannel(elements + "in_timestamp", timestamp)) {
+        writeText(elements + "in_timestamp_en", "0");
+    }
+    layout();
+
+    // IIO stamps samples with CLOCK_REALTIME unless told otherwise, and that
+    // clock jumps; without the monotonic one the consumer keeps its own time
+    monotonic_timestamps = timestamp.index >= 0
+                           && writeText(directory + "/current_timestamp_clock", "monotonic");
+
+    // raw is in counts; lux = (raw + offset) * scale
+    bool ok = false;
+    scale = readText(directory + "/" + prefix + "_scale").toDouble(&ok);
+    if (!ok) {
+        scale = 1;
+    }
+    offset = readText(directory + "/" + prefix + "_offset").toDouble(&ok);
+    if (!ok) {
+        offset = 0;
+    }
+
+    // Triggered capture: use the device's own trigger unless one is set
+    const QString currentTrigger = directory + "/trigger/current_trigger";
+    if (QFileInfo::exists(currentTrigger) && readText(currentTrigger).isEmpty()) {
+        const QByteArray wanted = readText(directory + "/name") + "-dev"
+                                  + QFileInfo(directory).fileName().remove("iio:device").toLatin1();
+        const QString devices = QFileInfo(directory).absolutePath();
+        for (const QString& trigger : QDir(devices).entryList({"trigger*"}, QDir::Dirs | QDir::Files)) {
+            if (readText(devices + "/" + trigger + "/name") == wanted) {
+                writeText(currentTrigger, wanted);
+                break;
+            }
+        }
+    }
+
+    // Bounds the read rate: sampling_hz / watermark wakeups per second
+    sampling_hz = 0;
+    for (const QString& name : {prefix + "_sampling_frequency", QString("sampling_frequency")}) {
+        const QString path = directory + "/" + name;
+        if (QFileInfo::exists(path)) {
+            writeText(path, QByteArray::number(settings.sampling_hz));
+            sampling_hz = readText(path).toDouble();
+            break;
+        }
+    }
+    writeText(directory + "/buffer/length", QByteArray::number(settings.buffer_length));
+    // Older kernels have no watermark and wake for every sample
+    writeText(directory + "/buffer/watermark", QByteArray::number(settings.watermark));
+
+    if (!writeText(directory + "/buffer/enable", "1")) {
+        error = QString("Cannot enable the buffer of %1: %2").arg(directory, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool AmbientLightSensor::readChannel(const QString& prefix, Channel& channel)
+{
+    // Left unset on failure, so layout() and decode() skip it
+    channel = Channel();
+    Channel parsed;
+    bool ok = false;
+    parsed.index = readText(prefix + "_index").toInt(&ok);
+    if (!ok) {
+        return false;
+    }
+
+    // [be|le]:[s|u]bits/storagebits[Xrepeat]>>shift
+    const QByteArray type = readText(prefix + "_type");
+    int colon = type.indexOf(':');
+    int slash = type.indexOf('/');
+    int shift = type.indexOf(">>");
+    if (colon < 0 || slash < colon || shift < slash || colon + 1 >= type.size()) {
+        return false;
+    }
+    int repeat = type.indexOf('X', slash);
+    int storage_end = repeat >= 0 && repeat < shift ? repeat : shift;
+    int storage_bits = type.mid(slash + 1, storage_end - slash - 1).toInt();
+    parsed.big_endian = type.startsWith("be");
+    parsed.is_signed = type.at(colon + 1) == 's';
+    parsed.real_bits = type.mid(colon + 2, slash - colon - 2).toInt();
+    parsed.shift = type.mid(shift + 2).toInt();
+    parsed.storage_bytes = storage_bits / 8;
+    if (parsed.storage_bytes <= 0 || parsed.storage_bytes > 8 || parsed.real_bits <= 0
+        || parsed.real_bits > storage_bits) {
+        return false;
+    }
+    channel = parsed;
+    return true;
+}
+
+void AmbientLightSensor::layout()
+{
+    // Channels follow each other by index, each aligned to its own size,
+    // and the record is padded to the largest
+    Channel *channels[2] = {&illuminance, &timestamp};
+    std::sort(std::begin(channels), std::end(channels), [](const Channel *a, const Channel *b) {
+        return a->index < b->index;
+    });
+    int position = 0;
+    int alignment = 1;
+    for (Channel *channel : channels) {
+        if (channel->index < 0) {
+            continue;
+        }
+        position = (position + channel->storage_bytes - 1) / channel->storage_bytes * channel->storage_bytes;
+        channel->offset = position;
+        position += channel->storage_bytes;
+        alignment = std::max(alignment, channel->storage_bytes);
+    }
+    record_size = (position + alignment - 1) / alignment * alignment;
+}
+
+namespace {
+
+int64_t extract(const char *record, int offset, int storage_bytes, int real_bits, int shift, bool is_signed,
+                bool big_endian)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(record + offset);
+    uint64_t value = 0;
+    for (int i = 0; i < storage_bytes; ++i) {
+        value = (value << 8) | bytes[big_endian ? i : storage_bytes - 1 - i];
+    }
+    value >>= shift;
+    if (real_bits < 64) {
+        value &= (uint64_t(1) << real_bits) - 1;
+        if (is_signed && (value & (uint64_t(1) << (real_bits - 1)))) {
+            value |= ~((uint64_t(1) << real_bits) - 1);
+        }
+    }
+    return static_cast<int64_t>(value);
+}
+
+} // namespace
+
+AmbientLightSensor::Sample AmbientLightSensor::decode(const char *record) const
+{
+    Sample sample;
+    const Channel& light = illuminance;
+    int64_t raw = extract(record, light.offset, light.storage_bytes, light.real_bits, light.shift, light.is_signed,
+                          light.big_endian);
+    sample.lux = (static_cast<double>(raw) + offset) * scale;
+    if (timestamp.index >= 0) {
+        sample.timestamp_ns = extract(record, timestamp.offset, timestamp.storage_bytes, timestamp.real_bits,
+                                      timestamp.shift, timestamp.is_signed, timestamp.big_endian);
+    }
+    return sample;
+}
+
+void AmbientLightSensor::onActivated()
+{
+    ++stats.wakeups;
+    batch.clear();
+    const int capacity = read_capacity;
+    for (;;) {
+        int held = static_cast<int>(pending.size());
+        pending.resize(capacity);
+        ssize_t length = ::read(device_fd, pending.data() + held, static_cast<size_t>(capacity - held));
+        if (length < 0 && errno == EINTR) {
+            pending.resize(held);
+            continue;
+        }
+        pending.resize(held + static_cast<int>(std::max<ssize_t>(length, 0)));
+        if (length < 0) {
+            if (errno != EAGAIN) {
+                error = QString("Reading the ambient light sensor failed: %1").arg(strerror(errno));
+                notifier->setEnabled(false);
+            }
+            break;
+        }
+        ++stats.reads;
+        if (length == 0) {
+            // Only a FIFO standing in for the device ends
+            error = "The ambient light sensor went away";
+            notifier->setEnabled(false);
+            break;
+        }
+
+        int consumed = 0;
+        while (pending.size() - consumed >= record_size) {
+            batch.append(decode(pending.constData() + consumed));
+            consumed += record_size;
+        }
+        pending.remove(0, consumed);
+        // A short read means the kernel had nothing more
+        if (held + length < capacity) {
+            break;
+        }
+    }
+    stats.samples += static_cast<quint64>(batch.size());
+    if (!batch.isEmpty()) {
+        emit samplesReady(batch);
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef AMBIENTLIGHTSENSOR_H
+#define AMBIENTLIGHTSENSOR_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+class QSocketNotifier;
+
+// An IIO ambient light sensor read through its buffered interface rather
+// than by polling in_illuminance_raw. The illuminance channel (and the
+// timestamp, when the device has one) is enabled in scan_elements, the
+// device's own trigger is selected if none is, and the kernel buffer is
+// set up with a watermark, so /dev/iio:deviceN only becomes readable once
+// that many samples are queued. Each wakeup then reads a whole batch.
+//
+// Everything lives below SysfsRoot, including /dev, so a recorded trace
+// can be written into a FIFO standing in for the character device.
+class AmbientLightSensor : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Settings
+    {
+        int sampling_hz = 4;        // asked of the driver; it may round
+        int watermark = 4;          // samples per wakeup
+        int buffer_length = 64;     // samples the kernel keeps
+    };
+
+    struct Sample
+    {
+        qint64 timestamp_ns = 0;    // the device's clock; 0 without a timestamp channel
+        double lux = 0;
+    };
+
+    struct Statistics
+    {
+        quint64 wakeups = 0;        // QSocketNotifier activations
+        quint64 reads = 0;          // read() calls on the device
+        quint64 samples = 0;
+    };
+
+    explicit AmbientLightSensor(QObject *parent = nullptr);
+    ~AmbientLightSensor();
+
+    // First device below /sys/bus/iio/devices with an illuminance scan
+    // element, or an empty string
+    static QString find();
+
+    bool open(const Settings& settings = Settings());
+    bool open(const QString& device_directory, const Settings& settings);
+    // Disables the kernel buffer again
+    void close();
+    bool isOpen() const { return device_fd >= 0; }
+    QString errorString() const { return error; }
+
+    // The sampling frequency the driver reports after open(); 0 if unknown
+    double samplingHz() const { return sampling_hz; }
+    // Whether Sample::timestamp_ns is CLOCK_MONOTONIC; other clocks can jump
+    bool timestampsMonotonic() const { return monotonic_timestamps; }
+    int recordSize() const { return record_size; }
+    const Statistics& statistics() const { return stats; }
+
+    // Turns one scan record into a sample, for feeding recorded data
+    Sample decode(const char *record) const;
+
+signals:
+    // One batch, oldest first; valid until the next emission
+    void samplesReady(const QVector<AmbientLightSensor::Sample>& batch);
+
+private:
+    // One scan element as described by its _type file, e.g. "le:u32/32>>0"
+    struct Channel
+    {
+        int index = -1;
+        int offset = 0;             // in the record
+        int storage_bytes = 0;
+        int real_bits = 0;
+        int shift = 0;
+        bool is_signed = false;
+        bool big_endian = false;
+    };
+
+    bool configure(const Settings& settings);
+    bool readChannel(const QString& prefix, Channel& channel);
+    void layout();
+    void onActivated();
+
+    QString directory;
+    int device_fd = -1;
+    QSocketNotifier *notifier = nullptr;
+    Channel illuminance;
+    Channel timestamp;
+    int record_size = 0;
+    double scale = 1;
+    double offset = 0;
+    double sampling_hz = 0;
+    bool monotonic_timestamps = false;
+    // Bytes read but not yet a whole record
+    QByteArray pending;
+    int read_capacity = 0;
+    QVector<Sample> batch;
+    Statistics stats;
+    QString error;
+};
+
+#endif // AMBIENTLIGHTSENSOR_H
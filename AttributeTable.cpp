@@ -0,0 +1,68 @@
+#include "AttributeTable.h"
+#include "UnsupportedFeatureException.h"
+
+std::atomic<quint64> AttributeTable::epoch{1};
+
+int AttributeTable::find(const QString& name)
+{
+    for (int id = 0; id < count; ++id) {
+        if (rows[id].exposed && name == QLatin1String(rows[id].name)) {
+            return id;
+        }
+    }
+    return -1;
+}
+
+void AttributeTable::invalidate()
+{
+    epoch.fetch_add(1, std::memory_order_acq_rel);
+}
+
+QString AttributeTable::outOfRangeMessage(int id, int minimum, int maximum)
+{
+    return QString("%1 must be between %2 and %3").arg(rows[id].label).arg(minimum).arg(maximum);
+}
+
+QString AttributeTable::invalidMessage(int id, const QString& value)
+{
+    return QString("%1 %2 is not supported").arg(rows[id].label, value);
+}
+
+void AttributeTable::throwUnsupported(int id)
+{
+    throw UnsupportedFeatureException(QString("%1 is not supported on this device").arg(rows[id].label));
+}
+
+void AttributeTable::throwStatus(int id, ControlStatus status)
+{
+    if (status.error() == ControlError::Unsupported) {
+        throwUnsupported(id);
+    }
+    throw UnsupportedFeatureException(status.message(rows[id].label));
+}
+
+void AttributeTable::throwOutOfRange(int id, int minimum, int maximum)
+{
+    throw UnsupportedFeatureException(outOfRangeMessage(id, minimum, maximum));
+}
+
+void AttributeTable::throwInvalid(int id, const QString& value)
+{
+    throw UnsupportedFeatureException(invalidMessage(id, value));
+}
+
+ssize_t AttributeTable::encode(const QString& value, char *buffer, size_t size)
+{
+    if (static_cast<size_t>(value.size()) >= size) {
+        return -1;
+    }
+    ssize_t length = 0;
+    for (QChar c : value) {
+        if (c.unicode() > 0xff) {
+            return -1;
+        }
+        buffer[length++] = static_cast<char>(c.unicode());
+    }
+    buffer[length] = '\0';
+    return length;
+}
@@ -0,0 +1,391 @@
+#ifndef ATTRIBUTETABLE_H
+#define ATTRIBUTETABLE_H
+
+#include "ControlResult.h"
+#include "DeviceSupport.h"
+#include "Metrics.h"
+#include "SysfsAttribute.h"
+#include "SysfsRoot.h"
+
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <cstring>
+
+// One row of AttributeTable: a fixed sysfs file and how it is read and
+// checked. Rows are constexpr, so everything here is known when a call
+// site is compiled.
+struct AttributeDescriptor
+{
+    enum class Type {
+        Integer,
+        Token,      // one word, e.g. platform_profile
+        TokenList,  // space separated words
+    };
+
+    // Control, metrics and journal name; helper rows share the name of the
+    // control they serve
+    const char *name;
+    // For messages, e.g. "Charge end threshold"
+    const char *label;
+    // Absolute; mapped below SysfsRoot on first use
+    const char *path;
+    Type type;
+    DeviceSupport::Feature feature;
+    bool writable;
+    // Listed by DeviceControls
+    bool exposed;
+    // Fixed while the driver is bound: read once, again after invalidate()
+    bool constant;
+    // Integer rows: accepted range; limit is a row whose value lowers
+    // maximum at run time, or -1
+    int minimum;
+    int maximum;
+    int limit;
+    // Value returned when an Integer read fails
+    int fallback;
+    // Token rows: the row listing accepted values, or -1
+    int choices;
+    // Row that only reports changes made by the firmware (hotkeys), watched
+    // instead of path when present, or -1
+    int hardware;
+};
+
+template <AttributeDescriptor::Type type> struct AttributeValue;
+template <> struct AttributeValue<AttributeDescriptor::Type::Integer> { using type = int; };
+template <> struct AttributeValue<AttributeDescriptor::Type::Token> { using type = QString; };
+template <> struct AttributeValue<AttributeDescriptor::Type::TokenList> { using type = QStringList; };
+
+// The fixed hardware settings as a compile-time table, with accessors
+// templated on the row. Each instantiation holds its own open file and
+// resolves its path once; the parser, range and choices check are picked
+// by the row's type at compile time, so a get or set does no string
+// building and, for rows whose limit is constant, one syscall. tryGet()
+// and trySet() report failures as a ControlResult; get() and set() throw.
+//
+// Adding a setting is adding an Id and a row; DeviceControls generates a
+// control for every exposed row. Firmware attributes are not here because
+// the driver enumerates them at run time (see FirmwareAttribute).
+class AttributeTable
+{
+public:
+    using Type = AttributeDescriptor::Type;
+    using Feature = DeviceSupport::Feature;
+
+    enum Id {
+        KeyboardBrightness,
+        KeyboardMaxBrightness,
+        KeyboardBrightnessHwChanged,
+        PlatformProfile,
+        PlatformProfileChoices,
+        ChargeEndThreshold,
+        count
+    };
+
+    static constexpr AttributeDescriptor rows[count] = {
+        {"keyboard_backlight", "Keyboard backlight",
+         "/sys/class/leds/samsung-galaxybook::kbd_backlight/brightness",
+         Type::Integer, Feature::KeyboardBacklight, true, true, false,
+         0, 0x7fffffff, KeyboardMaxBrightness, 0, -1, KeyboardBrightnessHwChanged},
+        {"keyboard_backlight", "Keyboard backlight",
+         "/sys/class/leds/samsung-galaxybook::kbd_backlight/max_brightness",
+         Type::Integer, Feature::KeyboardBacklight, false, false, true,
+         0, 0x7fffffff, -1, 0, -1, -1},
+        {"keyboard_backlight", "Keyboard backlight",
+         "/sys/class/leds/samsung-galaxybook::kbd_backlight/brightness_hw_changed",
+         Type::Integer, Feature::KeyboardBacklightHwChanged, false, false, false,
+         0, 0x7fffffff, -1, 0, -1, -1},
+        {"performance_mode", "Performance mode",
+         "/sys/firmware/acpi/platform_profile",
+         Type::Token, Feature::PerformanceMode, true, true, false,
+         0, 0, -1, 0, PlatformProfileChoices, -1},
+        {"performance_mode", "Performance mode",
+         "/sys/firmware/acpi/platform_profile_choices",
+         Type::TokenList, Feature::PerformanceMode, false, false, true,
+         0, 0, -1, 0, -1, -1},
+        {"charge_end_threshold", "Charge end threshold",
+         "/sys/class/power_supply/BAT1/charge_control_end_threshold",
+         Type::Integer, Feature::BatteryChargeControl, true, true, false,
+         1, 100, -1, 100, -1, -1},
+    };
+
+    template <int id> using Value = typename AttributeValue<rows[id].type>::type;
+
+    // Index of the exposed row called name, or -1
+    static int find(const QString& name);
+
+    // Drops the cached content of constant rows, after the driver was
+    // reloaded
+    static void invalidate();
+
+    template <int id>
+    static bool isSupported()
+    {
+        return DeviceSupport::isPresent(rows[id].feature);
+    }
+
+    // Below SysfsRoot
+    template <int id>
+    static const QString& path()
+    {
+        static const QString resolved = SysfsRoot::path(QLatin1String(rows[id].path));
+        return resolved;
+    }
+
+    template <int id>
+    static const SysfsAttribute& file()
+    {
+        static const SysfsAttribute attribute(path<id>());
+        return attribute;
+    }
+
+    // Upper bound of an Integer row, lowered by its limit row if any
+    template <int id>
+    static int maximum()
+    {
+        static_assert(rows[id].type == Type::Integer, "only Integer rows have a range");
+        if constexpr (rows[id].limit >= 0) {
+            int limit = 0;
+            if (readInt<rows[id].limit>(limit) && limit < rows[id].maximum) {
+                return limit;
+            }
+        }
+        return rows[id].maximum;
+    }
+
+    // Non-throwing read: Unsupported without the feature, Io with errno
+    // when the read or parse fails
+    template <int id>
+    static ControlResult<Value<id>> tryGet()
+    {
+        constexpr const AttributeDescriptor& row = rows[id];
+        if (Q_UNLIKELY(!isSupported<id>())) {
+            return ControlError::Unsupported;
+        }
+        GALAXYBOOK_TRACE_SCOPE(trace, GALAXYBOOK_TRACE_ATTRIBUTE(rows[id].name), Read);
+        if constexpr (row.type == Type::Integer) {
+            int value = 0;
+            if (!readInt<id>(value)) {
+                GALAXYBOOK_TRACE_FAIL(trace);
+                return ControlStatus::fromErrno();
+            }
+            return value;
+        } else {
+            char content[SysfsAttribute::buffer_size];
+            ssize_t length = read<id>(content, sizeof(content));
+            if (length < 0) {
+                GALAXYBOOK_TRACE_FAIL(trace);
+                return ControlStatus::fromErrno();
+            }
+            if constexpr (row.type == Type::Token) {
+                return QString::fromLatin1(content, static_cast<int>(length));
+            } else {
+                return QString::fromLatin1(content, static_cast<int>(length)).split(' ', Qt::SkipEmptyParts);
+            }
+        }
+    }
+
+    // Non-throwing write: validates first, then one pwrite
+    template <int id>
+    static ControlStatus trySet(const Value<id>& value)
+    {
+        static_assert(rows[id].writable, "attribute is read-only");
+        constexpr const AttributeDescriptor& row = rows[id];
+        if (Q_UNLIKELY(!isSupported<id>())) {
+            return ControlError::Unsupported;
+        }
+
+        char content[SysfsAttribute::buffer_size];
+        size_t length = 0;
+        {
+            GALAXYBOOK_TRACE_SCOPE(trace, GALAXYBOOK_TRACE_ATTRIBUTE(rows[id].name), Validate);
+            if constexpr (row.type == Type::Integer) {
+                if (!inRange<id>(value)) {
+                    GALAXYBOOK_TRACE_FAIL(trace);
+                    return ControlError::OutOfRange;
+                }
+                length = SysfsAttribute::formatInt(value, content);
+            } else {
+                ssize_t encoded = encode(value, content, sizeof(content));
+                if (encoded <= 0 || !isChoice<id>(content, static_cast<size_t>(encoded))) {
+                    GALAXYBOOK_TRACE_FAIL(trace);
+                    return ControlError::InvalidValue;
+                }
+                length = static_cast<size_t>(encoded);
+            }
+        }
+
+        GALAXYBOOK_TRACE_SCOPE(trace, GALAXYBOOK_TRACE_ATTRIBUTE(rows[id].name), Write);
+        if (!file<id>().write(content, length)) {
+            GALAXYBOOK_TRACE_FAIL(trace);
+            return ControlStatus::fromErrno();
+        }
+        return ControlStatus();
+    }
+
+    // Throws only when the feature is missing; a failed read gives the
+    // row's fallback
+    template <int id>
+    static Value<id> get()
+    {
+        ControlResult<Value<id>> result = tryGet<id>();
+        if (result.error() == ControlError::Unsupported) {
+            throwUnsupported(id);
+        }
+        if constexpr (rows[id].type == Type::Integer) {
+            return result.valueOr(rows[id].fallback);
+        } else {
+            return result.value();
+        }
+    }
+
+    template <int id>
+    static void set(const Value<id>& value)
+    {
+        ControlStatus status = trySet<id>(value);
+        switch (status.error()) {
+        case ControlError::None:
+            return;
+        case ControlError::OutOfRange:
+            if constexpr (rows[id].type == Type::Integer) {
+                throwOutOfRange(id, rows[id].minimum, maximum<id>());
+            }
+            break;
+        case ControlError::InvalidValue:
+            if constexpr (rows[id].type != Type::Integer) {
+                throwInvalid(id, value);
+            }
+            break;
+        default:
+            break;
+        }
+        throwStatus(id, status);
+    }
+
+    // Checks a value without writing it
+    template <int id>
+    static bool isValid(const Value<id>& value)
+    {
+        if constexpr (rows[id].type == Type::Integer) {
+            return inRange<id>(value);
+        } else {
+            char content[SysfsAttribute::buffer_size];
+            ssize_t length = encode(value, content, sizeof(content));
+            return length > 0 && isChoice<id>(content, static_cast<size_t>(length));
+        }
+    }
+
+    // Accepted values, e.g. "0..3" or "low-power quiet balanced performance"
+    template <int id>
+    static QString describe()
+    {
+        if constexpr (rows[id].type == Type::Integer) {
+            return QString("%1..%2").arg(rows[id].minimum).arg(maximum<id>());
+        } else if constexpr (rows[id].choices >= 0) {
+            char content[SysfsAttribute::buffer_size];
+            ssize_t length = read<rows[id].choices>(content, sizeof(content));
+            return length < 0 ? QString() : QString::fromLatin1(content, static_cast<int>(length)).simplified();
+        } else {
+            return QString();
+        }
+    }
+
+    // The file to watch: the hardware row when the device has it
+    template <int id>
+    static const QString& monitoringPath()
+    {
+        if constexpr (rows[id].hardware >= 0) {
+            if (isSupported<rows[id].hardware>()) {
+                return path<rows[id].hardware>();
+            }
+        }
+        return path<id>();
+    }
+
+    // Whether set() shows up on monitoringPath() as a change
+    template <int id>
+    static bool notifiesOwnWrites()
+    {
+        if constexpr (rows[id].hardware >= 0) {
+            return !isSupported<rows[id].hardware>();
+        } else {
+            return true;
+        }
+    }
+
+    static QString outOfRangeMessage(int id, int minimum, int maximum);
+    static QString invalidMessage(int id, const QString& value);
+
+    [[noreturn]] static void throwUnsupported(int id);
+    [[noreturn]] static void throwStatus(int id, ControlStatus status);
+    [[noreturn]] static void throwOutOfRange(int id, int minimum, int maximum);
+    [[noreturn]] static void throwInvalid(int id, const QString& value);
+
+private:
+    // Content of a constant row, copied out of the cache
+    struct Cache
+    {
+        QMutex mutex;
+        quint64 epoch = 0;
+        ssize_t length = -1;
+        char content[SysfsAttribute::buffer_size];
+    };
+
+    static std::atomic<quint64> epoch;
+
+    // Latin-1 bytes of value, NUL terminated, or -1 when it does not fit
+    static ssize_t encode(const QString& value, char *buffer, size_t size);
+
+    template <int id>
+    static ssize_t read(char *buffer, size_t size)
+    {
+        if constexpr (rows[id].constant) {
+            static Cache cache;
+            QMutexLocker locker(&cache.mutex);
+            quint64 current = epoch.load(std::memory_order_acquire);
+            if (cache.epoch != current) {
+                cache.length = file<id>().read(cache.content, sizeof(cache.content));
+                // Failures are not cached, so a late driver is picked up
+                cache.epoch = cache.length < 0 ? 0 : current;
+            }
+            if (cache.length < 0 || static_cast<size_t>(cache.length) >= size) {
+                return -1;
+            }
+            std::memcpy(buffer, cache.content, static_cast<size_t>(cache.length) + 1);
+            return cache.length;
+        } else {
+            return file<id>().read(buffer, size);
+        }
+    }
+
+    template <int id>
+    static bool readInt(int& value)
+    {
+        char content[32];
+        ssize_t length = read<id>(content, sizeof(content));
+        return length >= 0 && SysfsAttribute::parseInt(content, static_cast<size_t>(length), value);
+    }
+
+    template <int id>
+    static bool inRange(int value)
+    {
+        return value >= rows[id].minimum && value <= maximum<id>();
+    }
+
+    template <int id>
+    static bool isChoice(const char *token, size_t length)
+    {
+        if constexpr (rows[id].choices >= 0) {
+            char choices[SysfsAttribute::buffer_size];
+            ssize_t size = read<rows[id].choices>(choices, sizeof(choices));
+            return size >= 0 && SysfsAttribute::containsToken(choices, static_cast<size_t>(size), token, length, ' ');
+        } else {
+            return true;
+        }
+    }
+
+    AttributeTable() = delete;
+};
+
+#endif // ATTRIBUTETABLE_H
@@ -0,0 +1,97 @@
+#include "BackgroundMonitor.h"
+#include "ChangeDispatcher.h"
+#include "ChangeJournal.h"
+#include "DeviceControls.h"
+#include "DeviceSupport.h"
+#include "Metrics.h"
+#include "SysfsWatcher.h"
+#include "UeventMonitor.h"
+#include <QDebug>
+
+BackgroundMonitor::BackgroundMonitor(QObject *parent)
+    : QObject(parent)
+    , deviceControls(std::make_unique<DeviceControls>())
+    , changeDispatcher(new ChangeDispatcher(this))
+    , hotplugMonitor(new UeventMonitor(this))
+{
+}
+
+BackgroundMonitor::~BackgroundMonitor() = default;
+
+void BackgroundMonitor::start(const StateCache *seed)
+{
+    for (DeviceControl *control : deviceControls->all()) {
+        if (control->isSupported()) {
+            watchControl(control, seed);
+        }
+    }
+    if (hotplugMonitor->open()) {
+        connect(hotplugMonitor, &UeventMonitor::devicesChanged, this, &BackgroundMonitor::refreshDevices,
+                Qt::UniqueConnection);
+    } else {
+        qDebug() << hotplugMonitor->errorString();
+    }
+}
+
+quint64 BackgroundMonitor::wakeups() const
+{
+    return changeDispatcher->watcher()->statistics().wakeups + hotplugMonitor->statistics().messages;
+}
+
+void BackgroundMonitor::watchControl(DeviceControl *control, const StateCache *seed)
+{
+    QString name = control->name();
+    if (seed && seed->contains(name)) {
+        stateCache.prime(name, seed->value(name), control->notifiesOwnWrites());
+    } else {
+        ControlResult<QString> current = control->tryGet();
+        if (current.ok()) {
+            stateCache.prime(name, current.value(), control->notifiesOwnWrites());
+        }
+    }
+    changeDispatcher->watch(control->monitoringFilePath(), [this, name] { handleChanged(name); }, name);
+}
+
+void BackgroundMonitor::handleChanged(const QString& name)
+{
+    GALAXYBOOK_TRACE_EVENT(Metrics::attribute(name), Notification);
+    DeviceControl *control = deviceControls->find(name);
+    if (!control) {
+        return;
+    }
+    // Nothing is written from here, so every notification is read
+    ControlResult<QString> result = control->tryGet();
+    if (!result.ok()) {
+        return;
+    }
+    QString previous = stateCache.value(name);
+    if (stateCache.update(name, result.value())) {
+        GALAXYBOOK_TRACE_EVENT(Metrics::attribute(name), HardwareChange);
+        if (changeJournal) {
+            changeJournal->append(name, previous, result.value(), ChangeJournal::Origin::Hardware);
+        }
+        emit valueChanged(name, result.value());
+    }
+}
+
+void BackgroundMonitor::refreshDevices()
+{
+    DeviceSupport::refresh();
+    deviceControls->rescan();
+    changeDispatcher->watcher()->rearm();
+    const QStringList watched = changeDispatcher->watchedPaths();
+    for (DeviceControl *control : deviceControls->all()) {
+        if (!control->isSupported()) {
+            continue;
+        }
+        if (!watched.contains(control->monitoringFilePath())) {
+            watchControl(control, nullptr);
+            if (stateCache.contains(control->name())) {
+                emit valueChanged(control->name(), stateCache.value(control->name()));
+            }
+        } else {
+            // The value may have been reset while the device was gone
+            handleChanged(control->name());
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef BACKGROUNDMONITOR_H
+#define BACKGROUNDMONITOR_H
+
+#include <QObject>
+#include <QString>
+#include <memory>
+#include "StateCache.h"
+
+class ChangeDispatcher;
+class ChangeJournal;
+class DeviceControl;
+class DeviceControls;
+class UeventMonitor;
+
+// What stays of the application while it sits in the tray: the attribute
+// watcher, the uevent monitor and the state cache, without any widget or
+// worker thread. Both sources are file descriptors in the event loop and
+// nothing runs on a timer, so while no value changes the process is never
+// woken. A notification costs one read on the calling thread.
+class BackgroundMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BackgroundMonitor(QObject *parent = nullptr);
+    ~BackgroundMonitor();
+
+    // Watches every supported control. Values in seed, e.g. the window's
+    // cache, are taken as current instead of being read again.
+    void start(const StateCache *seed = nullptr);
+
+    // Records hardware changes; not owned
+    void setJournal(ChangeJournal *journal) { changeJournal = journal; }
+
+    const StateCache& cache() const { return stateCache; }
+    // Event loop activations of the watcher and the uevent monitor
+    quint64 wakeups() const;
+
+signals:
+    void valueChanged(const QString& name, const QString& value);
+
+private:
+    void watchControl(DeviceControl *control, const StateCache *seed);
+    void handleChanged(const QString& name);
+    void refreshDevices();
+
+    std::unique_ptr<DeviceControls> deviceControls;
+    ChangeDispatcher *changeDispatcher;
+    UeventMonitor *hotplugMonitor;
+    StateCache stateCache;
+    ChangeJournal *changeJournal = nullptr;
+};
+
+#endif // BACKGROUNDMONITOR_H
@@ -5,6 +5,7 @@
 #include <QList>
 #include "UnsupportedFeatureException.h"
 
+// Named entry points for the charge threshold row of AttributeTable
 class BatteryChargeControl
 {
 public:
@@ -13,6 +14,8 @@ public:
     static int getChargeEndThreshold();
     static QList<int> getRecommendedThresholds();
     static QString getMonitoringFilePath();
+    // power_supply device directory below SysfsRoot
+    static QString getBasePath();
 
 private:
     static const QString base_path;
@@ -21,4 +24,4 @@ private:
     BatteryChargeControl() = delete;
 };
 
-#endif // BATTERYCHARGECONTROL_H 
\ No newline at end of file
+#endif // BATTERYCHARGECONTROL_H 
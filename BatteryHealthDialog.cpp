@@ -0,0 +1,193 @@
+#include "BatteryHealthDialog.h"
+#include <QComboBox>
+#include <QDateTime>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <algorithm>
+#include <cmath>
+
+// Painted by hand: health on the left axis, zoomed to the recorded range,
+// and the threshold as a step line against the fixed 0..100 right axis
+class BatteryHealthPlot : public QWidget
+{
+public:
+    explicit BatteryHealthPlot(QWidget *parent = nullptr)
+        : QWidget(parent)
+    {
+        setMinimumSize(520, 260);
+    }
+
+    void setSamples(const QVector<BatteryHistory::Sample>& samples, qint64 from, qint64 to)
+    {
+        this->samples = samples;
+        this->from = from;
+        this->to = to;
+        update();
+    }
+
+protected:
+    void paintEvent(QPaintEvent *) override
+    {
+        QPainter painter(this);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.fillRect(rect(), palette().base());
+        const QRectF area = QRectF(rect()).adjusted(48, 12, -48, -28);
+        painter.setPen(palette().color(QPalette::Mid));
+        painter.drawRect(area);
+
+        double low = 100;
+        double high = 0;
+        for (const BatteryHistory::Sample& sample : samples) {
+            if (sample.health() >= 0) {
+                low = std::min(low, sample.health());
+                high = std::max(high, sample.health());
+            }
+        }
+        if (low > high || to <= from) {
+            painter.setPen(palette().color(QPalette::Text));
+            painter.drawText(area, Qt::AlignCenter, "No health samples recorded");
+            return;
+        }
+        // Whole percent, at least 5 points tall
+        low = std::floor(low) - 1;
+        high = std::max(std::ceil(high) + 1, low + 5);
+
+        auto x = [&](qint64 time) { return area.left() + area.width() * (time - from) / double(to - from); };
+        auto healthY = [&](double health) { return area.bottom() - area.height() * (health - low) / (high - low); };
+        auto thresholdY = [&](int threshold) { return area.bottom() - area.height() * threshold / 100.0; };
+
+        painter.setPen(palette().color(QPalette::Text));
+        const QFontMetrics metrics(font());
+        for (int i = 0; i <= 4; ++i) {
+            double health = low + (high - low) * i / 4;
+            double y = healthY(health);
+            painter.drawText(QRectF(0, y - 8, area.left() - 6, 16), Qt::AlignRight | Qt::AlignVCenter,
+                             QString::number(health, 'f', 1) + "%");
+            painter.drawText(QRectF(area.right() + 6, thresholdY(25 * i) - 8, 42, 16), Qt::AlignLeft | Qt::AlignVCenter,
+                             QString::number(25 * i) + "%");
+        }
+        const QString dateFormat = to - from > 400 * 86400 ? "yyyy-MM" : "MM-dd";
+        for (int i = 0; i <= 4; ++i) {
+            qint64 time = from + (to - from) * i / 4;
+            QString label = QDateTime::fromSecsSinceEpoch(time).toString(dateFormat);
+            double width = metrics.horizontalAdvance(label);
+            double left = std::clamp(x(time) - width / 2, area.left(), area.right() - width);
+            painter.drawText(QPointF(left, area.bottom() + metrics.ascent() + 6), label);
+        }
+
+        QPainterPath threshold;
+        QPainterPath health;
+        int last_threshold = -1;
+        for (const BatteryHistory::Sample& sample : samples) {
+            if (sample.threshold >= 0) {
+                if (threshold.elementCount() == 0) {
+                    threshold.moveTo(x(sample.time), thresholdY(sample.threshold));
+                } else if (sample.threshold != last_threshold) {
+                    threshold.lineTo(x(sample.time), thresholdY(last_threshold));
+                    threshold.lineTo(x(sample.time), thresholdY(sample.threshold));
+                }
+                last_threshold = sample.threshold;
+            }
+            if (sample.health() >= 0) {
+                QPointF point(x(sample.time), healthY(sample.health()));
+                if (health.elementCount() == 0) {
+                    health.moveTo(point);
+                } else {
+                    health.lineTo(point);
+                }
+            }
+        }
+        if (last_threshold >= 0) {
+            threshold.lineTo(x(samples.last().time), thresholdY(last_threshold));
+        }
+        painter.setBrush(Qt::NoBrush);
+        painter.setPen(QPen(QColor(230, 140, 30), 1.5, Qt::DashLine));
+        painter.drawPath(threshold);
+        painter.setPen(QPen(palette().color(QPalette::Highlight), 2));
+        painter.drawPath(health);
+    }
+
+private:
+    QVector<BatteryHistory::Sample> samples;
+    qint64 from = 0;
+    qint64 to = 0;
+};
+
+BatteryHealthDialog::BatteryHealthDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Battery Health History");
+
+    rangeBox = new QComboBox(this);
+    rangeBox->addItem("Last 30 days", 30);
+    rangeBox->addItem("Last year", 365);
+    rangeBox->addItem("Everything", 0);
+    rangeBox->setCurrentIndex(1);
+    connect(rangeBox, qOverload<int>(&QComboBox::currentIndexChanged), this, &BatteryHealthDialog::showRange);
+    QPushButton *reloadButton = new QPushButton("Reload", this);
+    connect(reloadButton, &QPushButton::clicked, this, &BatteryHealthDialog::reload);
+
+    QHBoxLayout *controls = new QHBoxLayout();
+    controls->addWidget(new QLabel("Health (solid) and charge threshold (dashed)", this));
+    controls->addStretch();
+    controls->addWidget(rangeBox);
+    controls->addWidget(reloadButton);
+
+    plot = new BatteryHealthPlot(this);
+    summary = new QLabel(this);
+    summary->setTextFormat(Qt::RichText);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(controls);
+    layout->addWidget(plot, 1);
+    layout->addWidget(summary);
+
+    reload();
+}
+
+void BatteryHealthDialog::reload()
+{
+    if (!history.openReadOnly(BatteryHistory::defaultPath())) {
+        summary->setText(history.errorString().toHtmlEscaped()
+                         + "<br>galaxybook-controld records the history while it runs.");
+    }
+    showRange();
+}
+
+void BatteryHealthDialog::showRange()
+{
+    const int days = rangeBox->currentData().toInt();
+    qint64 to = QDateTime::currentSecsSinceEpoch();
+    QVector<BatteryHistory::Sample> samples = history.query(days > 0 ? to - qint64(days) * 86400 : 0, to + 1);
+    qint64 from = days > 0 ? to - qint64(days) * 86400 : (samples.isEmpty() ? to : samples.first().time);
+    plot->setSamples(samples, from, to);
+    if (!history.isOpen()) {
+        return;
+    }
+
+    const char *unit = history.unit() == BatteryHistory::Unit::Charge ? "mAh" : "mWh";
+    QString text = "<table cellspacing=\"6\"><tr><th align=\"left\">Threshold</th><th align=\"left\">Since</th>"
+                   "<th align=\"right\">Days</th><th align=\"right\">Health</th>"
+                   "<th align=\"right\">Lost per month</th><th align=\"right\">Lost per 100 cycles</th></tr>";
+    for (const BatteryHistory::WearSegment& segment : BatteryHistory::wearByThreshold(samples)) {
+        text += QString("<tr><td>%1</td><td>%2</td><td align=\"right\">%3</td><td align=\"right\">%4% &rarr; %5%</td>"
+                        "<td align=\"right\">%6</td><td align=\"right\">%7</td></tr>")
+                    .arg(segment.threshold < 0 ? QString("?") : QString("%1%").arg(segment.threshold))
+                    .arg(QDateTime::fromSecsSinceEpoch(segment.first.time).toString("yyyy-MM-dd"))
+                    .arg(segment.days(), 0, 'f', 1)
+                    .arg(segment.first.health(), 0, 'f', 1)
+                    .arg(segment.last.health(), 0, 'f', 1)
+                    .arg(segment.days() >= 1 ? QString::number(segment.lossPerMonth(), 'f', 2) : QString("-"))
+                    .arg(segment.lossPer100Cycles() > 0 ? QString::number(segment.lossPer100Cycles(), 'f', 2) : QString("-"));
+    }
+    text += "</table>";
+    if (!samples.isEmpty()) {
+        const BatteryHistory::Sample& last = samples.last();
+        text += QString("Latest: %1 of %2 %3, %4 cycles").arg(last.full).arg(last.design).arg(unit).arg(last.cycles);
+    }
+    summary->setText(text);
+}
@@ -0,0 +1,32 @@
+#ifndef BATTERYHEALTHDIALOG_H
+#define BATTERYHEALTHDIALOG_H
+
+#include <QDialog>
+#include "BatteryHistory.h"
+
+class QComboBox;
+class QLabel;
+class BatteryHealthPlot;
+
+// Battery health over time from the recorded history, drawn against the
+// charge threshold it was kept at, with the wear rate of each stretch at
+// one threshold. Reads the history once; Reload picks up new samples.
+class BatteryHealthDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit BatteryHealthDialog(QWidget *parent = nullptr);
+
+    void reload();
+
+private:
+    void showRange();
+
+    BatteryHistory history;
+    QComboBox *rangeBox = nullptr;
+    BatteryHealthPlot *plot = nullptr;
+    QLabel *summary = nullptr;
+};
+
+#endif // BATTERYHEALTHDIALOG_H
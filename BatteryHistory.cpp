@@ -0,0 +1,450 @@
+#include "BatteryHistory.h"
+#include "AttributeTable.h"
+#include "BatteryChargeControl.h"
+#include "SysfsAttribute.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+const char* const BatteryHistory::system_path = "/var/lib/galaxybook-control/battery-history";
+
+namespace {
+
+const char magic[8] = {'G', 'B', 'B', 'H', 'I', 'S', 'T', '\0'};
+constexpr quint32 format_version = 1;
+
+struct FileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint8 unit;
+    quint8 reserved[3];
+    quint32 daily_bytes;
+    quint32 hourly_bytes;
+    quint32 padding[2];
+};
+static_assert(sizeof(FileHeader) == 32, "the header is 32 bytes");
+
+void putVarint(QByteArray& out, quint64 value)
+{
+    while (value >= 0x80) {
+        out.append(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+bool getVarint(const char *&data, const char *end, quint64& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (data == end) {
+            return false;
+        }
+        quint8 byte = static_cast<quint8>(*data++);
+        value |= static_cast<quint64>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Small negative deltas stay small: 0, -1, 1, -2, ... become 0, 1, 2, 3, ...
+quint64 zigzag(qint64 value)
+{
+    return (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+}
+
+qint64 unzigzag(quint64 value)
+{
+    return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+}
+
+bool decodeRun(const char *data, const char *end, QVector<BatteryHistory::Sample>& samples, const char **stopped)
+{
+    BatteryHistory::Sample previous;
+    BatteryHistory::Sample sample;
+    while (data < end) {
+        const char *record = data;
+        if (!BatteryHistory::decode(data, end, previous, sample)) {
+            *stopped = record;
+            return false;
+        }
+        samples.append(sample);
+        previous = sample;
+    }
+    *stopped = data;
+    return true;
+}
+
+// Mean of the known values, or -1
+int mean(const BatteryHistory::Sample *begin, const BatteryHistory::Sample *end, int BatteryHistory::Sample::*field)
+{
+    qint64 sum = 0;
+    int known = 0;
+    for (const BatteryHistory::Sample *it = begin; it != end; ++it) {
+        if (it->*field >= 0) {
+            sum += it->*field;
+            ++known;
+        }
+    }
+    return known ? static_cast<int>((sum + known / 2) / known) : -1;
+}
+
+// One sample standing for [begin, end), stamped with the bucket start
+BatteryHistory::Sample aggregate(const BatteryHistory::Sample *begin, const BatteryHistory::Sample *end, qint64 bucket)
+{
+    BatteryHistory::Sample result;
+    result.time = bucket;
+    result.full = mean(begin, end, &BatteryHistory::Sample::full);
+    result.design = mean(begin, end, &BatteryHistory::Sample::design);
+    result.level = mean(begin, end, &BatteryHistory::Sample::level);
+    for (const BatteryHistory::Sample *it = begin; it != end; ++it) {
+        result.cycles = std::max(result.cycles, it->cycles);
+    }
+    result.threshold = (end - 1)->threshold;
+    return result;
+}
+
+// Folds the leading samples of from whose bucket ended before cutoff into
+// to; true when any were moved
+bool fold(QVector<BatteryHistory::Sample>& from, QVector<BatteryHistory::Sample>& to, qint64 bucket_s, qint64 cutoff)
+{
+    int moved = 0;
+    while (moved < from.size()) {
+        qint64 bucket = from.at(moved).time - from.at(moved).time % bucket_s;
+        if (bucket + bucket_s > cutoff) {
+            break;
+        }
+        int end = moved;
+        while (end < from.size() && from.at(end).time < bucket + bucket_s) {
+            ++end;
+        }
+        to.append(aggregate(from.constData() + moved, from.constData() + end, bucket));
+        moved = end;
+    }
+    from.remove(0, moved);
+    return moved > 0;
+}
+
+int readValue(const QString& path)
+{
+    int value;
+    return SysfsAttribute(path).readInt(value) ? value : -1;
+}
+
+} // namespace
+
+double BatteryHistory::Sample::health() const
+{
+    return full >= 0 && design > 0 ? 100.0 * full / design : -1;
+}
+
+double BatteryHistory::WearSegment::lossPerMonth() const
+{
+    return days() >= 1 ? (first.health() - last.health()) / days() * 30 : 0;
+}
+
+double BatteryHistory::WearSegment::lossPer100Cycles() const
+{
+    int cycles = last.cycles - first.cycles;
+    return first.cycles >= 0 && cycles > 0 ? (first.health() - last.health()) / cycles * 100 : 0;
+}
+
+QString BatteryHistory::defaultPath()
+{
+    if (QFileInfo::exists(system_path)) {
+        return system_path;
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/galaxybook-control/battery-history";
+}
+
+bool BatteryHistory::open(const QString& path)
+{
+    close();
+    filePath = path;
+    writable = true;
+    if (!load(true)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool BatteryHistory::openReadOnly(const QString& path)
+{
+    close();
+    filePath = path;
+    writable = false;
+    if (!load(false)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void BatteryHistory::close()
+{
+    filePath.clear();
+    for (QVector<Sample>& tier : tiers) {
+        tier.clear();
+    }
+    file_size = 0;
+}
+
+bool BatteryHistory::load(bool create)
+{
+    QFile file(filePath);
+    if (!file.exists()) {
+        if (!create) {
+            error = filePath + " does not exist";
+            return false;
+        }
+        return rewrite();
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = "Cannot read " + filePath + ": " + file.errorString();
+        return false;
+    }
+    const QByteArray content = file.readAll();
+    file.close();
+
+    FileHeader header;
+    if (content.size() < static_cast<int>(sizeof(header))) {
+        error = filePath + " is not a battery history";
+        return false;
+    }
+    std::memcpy(&header, content.constData(), sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != format_version
+        || sizeof(header) + quint64(header.daily_bytes) + header.hourly_bytes > quint64(content.size())) {
+        error = filePath + " is not a battery history of this version";
+        return false;
+    }
+    capacityUnit = static_cast<Unit>(header.unit);
+
+    const char *daily = content.constData() + sizeof(header);
+    const char *hourly = daily + header.daily_bytes;
+    const char *full = hourly + header.hourly_bytes;
+    const char *end = content.constData() + content.size();
+    const char *stopped = nullptr;
+    if (!decodeRun(daily, hourly, tiers[int(Tier::Daily)], &stopped)
+        || !decodeRun(hourly, full, tiers[int(Tier::Hourly)], &stopped)) {
+        error = filePath + " is damaged";
+        return false;
+    }
+    // An append cut short by a crash leaves a partial record at the end
+    decodeRun(full, end, tiers[int(Tier::Full)], &stopped);
+    file_size = stopped - content.constData();
+    if (stopped != end && writable && !QFile::resize(filePath, file_size)) {
+        error = "Cannot repair " + filePath;
+        return false;
+    }
+    return true;
+}
+
+bool BatteryHistory::append(const Sample& sample, Unit unit)
+{
+    if (!writable) {
+        error = filePath + " is open read-only";
+        return false;
+    }
+    QVector<Sample>& full = tiers[int(Tier::Full)];
+    if (!full.isEmpty() && sample.time < full.last().time) {
+        error = "Sample is older than the newest one";
+        return false;
+    }
+    if (unit != capacityUnit) {
+        if (count(Tier::Daily) + count(Tier::Hourly) + count(Tier::Full) > 0) {
+            error = "The battery changed from charge to energy units or back";
+            return false;
+        }
+        capacityUnit = unit;
+        if (!rewrite()) {
+            return false;
+        }
+    }
+
+    QByteArray record;
+    encode(record, full.isEmpty() ? Sample() : full.last(), sample);
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append) || file.write(record) != record.size()) {
+        error = "Cannot append to " + filePath + ": " + file.errorString();
+        return false;
+    }
+    full.append(sample);
+    file_size += record.size();
+    return compact(sample.time);
+}
+
+bool BatteryHistory::compact(qint64 now)
+{
+    bool moved = fold(tiers[int(Tier::Full)], tiers[int(Tier::Hourly)], 3600, now - full_retention_s);
+    moved = fold(tiers[int(Tier::Hourly)], tiers[int(Tier::Daily)], 86400, now - hourly_retention_s) || moved;
+    return !moved || rewrite();
+}
+
+bool BatteryHistory::rewrite()
+{
+    QByteArray runs[3];
+    for (int tier = 0; tier < 3; ++tier) {
+        Sample previous;
+        for (const Sample& sample : tiers[tier]) {
+            encode(runs[tier], previous, sample);
+            previous = sample;
+        }
+    }
+    FileHeader header = {};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = format_version;
+    header.unit = static_cast<quint8>(capacityUnit);
+    header.daily_bytes = static_cast<quint32>(runs[int(Tier::Daily)].size());
+    header.hourly_bytes = static_cast<quint32>(runs[int(Tier::Hourly)].size());
+
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        error = "Cannot write " + filePath + ": " + file.errorString();
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const QByteArray& run : runs) {
+        file.write(run);
+    }
+    if (!file.commit()) {
+        error = "Cannot write " + filePath + ": " + file.errorString();
+        return false;
+    }
+    file_size = static_cast<qint64>(sizeof(header)) + runs[0].size() + runs[1].size() + runs[2].size();
+    return true;
+}
+
+QVector<BatteryHistory::Sample> BatteryHistory::query(qint64 from, qint64 to) const
+{
+    QVector<Sample> result;
+    // The tiers cover consecutive stretches of time, oldest first
+    for (const QVector<Sample>& tier : tiers) {
+        auto begin = std::lower_bound(tier.cbegin(), tier.cend(), from,
+                                      [](const Sample& sample, qint64 time) { return sample.time < time; });
+        for (auto it = begin; it != tier.cend() && it->time < to; ++it) {
+            result.append(*it);
+        }
+    }
+    return result;
+}
+
+void BatteryHistory::encode(QByteArray& out, const Sample& previous, const Sample& sample)
+{
+    putVarint(out, static_cast<quint64>(sample.time - previous.time));
+    putVarint(out, zigzag(qint64(sample.full) - previous.full));
+    putVarint(out, zigzag(qint64(sample.design) - previous.design));
+    putVarint(out, zigzag(qint64(sample.cycles) - previous.cycles));
+    putVarint(out, zigzag(qint64(sample.level) - previous.level));
+    putVarint(out, zigzag(qint64(sample.threshold) - previous.threshold));
+}
+
+bool BatteryHistory::decode(const char *&data, const char *end, const Sample& previous, Sample& sample)
+{
+    quint64 fields[6];
+    for (quint64& field : fields) {
+        if (!getVarint(data, end, field)) {
+            return false;
+        }
+    }
+    sample.time = previous.time + static_cast<qint64>(fields[0]);
+    sample.full = static_cast<int>(previous.full + unzigzag(fields[1]));
+    sample.design = static_cast<int>(previous.design + unzigzag(fields[2]));
+    sample.cycles = static_cast<int>(previous.cycles + unzigzag(fields[3]));
+    sample.level = static_cast<int>(previous.level + unzigzag(fields[4]));
+    sample.threshold = static_cast<int>(previous.threshold + unzigzag(fields[5]));
+    return true;
+}
+
+BatteryHistory::Sample BatteryHistory::sampleBattery(Unit *unit)
+{
+    const QString base = BatteryChargeControl::getBasePath();
+    Sample sample;
+    sample.time = QDateTime::currentSecsSinceEpoch();
+    // µAh or µWh in sysfs; stored in thousandths
+    bool charge = QFileInfo::exists(base + "/charge_full");
+    const QString prefix = base + (charge ? "/charge_full" : "/energy_full");
+    int full = readValue(prefix);
+    int design = readValue(prefix + "_design");
+    sample.full = full >= 0 ? full / 1000 : -1;
+    sample.design = design >= 0 ? design / 1000 : -1;
+    sample.cycles = readValue(base + "/cycle_count");
+    sample.level = readValue(base + "/capacity");
+    sample.threshold = AttributeTable::tryGet<AttributeTable::ChargeEndThreshold>().valueOr(-1);
+    if (unit) {
+        *unit = charge ? Unit::Charge : Unit::Energy;
+    }
+    return sample;
+}
+
+QVector<BatteryHistory::WearSegment> BatteryHistory::wearByThreshold(const QVector<Sample>& samples)
+{
+    QVector<WearSegment> segments;
+    for (const Sample& sample : samples) {
+        if (sample.health() < 0) {
+            continue;
+        }
+        if (segments.isEmpty() || segments.last().threshold != sample.threshold) {
+            // A stretch starts where the previous one ended
+            WearSegment segment;
+            segment.threshold = sample.threshold;
+            segment.first = segments.isEmpty() ? sample : segments.last().last;
+            segments.append(segment);
+        }
+        segments.last().last = sample;
+    }
+    return segments;
+}
+
+BatteryHistoryRecorder::BatteryHistoryRecorder(QObject *parent)
+    : QObject(parent)
+{
+    // Minutes apart; let the timer share a wakeup with others
+    timer.setTimerType(Qt::VeryCoarseTimer);
+    connect(&timer, &QTimer::timeout, this, &BatteryHistoryRecorder::record);
+}
+
+bool BatteryHistoryRecorder::start(const QString& path, int interval_s)
+{
+    // The timer takes milliseconds in an int
+    if (interval_s < 1 || interval_s > std::numeric_limits<int>::max() / 1000) {
+        error = QString("Battery sampling interval %1 s is out of range").arg(interval_s);
+        return false;
+    }
+    BatteryHistory::Sample probe = BatteryHistory::sampleBattery();
+    if (probe.full < 0 && probe.level < 0) {
+        error = "No battery at " + BatteryChargeControl::getBasePath();
+        return false;
+    }
+    if (!batteryHistory.open(path)) {
+        error = batteryHistory.errorString();
+        return false;
+    }
+    record();
+    timer.start(interval_s * 1000);
+    return true;
+}
+
+void BatteryHistoryRecorder::stop()
+{
+    timer.stop();
+}
+
+void BatteryHistoryRecorder::record()
+{
+    BatteryHistory::Unit unit;
+    BatteryHistory::Sample sample = BatteryHistory::sampleBattery(&unit);
+    if (!batteryHistory.append(sample, unit)) {
+        error = batteryHistory.errorString();
+    }
+}
@@ -0,0 +1,138 @@
+#ifndef BATTERYHISTORY_H
+#define BATTERYHISTORY_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+
+// Long-term record of the battery's health next to the charge threshold
+// it was kept at, to tell whether the threshold slows the wear.
+//
+// Three tiers: every sample of the last day, hourly averages for the last
+// month and daily averages forever. Each tier is a run of records whose
+// fields are zigzag varint deltas from the previous record, so a sample
+// whose capacity and cycle count did not move takes about seven bytes. The
+// file is a 32-byte header, the daily and hourly runs, then the full
+// resolution run, which new samples are appended to. Once a whole hour
+// has aged out of the day (or a whole day out of the month) it is folded
+// into the next tier and the file, a few kilobytes, is rewritten.
+//
+// Everything is decoded into memory by open(), so queries are binary
+// searches over at most a few thousand samples.
+class BatteryHistory
+{
+public:
+    // Capacities are in mAh, or mWh for batteries that report energy
+    enum class Unit : quint8 { Charge, Energy };
+    enum class Tier { Daily, Hourly, Full };
+
+    // Fields the battery does not report are -1
+    struct Sample
+    {
+        qint64 time = 0;            // seconds since the epoch, UTC
+        int full = -1;              // charge_full or energy_full
+        int design = -1;            // charge_full_design or energy_full_design
+        int cycles = -1;
+        int level = -1;             // capacity, %
+        int threshold = -1;         // charge_control_end_threshold, %
+
+        // full as a percentage of design, or -1
+        double health() const;
+    };
+
+    // A stretch of time spent at one threshold and the wear seen in it
+    struct WearSegment
+    {
+        int threshold = -1;
+        Sample first;
+        Sample last;
+
+        double days() const { return (last.time - first.time) / 86400.0; }
+        // Health points lost per 30 days, and per 100 cycles; 0 when the
+        // stretch is too short to tell
+        double lossPerMonth() const;
+        double lossPer100Cycles() const;
+    };
+
+    static constexpr qint64 full_retention_s = 24 * 3600;
+    static constexpr qint64 hourly_retention_s = 30 * 24 * 3600;
+
+    // Where the daemon records. defaultPath(), which the window and
+    // galaxybook-ctl read, is this file when it exists, else one in the
+    // user's data directory, e.g. for a daemon run with --battery-history.
+    static const char* const system_path;
+    static QString defaultPath();
+
+    BatteryHistory() = default;
+
+    // Loads path, creating it if it does not exist
+    bool open(const QString& path);
+    bool openReadOnly(const QString& path);
+    void close();
+    bool isOpen() const { return !filePath.isEmpty(); }
+    QString errorString() const { return error; }
+    Unit unit() const { return capacityUnit; }
+
+    // Appends sample, which must not be older than the newest one, and
+    // folds aged samples into the coarser tiers. The unit can only change
+    // while the history is empty.
+    bool append(const Sample& sample, Unit unit = Unit::Charge);
+
+    // Samples with from <= time < to, oldest first, each at the finest
+    // resolution still kept
+    QVector<Sample> query(qint64 from, qint64 to) const;
+    int count(Tier tier) const { return tiers[static_cast<int>(tier)].size(); }
+    qint64 fileSize() const { return file_size; }
+
+    // Reads the battery BatteryChargeControl manages, stamped now; unit is
+    // set from the attributes it has
+    static Sample sampleBattery(Unit *unit = nullptr);
+
+    // Splits samples into runs of equal threshold
+    static QVector<WearSegment> wearByThreshold(const QVector<Sample>& samples);
+
+    // The record encoding, exposed for measurements
+    static void encode(QByteArray& out, const Sample& previous, const Sample& sample);
+    static bool decode(const char *&data, const char *end, const Sample& previous, Sample& sample);
+
+private:
+    bool load(bool create);
+    bool compact(qint64 now);
+    bool rewrite();
+
+    QString filePath;
+    bool writable = false;
+    Unit capacityUnit = Unit::Charge;
+    // Indexed by Tier
+    QVector<Sample> tiers[3];
+    qint64 file_size = 0;
+    QString error;
+};
+
+// Appends BatteryHistory::sampleBattery() to a history on a timer
+class BatteryHistoryRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BatteryHistoryRecorder(QObject *parent = nullptr);
+
+    // Samples once now, then every interval_s; false when the interval is
+    // out of range, the history cannot be opened or there is no battery
+    bool start(const QString& path, int interval_s = 600);
+    void stop();
+    bool isRunning() const { return timer.isActive(); }
+    QString errorString() const { return error; }
+
+    void record();
+    const BatteryHistory& history() const { return batteryHistory; }
+
+private:
+    BatteryHistory batteryHistory;
+    QTimer timer;
+    QString error;
+};
+
+#endif // BATTERYHISTORY_H
@@ -0,0 +1,111 @@
+#include "CapabilitySnapshot.h"
+#include "DeviceControls.h"
+#include "SysfsRoot.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <sys/utsname.h>
+
+namespace {
+
+const char header[] = "# galaxybook-control capability snapshot";
+
+QString readLine(QFile& file)
+{
+    QByteArray line = file.readLine();
+    if (line.endsWith('\n')) {
+        line.chop(1);
+    }
+    return QString::fromUtf8(line);
+}
+
+} // namespace
+
+QString CapabilitySnapshot::currentKey()
+{
+    struct utsname name;
+    QString release = ::uname(&name) == 0 ? QString::fromUtf8(name.release) : QString();
+
+    QString product;
+    QFile file(SysfsRoot::path("/sys/class/dmi/id/product_name"));
+    if (file.open(QIODevice::ReadOnly)) {
+        product = QString::fromUtf8(file.readAll()).trimmed();
+    }
+    return release + '\t' + product + '\t' + SysfsRoot::root();
+}
+
+QString CapabilitySnapshot::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/galaxybook-control/capabilities";
+}
+
+CapabilitySnapshot CapabilitySnapshot::probe(DeviceControls& controls)
+{
+    CapabilitySnapshot snapshot;
+    snapshot.key = currentKey();
+    for (const auto& control : controls.all()) {
+        if (!control->isSupported()) {
+            continue;
+        }
+        // Present but unreadable: treat as unsupported, as setup did
+        ControlResult<QString> value = control->tryGet();
+        if (value.ok()) {
+            snapshot.entries.append({control->name(), value.value(), control->describe(), control->displayName()});
+        }
+    }
+    return snapshot;
+}
+
+bool CapabilitySnapshot::load(const QString& path)
+{
+    entries.clear();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    // One control per line: <name>\t<value>\t<description>[\t<display name>]
+    QString current = currentKey();
+    if (readLine(file) != header || readLine(file) != "key\t" + current) {
+        return false;
+    }
+    key = current;
+    while (!file.atEnd()) {
+        QStringList fields = readLine(file).split('\t');
+        if (fields.size() == 3 || fields.size() == 4) {
+            entries.append({fields.at(0), fields.at(1), fields.at(2), fields.value(3, fields.at(0))});
+        }
+    }
+    return true;
+}
+
+bool CapabilitySnapshot::save(const QString& path) const
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    QByteArray content = QByteArray(header) + "\nkey\t" + key.toUtf8() + '\n';
+    for (const Entry& entry : entries) {
+        // Firmware labels are free text; keep them on their own field
+        QString label = entry.display_name;
+        label.replace('\t', ' ').replace('\n', ' ');
+        content += entry.name.toUtf8() + '\t' + entry.value.toUtf8() + '\t' + entry.description.toUtf8() + '\t'
+                 + label.toUtf8() + '\n';
+    }
+    file.write(content);
+    return file.commit();
+}
+
+const CapabilitySnapshot::Entry *CapabilitySnapshot::find(const QString& name) const
+{
+    for (const Entry& entry : entries) {
+        if (entry.name == name) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
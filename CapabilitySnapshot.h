@@ -0,0 +1,49 @@
+#ifndef CAPABILITYSNAPSHOT_H
+#define CAPABILITYSNAPSHOT_H
+
+#include <QString>
+#include <QVector>
+
+class DeviceControls;
+
+// What the window needs for its first paint: every supported control with
+// its value and accepted values. It is cached on disk under a key made of
+// the kernel release and the DMI product name, so a warm start can paint
+// without probing the hardware; the live probe then patches the window.
+class CapabilitySnapshot
+{
+public:
+    struct Entry
+    {
+        QString name;
+        QString value;
+        QString description;    // DeviceControl::describe()
+        QString display_name;   // DeviceControl::displayName()
+
+        bool operator==(const Entry& other) const
+        {
+            return name == other.name && value == other.value && description == other.description
+                && display_name == other.display_name;
+        }
+    };
+
+    // "<kernel release>\t<DMI product name>\t<sysfs root>"
+    static QString currentKey();
+    static QString defaultPath();
+
+    // Reads every supported control; runs on the hardware worker
+    static CapabilitySnapshot probe(DeviceControls& controls);
+
+    // False if the file is missing, unreadable or was taken for another
+    // kernel or machine
+    bool load(const QString& path = defaultPath());
+    bool save(const QString& path = defaultPath()) const;
+
+    const Entry *find(const QString& name) const;
+    bool isEmpty() const { return entries.isEmpty(); }
+
+    QString key;
+    QVector<Entry> entries;
+};
+
+#endif // CAPABILITYSNAPSHOT_H
@@ -0,0 +1,63 @@
+#include "ChangeDispatcher.h"
+#include "SysfsWatcher.h"
+
+ChangeDispatcher::ChangeDispatcher(QObject *parent)
+    : QObject(parent)
+    , fileWatcher(new SysfsWatcher(this))
+{
+    connect(fileWatcher, &SysfsWatcher::fileChanged,
+            this, &ChangeDispatcher::onFileChanged);
+}
+
+ChangeDispatcher::~ChangeDispatcher() = default;
+
+void ChangeDispatcher::watch(const QString& path, Handler handler, const QString& label)
+{
+    if (path.isEmpty()) {
+        return;
+    }
+    Entry entry;
+    entry.handler = std::move(handler);
+#ifdef GALAXYBOOK_TRACE
+    entry.metrics = Metrics::attribute(label.isEmpty() ? path : label);
+#else
+    Q_UNUSED(label);
+#endif
+    handlers.insert(path, std::move(entry));
+    fileWatcher->addPath(path);
+}
+
+void ChangeDispatcher::setCoalescingInterval(int msec)
+{
+    fileWatcher->setCoalescingInterval(msec);
+}
+
+void ChangeDispatcher::unwatch(const QString& path)
+{
+    if (handlers.remove(path) > 0) {
+        fileWatcher->removePath(path);
+    }
+}
+
+QStringList ChangeDispatcher::watchedPaths() const
+{
+    return handlers.keys();
+}
+
+bool ChangeDispatcher::dispatch(const QString& path) const
+{
+    auto it = handlers.constFind(path);
+    if (it == handlers.constEnd()) {
+        return false;
+    }
+    // Handlers must not unwatch their own path while running
+    GALAXYBOOK_TRACE_SCOPE(trace, it.value().metrics, Dispatch);
+    it.value().handler();
+    return true;
+}
+
+void ChangeDispatcher::onFileChanged(const QString &path)
+{
+    // SysfsWatcher follows deleted and recreated files itself
+    dispatch(path);
+}
@@ -0,0 +1,53 @@
+#ifndef CHANGEDISPATCHER_H
+#define CHANGEDISPATCHER_H
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include "Metrics.h"
+
+class SysfsWatcher;
+
+// Routes attribute change notifications to handlers. Each feature registers
+// its monitoring file once together with a pre-bound handler; a notification
+// then costs a single hash lookup instead of re-probing every feature.
+class ChangeDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Handler = std::function<void()>;
+
+    explicit ChangeDispatcher(QObject *parent = nullptr);
+    ~ChangeDispatcher();
+
+    // Starts watching path and calls handler whenever it changes; label
+    // names the path in metrics and defaults to the path itself
+    void watch(const QString& path, Handler handler, const QString& label = QString());
+    void unwatch(const QString& path);
+    QStringList watchedPaths() const;
+
+    // Runs the handler registered for path; false when there is none
+    bool dispatch(const QString& path) const;
+
+    // Changes arriving within msec of each other produce one handler call
+    void setCoalescingInterval(int msec);
+    SysfsWatcher *watcher() const { return fileWatcher; }
+
+private slots:
+    void onFileChanged(const QString &path);
+
+private:
+    struct Entry
+    {
+        Handler handler;
+        Metrics::Attribute *metrics = nullptr;
+    };
+
+    SysfsWatcher *fileWatcher;
+    QHash<QString, Entry> handlers;
+};
+
+#endif // CHANGEDISPATCHER_H
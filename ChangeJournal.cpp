@@ -0,0 +1,338 @@
+#include "ChangeJournal.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+const char* const ChangeJournal::system_path = "/var/lib/galaxybook-control/journal";
+
+namespace {
+
+const char magic[8] = {'G', 'B', 'J', 'R', 'N', 'L', '\0', '\0'};
+constexpr quint32 format_version = 1;
+constexpr size_t header_size = 4096;
+
+const char* const origin_names[] = {"unknown", "app", "client", "hardware", "profile", "governor", "ambient"};
+
+void copyValue(char *target, const QString& value)
+{
+    // Values are ASCII in practice; that path does not allocate
+    size_t length = 0;
+    for (QChar c : value) {
+        if (c.unicode() >= 0x80) {
+            QByteArray bytes = value.toUtf8();
+            length = std::min<size_t>(static_cast<size_t>(bytes.size()), ChangeJournal::value_size);
+            std::memcpy(target, bytes.constData(), length);
+            break;
+        }
+        if (length == ChangeJournal::value_size) {
+            break;
+        }
+        target[length++] = static_cast<char>(c.unicode());
+    }
+    std::memset(target + length, 0, ChangeJournal::value_size - length);
+}
+
+QString valueString(const char *value)
+{
+    return QString::fromUtf8(value, static_cast<int>(strnlen(value, ChangeJournal::value_size)));
+}
+
+} // namespace
+
+struct ChangeJournal::Header
+{
+    char magic[8];
+    quint32 version;
+    quint32 record_size;
+    quint64 capacity;
+    qint64 created_ns;
+    char padding1[32];
+    // On its own cache line: every append writes it
+    quint64 head;
+    char padding2[56];
+    quint32 attribute_count;
+    char padding3[60];
+    char names[max_attributes][name_size];
+};
+
+QString ChangeJournal::Record::oldValue() const
+{
+    return valueString(old_value);
+}
+
+QString ChangeJournal::Record::newValue() const
+{
+    return valueString(new_value);
+}
+
+ChangeJournal::~ChangeJournal()
+{
+    close();
+}
+
+bool ChangeJournal::open(const QString& path, quint64 capacity)
+{
+    close();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    int file = ::open(QFile::encodeName(path).constData(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (file < 0) {
+        error = QString("Cannot open %1: %2").arg(path, strerror(errno));
+        return false;
+    }
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        error = "Journal capacity must be a power of two";
+        ::close(file);
+        return false;
+    }
+    return map(file, true, capacity);
+}
+
+bool ChangeJournal::openReadOnly(const QString& path)
+{
+    close();
+    int file = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+        error = QString("Cannot open %1: %2").arg(path, strerror(errno));
+        return false;
+    }
+    return map(file, false, 0);
+}
+
+bool ChangeJournal::map(int file, bool writable_mapping, quint64 capacity)
+{
+    static_assert(sizeof(Header) <= header_size, "the name table fits the header page");
+
+    // Serializes creation against other processes opening the same file
+    ::flock(file, LOCK_EX);
+    struct stat status;
+    bool ok = ::fstat(file, &status) == 0;
+    bool fresh = ok && status.st_size == 0;
+    if (fresh && !writable_mapping) {
+        error = "Journal is empty";
+        ok = false;
+    }
+    if (ok && fresh) {
+        // Sparse: blocks are allocated as the ring fills
+        ok = ::ftruncate(file, static_cast<off_t>(header_size + capacity * sizeof(Record))) == 0;
+        if (!ok) {
+            error = QString("Cannot size journal: %1").arg(strerror(errno));
+        }
+    } else if (ok) {
+        Header existing;
+        ok = status.st_size >= static_cast<off_t>(header_size)
+          && ::pread(file, &existing, sizeof(existing), 0) == static_cast<ssize_t>(sizeof(existing))
+          && std::memcmp(existing.magic, magic, sizeof(magic)) == 0
+          && existing.version == format_version
+          && existing.record_size == sizeof(Record)
+          && existing.capacity > 0 && (existing.capacity & (existing.capacity - 1)) == 0
+          && static_cast<quint64>(status.st_size) >= header_size + existing.capacity * sizeof(Record);
+        if (!ok) {
+            error = "Not a change journal, or written by an incompatible version";
+        }
+        capacity = existing.capacity;
+    }
+
+    if (ok) {
+        mapped_size = header_size + capacity * sizeof(Record);
+        base = ::mmap(nullptr, mapped_size, writable_mapping ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+        if (base == MAP_FAILED) {
+            base = nullptr;
+            error = QString("Cannot map journal: %1").arg(strerror(errno));
+            ok = false;
+        }
+    }
+    if (ok && fresh) {
+        Header *h = header();
+        std::memcpy(h->magic, magic, sizeof(magic));
+        h->version = format_version;
+        h->record_size = sizeof(Record);
+        h->capacity = capacity;
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        h->created_ns = static_cast<qint64>(now.tv_sec) * 1000000000 + now.tv_nsec;
+    }
+    ::flock(file, LOCK_UN);
+
+    if (!ok) {
+        ::close(file);
+        mapped_size = 0;
+        return false;
+    }
+    fd = file;
+    writable = writable_mapping;
+    return true;
+}
+
+void ChangeJournal::close()
+{
+    if (base) {
+        ::munmap(base, mapped_size);
+        base = nullptr;
+        mapped_size = 0;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    QMutexLocker locker(&idMutex);
+    ids.clear();
+}
+
+ChangeJournal::Header *ChangeJournal::header() const
+{
+    return static_cast<Header *>(base);
+}
+
+ChangeJournal::Record *ChangeJournal::slot(quint64 sequence) const
+{
+    auto *records = reinterpret_cast<Record *>(static_cast<char *>(base) + header_size);
+    return &records[sequence & (header()->capacity - 1)];
+}
+
+int ChangeJournal::attributeId(const QString& name)
+{
+    if (!base) {
+        return -1;
+    }
+    QMutexLocker locker(&idMutex);
+    auto it = ids.constFind(name);
+    if (it != ids.constEnd()) {
+        return it.value();
+    }
+
+    QByteArray bytes = name.toUtf8().left(name_size - 1);
+    Header *h = header();
+    if (writable) {
+        ::flock(fd, LOCK_EX);
+    }
+    int id = -1;
+    quint32 count = std::min<quint32>(__atomic_load_n(&h->attribute_count, __ATOMIC_ACQUIRE), max_attributes);
+    for (quint32 i = 0; i < count; ++i) {
+        if (std::strncmp(h->names[i], bytes.constData(), name_size) == 0) {
+            id = static_cast<int>(i);
+            break;
+        }
+    }
+    if (id < 0 && writable && count < static_cast<quint32>(max_attributes)) {
+        std::memset(h->names[count], 0, name_size);
+        std::memcpy(h->names[count], bytes.constData(), static_cast<size_t>(bytes.size()));
+        __atomic_store_n(&h->attribute_count, count + 1, __ATOMIC_RELEASE);
+        id = static_cast<int>(count);
+    }
+    if (writable) {
+        ::flock(fd, LOCK_UN);
+    }
+    if (id >= 0) {
+        ids.insert(name, id);
+    }
+    return id;
+}
+
+QString ChangeJournal::attributeName(int id) const
+{
+    if (!base || id < 0 || id >= attributeCount()) {
+        return QString();
+    }
+    const char *name = header()->names[id];
+    return QString::fromUtf8(name, static_cast<int>(strnlen(name, name_size)));
+}
+
+int ChangeJournal::attributeCount() const
+{
+    if (!base) {
+        return 0;
+    }
+    return static_cast<int>(std::min<quint32>(__atomic_load_n(&header()->attribute_count, __ATOMIC_ACQUIRE),
+                                              max_attributes));
+}
+
+void ChangeJournal::append(int attribute, const QString& old_value, const QString& new_value, Origin origin, quint32 pid)
+{
+    if (!base || !writable || attribute < 0) {
+        return;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    quint64 sequence = __atomic_fetch_add(&header()->head, 1, __ATOMIC_ACQ_REL);
+    Record *record = slot(sequence);
+    record->timestamp_ns = static_cast<qint64>(now.tv_sec) * 1000000000 + now.tv_nsec;
+    record->attribute = static_cast<quint16>(attribute);
+    record->origin = origin;
+    record->reserved = 0;
+    record->pid = pid;
+    copyValue(record->old_value, old_value);
+    copyValue(record->new_value, new_value);
+    // Publishes the record; readers check it before and after copying
+    __atomic_store_n(&record->sequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+void ChangeJournal::append(const QString& name, const QString& old_value, const QString& new_value, Origin origin, quint32 pid)
+{
+    append(attributeId(name), old_value, new_value, origin, pid);
+}
+
+quint64 ChangeJournal::head() const
+{
+    return base ? __atomic_load_n(&header()->head, __ATOMIC_ACQUIRE) : 0;
+}
+
+quint64 ChangeJournal::capacity() const
+{
+    return base ? header()->capacity : 0;
+}
+
+quint64 ChangeJournal::firstSequence() const
+{
+    quint64 end = head();
+    quint64 size = capacity();
+    return end > size ? end - size : 0;
+}
+
+bool ChangeJournal::read(quint64 sequence, Record& record) const
+{
+    if (!base) {
+        return false;
+    }
+    const Record *source = slot(sequence);
+    if (__atomic_load_n(&source->sequence, __ATOMIC_ACQUIRE) != sequence + 1) {
+        return false;
+    }
+    std::memcpy(&record, source, sizeof(Record));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    // A writer reusing the slot claims its sequence before touching it, so
+    // if the head has not lapped this record the copy is intact
+    return record.sequence == sequence + 1 && head() <= sequence + capacity();
+}
+
+const char* ChangeJournal::originName(Origin origin)
+{
+    int index = static_cast<int>(origin);
+    return index < static_cast<int>(sizeof(origin_names) / sizeof(origin_names[0])) ? origin_names[index] : "unknown";
+}
+
+bool ChangeJournal::parseOrigin(const QString& name, Origin& origin)
+{
+    for (int i = 0; i < static_cast<int>(sizeof(origin_names) / sizeof(origin_names[0])); ++i) {
+        if (name == QLatin1String(origin_names[i])) {
+            origin = static_cast<Origin>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+QString ChangeJournal::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/galaxybook-control/journal";
+}
@@ -0,0 +1,131 @@
+#ifndef CHANGEJOURNAL_H
+#define CHANGEJOURNAL_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QtGlobal>
+#include <algorithm>
+#include <cstddef>
+
+// History of every control value transition, kept in a memory-mapped ring
+// file of fixed-size records so it survives restarts and can be shared by
+// the daemon, the window and the query tool.
+//
+// Appending claims a sequence number with one atomic add on the mapped
+// head, fills the 64-byte record and publishes it with a release store of
+// its sequence: no lock and no syscall (the timestamp comes from the vDSO).
+// Several processes may append to the same file. Once the ring is full the
+// oldest records are overwritten.
+//
+// Layout: a 4 KiB header (magic, geometry, head, attribute name table)
+// followed by capacity records. Attribute names are interned once per file
+// into 16-bit ids under an flock(), so records stay fixed-size.
+class ChangeJournal
+{
+public:
+    enum class Origin : quint8 {
+        Unknown,
+        Application,    // this user's window
+        Client,         // a daemon client; pid is the peer
+        Hardware,       // hotkey or firmware, seen through the watcher
+        Profile,
+        Governor,
+        AmbientLight,   // the ambient light backlight controller
+    };
+
+    static constexpr int value_size = 20;
+    static constexpr int max_attributes = 64;
+    static constexpr int name_size = 32;
+    static constexpr quint64 default_capacity = 1 << 20;
+
+    struct Record
+    {
+        quint64 sequence;       // 1-based; 0 marks a slot never written
+        qint64 timestamp_ns;    // CLOCK_REALTIME
+        quint16 attribute;
+        Origin origin;
+        quint8 reserved;
+        quint32 pid;
+        char old_value[value_size];     // NUL padded, truncated if longer
+        char new_value[value_size];
+
+        QString oldValue() const;
+        QString newValue() const;
+    };
+    static_assert(sizeof(Record) == 64, "records are one cache line");
+
+    ChangeJournal() = default;
+    ~ChangeJournal();
+
+    ChangeJournal(const ChangeJournal&) = delete;
+    ChangeJournal& operator=(const ChangeJournal&) = delete;
+
+    // Creates the file or maps an existing one, keeping its capacity
+    bool open(const QString& path, quint64 capacity = default_capacity);
+    bool openReadOnly(const QString& path);
+    void close();
+    bool isOpen() const { return base != nullptr; }
+    QString errorString() const { return error; }
+
+    // Id of name in this file, registering it if needed; -1 when the table
+    // is full or the journal is read-only and does not know name
+    int attributeId(const QString& name);
+    QString attributeName(int id) const;
+    int attributeCount() const;
+
+    // Lock-free; does nothing when the journal is not open
+    void append(int attribute, const QString& old_value, const QString& new_value, Origin origin, quint32 pid = 0);
+    // Looks the id up first, under a mutex
+    void append(const QString& name, const QString& old_value, const QString& new_value, Origin origin, quint32 pid = 0);
+
+    // Records ever appended; the retained ones are
+    // [max(0, head - capacity), head)
+    quint64 head() const;
+    quint64 capacity() const;
+    quint64 firstSequence() const;
+
+    // Copies record number sequence (0-based); false if it was overwritten
+    // or is still being written
+    bool read(quint64 sequence, Record& record) const;
+
+    // Calls fn(record) for every intact record from sequence from on,
+    // oldest first, and returns the sequence to continue from
+    template <typename Fn>
+    quint64 scan(quint64 from, Fn&& fn) const
+    {
+        quint64 end = head();
+        Record record;
+        for (quint64 sequence = std::max(from, firstSequence()); sequence < end; ++sequence) {
+            if (read(sequence, record)) {
+                fn(record);
+            }
+        }
+        return end;
+    }
+
+    static const char* originName(Origin origin);
+    static bool parseOrigin(const QString& name, Origin& origin);
+
+    // The daemon's journal, and the window's when no daemon runs
+    static const char* const system_path;
+    static QString defaultPath();
+
+private:
+    struct Header;
+
+    bool map(int fd, bool writable, quint64 capacity);
+    Header *header() const;
+    Record *slot(quint64 sequence) const;
+
+    int fd = -1;
+    void *base = nullptr;
+    size_t mapped_size = 0;
+    bool writable = false;
+    QString error;
+    // Name to id, so append(name) does not scan the header table
+    QMutex idMutex;
+    QHash<QString, int> ids;
+};
+
+#endif // CHANGEJOURNAL_H
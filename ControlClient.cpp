@@ -0,0 +1,172 @@
+#include "ControlClient.h"
+#include <QFile>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// "io:16" and the like, as ControlServer puts them before the message
+bool parseStatus(const QByteArray& token, ControlStatus& status)
+{
+    int colon = token.indexOf(':');
+    QByteArray name = colon < 0 ? token : token.left(colon);
+    int error_number = 0;
+    if (colon >= 0) {
+        bool ok = false;
+        error_number = token.mid(colon + 1).toInt(&ok);
+        if (!ok) {
+            return false;
+        }
+    }
+    for (ControlError error : {ControlError::Unsupported, ControlError::InvalidValue, ControlError::OutOfRange,
+                               ControlError::Io}) {
+        if (name == ControlStatus(error).errorName()) {
+            status = ControlStatus(error, error_number);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+ControlClient::~ControlClient()
+{
+    disconnect();
+}
+
+bool ControlClient::connectTo(const QString& socket_path)
+{
+    disconnect();
+
+    QByteArray native = QFile::encodeName(socket_path);
+    struct sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (native.size() >= static_cast<int>(sizeof(address.sun_path))) {
+        error_ = "Socket path is too long";
+        return false;
+    }
+    std::memcpy(address.sun_path, native.constData(), native.size());
+
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0 || ::connect(fd_, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0) {
+        error_ = QString("Cannot connect to %1: %2").arg(socket_path, strerror(errno));
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+void ControlClient::disconnect()
+{
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    buffer_.clear();
+    events_.clear();
+}
+
+bool ControlClient::request(const QByteArray& line, QByteArray& reply, int timeout_ms)
+{
+    status_ = ControlStatus(ControlError::Io, EIO);
+    if (fd_ < 0) {
+        error_ = "Not connected";
+        return false;
+    }
+
+    QByteArray message = line + '\n';
+    const char *data = message.constData();
+    qsizetype remaining = message.size();
+    while (remaining > 0) {
+        ssize_t written = ::send(fd_, data, remaining, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error_ = QString("Cannot send request: %1").arg(strerror(errno));
+            disconnect();
+            return false;
+        }
+        data += written;
+        remaining -= written;
+    }
+
+    QByteArray response;
+    for (;;) {
+        if (!readLine(response, timeout_ms)) {
+            // A late reply would be taken for the next request's
+            disconnect();
+            return false;
+        }
+        if (response.startsWith("event ")) {
+            events_.append(response.mid(6));
+            continue;
+        }
+        break;
+    }
+
+    if (response == "ok" || response.startsWith("ok ")) {
+        reply = response.mid(3);
+        status_ = ControlStatus();
+        return true;
+    }
+    reply = response.startsWith("error ") ? response.mid(6) : response;
+    int space = reply.indexOf(' ');
+    if (space > 0 && parseStatus(reply.left(space), status_)) {
+        reply.remove(0, space + 1);
+    }
+    error_ = QString::fromUtf8(reply);
+    return false;
+}
+
+bool ControlClient::readEvent(QByteArray& event, int timeout_ms)
+{
+    if (!events_.isEmpty()) {
+        event = events_.takeFirst();
+        return true;
+    }
+
+    QByteArray line;
+    while (readLine(line, timeout_ms)) {
+        if (line.startsWith("event ")) {
+            event = line.mid(6);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ControlClient::readLine(QByteArray& line, int timeout_ms)
+{
+    for (;;) {
+        int newline = buffer_.indexOf('\n');
+        if (newline >= 0) {
+            line = buffer_.left(newline);
+            buffer_.remove(0, newline + 1);
+            return true;
+        }
+
+        struct pollfd pfd = {fd_, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, timeout_ms);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            error_ = ready == 0 ? "Timed out waiting for the daemon" : QString(strerror(errno));
+            return false;
+        }
+
+        char chunk[4096];
+        ssize_t length = ::read(fd_, chunk, sizeof(chunk));
+        if (length <= 0) {
+            error_ = "Connection closed by the daemon";
+            return false;
+        }
+        buffer_.append(chunk, length);
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef CONTROLCLIENT_H
+#define CONTROLCLIENT_H
+
+#include "ControlResult.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+// Blocking client for the galaxybook-controld socket (see ControlProtocol).
+// It needs no event loop, so command-line tools can use it directly.
+class ControlClient
+{
+public:
+    ControlClient() = default;
+    ~ControlClient();
+
+    ControlClient(const ControlClient&) = delete;
+    ControlClient& operator=(const ControlClient&) = delete;
+
+    bool connectTo(const QString& socket_path);
+    bool isConnected() const { return fd_ >= 0; }
+    void disconnect();
+
+    // Sends one request line and waits for its reply. On "ok" returns true
+    // with the payload in reply; otherwise returns false with the error
+    // message. Events that arrive first are queued for readEvent(). When
+    // no reply arrives the connection is closed, so isConnected() tells a
+    // refused request from a lost daemon.
+    bool request(const QByteArray& line, QByteArray& reply, int timeout_ms = 5000);
+
+    // Returns the next "event <name> <value>" payload (without the prefix)
+    bool readEvent(QByteArray& event, int timeout_ms = -1);
+
+    QString errorString() const { return error_; }
+    // Why the last request failed: the daemon's category for a control's
+    // failure (see ControlProtocol), else Io
+    ControlStatus status() const { return status_; }
+
+private:
+    bool readLine(QByteArray& line, int timeout_ms);
+
+    int fd_ = -1;
+    QByteArray buffer_;
+    QList<QByteArray> events_;
+    QString error_;
+    ControlStatus status_;
+};
+
+#endif // CONTROLCLIENT_H
@@ -0,0 +1,33 @@
+#include "ControlProtocol.h"
+#include <QDir>
+#include <QFileInfo>
+#include <unistd.h>
+
+QString ControlProtocol::defaultSocketPath()
+{
+    QString path = qEnvironmentVariable("GALAXYBOOK_CONTROL_SOCKET");
+    if (!path.isEmpty()) {
+        return path;
+    }
+    if (geteuid() == 0) {
+        return system_socket_path;
+    }
+    QString runtime = qEnvironmentVariable("XDG_RUNTIME_DIR");
+    if (!runtime.isEmpty()) {
+        return runtime + "/galaxybook-control.sock";
+    }
+    return QDir::tempPath() + QString("/galaxybook-control-%1.sock").arg(getuid());
+}
+
+QString ControlProtocol::clientSocketPath()
+{
+    QString path = qEnvironmentVariable("GALAXYBOOK_CONTROL_SOCKET");
+    if (!path.isEmpty()) {
+        return path;
+    }
+    // The system daemon, so users share the one writer to sysfs
+    if (QFileInfo::exists(system_socket_path)) {
+        return system_socket_path;
+    }
+    return defaultSocketPath();
+}
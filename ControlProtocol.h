@@ -0,0 +1,42 @@
+#ifndef CONTROLPROTOCOL_H
+#define CONTROLPROTOCOL_H
+
+#include <QString>
+
+// Line protocol spoken over the galaxybook-controld Unix socket.
+//
+// Requests, one per line:
+//   ping | list | get <name> | describe <name> | set <name> <value> | subscribe | stats
+//   apply <name>=<value> [<name>=<value>...]    (one transaction, see ProfileApplier)
+// Replies, one line per request, in order:
+//   ok [<payload>] | error <message>
+// A control's failure leads the message with its ControlStatus, e.g.
+//   error io:16 usb_charging: Device or resource busy
+// apply answers "ok <written> <unchanged> <nanoseconds> [<changed name>...]"
+// stats answers "ok own_writes=<n> suppressed_echoes=<n> unchanged=<n> hardware_changes=<n>"
+// After subscribe the daemon also pushes, between replies:
+//   event <name> <value>
+//
+// Deployment: galaxybook-controld runs as root, e.g. from a system service,
+// and listens on system_socket_path with mode 0660 and group socket_group.
+// Desktop users in that group (groupadd -r galaxybook-control; usermod -aG
+// galaxybook-control <user>) reach it from the window and galaxybook-ctl,
+// which then never write sysfs themselves. Without the group only root can
+// connect. A daemon run by a user listens in $XDG_RUNTIME_DIR instead.
+namespace ControlProtocol
+{
+    // Longest accepted request line; longer input drops the connection
+    constexpr int max_line_length = 4096;
+
+    constexpr const char* system_socket_path = "/run/galaxybook-control.sock";
+    constexpr const char* socket_group = "galaxybook-control";
+
+    // Where a daemon listens: $GALAXYBOOK_CONTROL_SOCKET, system_socket_path
+    // for root, else $XDG_RUNTIME_DIR
+    QString defaultSocketPath();
+    // Where clients look: $GALAXYBOOK_CONTROL_SOCKET, system_socket_path
+    // while it exists, else the calling user's defaultSocketPath()
+    QString clientSocketPath();
+}
+
+#endif // CONTROLPROTOCOL_H
@@ -0,0 +1,42 @@
+#include "ControlResult.h"
+#include <cerrno>
+#include <cstring>
+
+ControlStatus ControlStatus::fromErrno()
+{
+    return ControlStatus(ControlError::Io, errno);
+}
+
+const char* ControlStatus::errorName() const
+{
+    switch (error_) {
+    case ControlError::None:
+        return "ok";
+    case ControlError::Unsupported:
+        return "unsupported";
+    case ControlError::InvalidValue:
+        return "invalid";
+    case ControlError::OutOfRange:
+        return "out-of-range";
+    case ControlError::Io:
+        return "io";
+    }
+    return "unknown";
+}
+
+QString ControlStatus::message(const QString& control, const QString& value) const
+{
+    switch (error_) {
+    case ControlError::None:
+        break;
+    case ControlError::Unsupported:
+        return control + " is not supported on this device";
+    case ControlError::InvalidValue:
+        return "Invalid value " + value + " for " + control;
+    case ControlError::OutOfRange:
+        return "Value " + value + " is out of range for " + control;
+    case ControlError::Io:
+        return control + ": " + QString::fromLocal8Bit(strerror(error_number_));
+    }
+    return QString();
+}
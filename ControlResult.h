@@ -0,0 +1,82 @@
+#ifndef CONTROLRESULT_H
+#define CONTROLRESULT_H
+
+#include <QString>
+#include <QtGlobal>
+#include <utility>
+
+// Why a control operation failed, reported by the non-throwing accessors
+enum class ControlError : quint8 {
+    None,
+    Unsupported,    // the device or driver does not provide the control
+    InvalidValue,   // not parseable, or not one of the accepted values
+    OutOfRange,
+    Io,             // the read or write failed; errorNumber() says why
+};
+
+// Outcome of an operation without a value: an error code and, for Io, the
+// errno behind it (EBUSY from a busy EC, ENODEV after an unbind). Eight
+// bytes, returned by value; text is only built when someone asks.
+class ControlStatus
+{
+public:
+    constexpr ControlStatus() = default;
+    constexpr ControlStatus(ControlError error, int error_number = 0)
+        : error_(error)
+        , error_number_(error_number)
+    {
+    }
+
+    // Io with the current errno
+    static ControlStatus fromErrno();
+
+    bool ok() const { return error_ == ControlError::None; }
+    ControlError error() const { return error_; }
+    int errorNumber() const { return error_number_; }
+
+    // "unsupported", "invalid", "out-of-range", "io" or "ok"
+    const char* errorName() const;
+    // For people, e.g. "usb_charging: Device or resource busy"
+    QString message(const QString& control, const QString& value = QString()) const;
+
+private:
+    ControlError error_ = ControlError::None;
+    int error_number_ = 0;
+};
+
+// A value or the status explaining its absence, in the manner of
+// std::expected. Failing costs no unwinding and no allocation.
+template <typename T>
+class ControlResult
+{
+public:
+    ControlResult(T value)
+        : value_(std::move(value))
+    {
+    }
+    ControlResult(ControlStatus status)
+        : status_(status)
+    {
+    }
+    ControlResult(ControlError error)
+        : status_(error)
+    {
+    }
+
+    bool ok() const { return status_.ok(); }
+    explicit operator bool() const { return ok(); }
+
+    // Default-constructed unless ok()
+    const T& value() const { return value_; }
+    T valueOr(T fallback) const { return ok() ? value_ : std::move(fallback); }
+
+    ControlStatus status() const { return status_; }
+    ControlError error() const { return status_.error(); }
+    int errorNumber() const { return status_.errorNumber(); }
+
+private:
+    T value_{};
+    ControlStatus status_;
+};
+
+#endif // CONTROLRESULT_H
@@ -0,0 +1,458 @@
+#include "ControlServer.h"
+#include "ChangeDispatcher.h"
+#include "ControlProtocol.h"
+#include "DeviceControls.h"
+#include "DeviceSupport.h"
+#include "Metrics.h"
+#include "Profiles.h"
+#include "StatePublisher.h"
+#include "SysfsWatcher.h"
+#include <QFile>
+#include <QSocketNotifier>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// A subscriber that stops reading is dropped once this much is queued
+constexpr int max_pending_output = 1 << 20;
+
+QByteArray errorReply(const QString& message)
+{
+    QByteArray text = message.toUtf8();
+    text.replace('\n', ' ');
+    return "error " + text + "\n";
+}
+
+// A control's failure, with its category first so clients can rebuild it
+QByteArray errorReply(ControlStatus status, const QString& message)
+{
+    QByteArray category = status.errorName();
+    if (status.errorNumber() != 0) {
+        category += ':' + QByteArray::number(status.errorNumber());
+    }
+    return errorReply(QString::fromLatin1(category) + ' ' + message);
+}
+
+} // namespace
+
+ControlServer::ControlServer(DeviceControls& controls, QObject *parent)
+    : QObject(parent)
+    , controls(controls)
+{
+}
+
+ControlServer::~ControlServer()
+{
+    close();
+}
+
+void ControlServer::setStatePublisher(StatePublisher *publisher)
+{
+    statePublisher = publisher;
+    if (!statePublisher) {
+        return;
+    }
+    // Values read before, e.g. by listen()
+    for (DeviceControl *control : controls.all()) {
+        if (stateCache.contains(control->name())) {
+            statePublisher->publish(control->name(), stateCache.value(control->name()));
+        }
+    }
+}
+
+bool ControlServer::listen(const QString& socket_path)
+{
+    close();
+
+    QByteArray native = QFile::encodeName(socket_path);
+    struct sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (native.size() >= static_cast<int>(sizeof(address.sun_path))) {
+        error = "Socket path is too long: " + socket_path;
+        return false;
+    }
+    std::memcpy(address.sun_path, native.constData(), native.size());
+
+    // A socket left by a previous run would make bind fail, but one that
+    // still accepts connections belongs to a daemon that is running
+    int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (probe < 0) {
+        error = QString("Cannot create socket: %1").arg(strerror(errno));
+        return false;
+    }
+    int connected = ::connect(probe, reinterpret_cast<struct sockaddr *>(&address), sizeof(address));
+    int connect_error = errno;
+    ::close(probe);
+    if (connected == 0 || connect_error == EAGAIN) {
+        error = "Another galaxybook-controld is already listening on " + socket_path;
+        return false;
+    }
+    if (connect_error == ECONNREFUSED) {
+        ::unlink(native.constData());
+    }
+
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        error = QString("Cannot create socket: %1").arg(strerror(errno));
+        return false;
+    }
+    if (::bind(listen_fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0
+        || ::listen(listen_fd, 64) != 0) {
+        error = QString("Cannot listen on %1: %2").arg(socket_path, strerror(errno));
+        ::close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    // Owner and group only: group membership grants hardware control
+    if (socketGroup != static_cast<gid_t>(-1) && ::chown(native.constData(), static_cast<uid_t>(-1), socketGroup) != 0) {
+        error = QString("Cannot give group %1 access to %2: %3").arg(socketGroup).arg(socket_path, strerror(errno));
+        ::close(listen_fd);
+        listen_fd = -1;
+        ::unlink(native.constData());
+        return false;
+    }
+    ::chmod(native.constData(), 0660);
+    socketPath = socket_path;
+
+    acceptNotifier = new QSocketNotifier(listen_fd, QSocketNotifier::Read, this);
+    connect(acceptNotifier, &QSocketNotifier::activated, this, &ControlServer::onNewConnection);
+
+    changeDispatcher = new ChangeDispatcher(this);
+    for (DeviceControl *control : controls.all()) {
+        if (control->isSupported()) {
+            watchControl(control);
+        }
+    }
+    return true;
+}
+
+void ControlServer::watchControl(DeviceControl *control)
+{
+    QString name = control->name();
+    // Otherwise compared against the first value read
+    ControlResult<QString> current = control->tryGet();
+    if (current.ok()) {
+        stateCache.prime(name, current.value(), control->notifiesOwnWrites());
+        if (statePublisher) {
+            statePublisher->publish(name, current.value());
+        }
+    }
+    changeDispatcher->watch(control->monitoringFilePath(), [this, name] { broadcastChange(name); }, name);
+}
+
+void ControlServer::refreshDevices()
+{
+    DeviceSupport::refresh();
+    controls.rescan();
+    if (!changeDispatcher) {
+        return;
+    }
+
+    // Descriptors held across a driver reload point at dead nodes
+    changeDispatcher->watcher()->rearm();
+    const QStringList watched = changeDispatcher->watchedPaths();
+    for (DeviceControl *control : controls.all()) {
+        if (!control->isSupported()) {
+            continue;
+        }
+        if (!watched.contains(control->monitoringFilePath())) {
+            watchControl(control);
+            if (stateCache.contains(control->name())) {
+                broadcastEvent(control->name(), stateCache.value(control->name()));
+            }
+        } else {
+            // The value may have been reset while the device was gone
+            broadcastChange(control->name());
+        }
+    }
+}
+
+void ControlServer::close()
+{
+    while (!clients.empty()) {
+        drop(clients.back().get());
+    }
+    delete acceptNotifier;
+    acceptNotifier = nullptr;
+    delete changeDispatcher;
+    changeDispatcher = nullptr;
+    if (listen_fd >= 0) {
+        ::close(listen_fd);
+        listen_fd = -1;
+        ::unlink(QFile::encodeName(socketPath).constData());
+    }
+}
+
+void ControlServer::onNewConnection()
+{
+    for (;;) {
+        int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+
+        auto client = std::make_unique<Client>();
+        Client *raw = client.get();
+        raw->fd = fd;
+        // For the journal: which process made a change
+        struct ucred credentials = {};
+        socklen_t length = sizeof(credentials);
+        if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) == 0) {
+            raw->pid = static_cast<quint32>(credentials.pid);
+        }
+        raw->reader = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+        raw->writer = new QSocketNotifier(fd, QSocketNotifier::Write, this);
+        raw->writer->setEnabled(false);
+        connect(raw->reader, &QSocketNotifier::activated, this, [this, raw] { onReadable(raw); });
+        connect(raw->writer, &QSocketNotifier::activated, this, [this, raw] { onWritable(raw); });
+        clients.push_back(std::move(client));
+    }
+}
+
+void ControlServer::onReadable(Client *client)
+{
+    char buffer[4096];
+    for (;;) {
+        ssize_t length = ::read(client->fd, buffer, sizeof(buffer));
+        if (length == 0 || (length < 0 && errno != EAGAIN && errno != EINTR)) {
+            drop(client);
+            return;
+        }
+        if (length < 0) {
+            break;
+        }
+        client->input.append(buffer, length);
+    }
+
+    // Answer every complete line, batching the replies into one write
+    QByteArray replies;
+    int start = 0;
+    int end;
+    while ((end = client->input.indexOf('\n', start)) >= 0) {
+        replies += handleRequest(client->input.mid(start, end - start).trimmed(), client);
+        start = end + 1;
+    }
+    client->input.remove(0, start);
+    if (client->input.size() > ControlProtocol::max_line_length) {
+        drop(client);
+    } else if (!replies.isEmpty()) {
+        send(client, replies);
+    }
+
+    // Only now that client is no longer used: sending an event may drop
+    // any subscriber, this one included
+    std::vector<std::pair<QString, QString>> events;
+    events.swap(requestEvents);
+    for (const auto& event : events) {
+        broadcastEvent(event.first, event.second);
+    }
+}
+
+QByteArray ControlServer::handleRequest(const QByteArray& line, Client *client)
+{
+    int space = line.indexOf(' ');
+    QByteArray command = space < 0 ? line : line.left(space);
+    QString arguments = space < 0 ? QString() : QString::fromUtf8(line.mid(space + 1)).trimmed();
+
+    if (command == "ping") {
+        return "ok pong\n";
+    }
+    if (command == "list") {
+        QStringList names;
+        for (const auto& control : controls.all()) {
+            if (control->isSupported()) {
+                names << control->name();
+            }
+        }
+        return "ok " + names.join(' ').toUtf8() + "\n";
+    }
+    if (command == "stats") {
+        const StateCache::Counters& counters = stateCache.counters();
+        return QString("ok own_writes=%1 suppressed_echoes=%2 unchanged=%3 hardware_changes=%4\n")
+            .arg(counters.own_writes)
+            .arg(counters.suppressed_echoes)
+            .arg(counters.unchanged_notifications)
+            .arg(counters.hardware_changes)
+            .toUtf8();
+    }
+    if (command == "subscribe") {
+        client->subscribed = true;
+        return "ok\n";
+    }
+    if (command == "apply") {
+        Profile profile;
+        for (const QString& field : arguments.split(' ', Qt::SkipEmptyParts)) {
+            int equals = field.indexOf('=');
+            if (equals <= 0) {
+                return errorReply("Invalid setting " + field);
+            }
+            profile.settings.append({field.left(equals), field.mid(equals + 1)});
+        }
+        QHash<QString, QString> previous;
+        for (const auto& setting : profile.settings) {
+            previous.insert(setting.first, stateCache.value(setting.first));
+        }
+        ProfileApplier applier(controls);
+        applier.setStateCache(&stateCache);
+        ProfileApplier::Result result = applier.apply(profile);
+        if (!result.ok) {
+            return errorReply(result.error);
+        }
+        for (const QString& name : result.changed_controls) {
+            if (changeJournal) {
+                changeJournal->append(name, previous.value(name), stateCache.value(name),
+                                      ChangeJournal::Origin::Profile, client->pid);
+            }
+            requestEvents.emplace_back(name, stateCache.value(name));
+        }
+        return QString("ok %1 %2 %3 %4")
+                   .arg(result.written)
+                   .arg(result.unchanged)
+                   .arg(result.total_ns)
+                   .arg(result.changed_controls.join(' '))
+                   .trimmed()
+                   .toUtf8()
+               + "\n";
+    }
+
+    QString name = arguments.section(' ', 0, 0);
+    DeviceControl *control = controls.find(name);
+    if (command != "get" && command != "set" && command != "describe") {
+        return errorReply("Unknown command " + QString::fromUtf8(command));
+    }
+    if (!control) {
+        return errorReply("Unknown control " + name);
+    }
+
+    if (command == "get") {
+        ControlResult<QString> result = control->tryGet();
+        if (!result.ok()) {
+            return errorReply(result.status(), control->failureMessage(result.status()));
+        }
+        return "ok " + result.value().toUtf8() + "\n";
+    }
+    if (command == "describe") {
+        return "ok " + control->describe().toUtf8() + "\n";
+    }
+    QString value = arguments.section(' ', 1).trimmed();
+    ControlStatus status = control->trySet(value);
+    if (!status.ok()) {
+        return errorReply(status, control->failureMessage(status, value));
+    }
+    if (changeJournal) {
+        changeJournal->append(name, stateCache.value(name), value, ChangeJournal::Origin::Client, client->pid);
+    }
+    // Tell subscribers after this request; the watcher's echo reads back
+    // the same value
+    stateCache.recordWrite(name, value);
+    requestEvents.emplace_back(name, value);
+    return "ok\n";
+}
+
+void ControlServer::send(Client *client, const QByteArray& data)
+{
+    client->output += data;
+    onWritable(client);
+}
+
+void ControlServer::onWritable(Client *client)
+{
+    while (!client->output.isEmpty()) {
+        ssize_t written = ::send(client->fd, client->output.constData(), client->output.size(), MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                break;
+            }
+            drop(client);
+            return;
+        }
+        client->output.remove(0, written);
+    }
+
+    if (client->output.size() > max_pending_output) {
+        drop(client);
+        return;
+    }
+    client->writer->setEnabled(!client->output.isEmpty());
+}
+
+void ControlServer::drop(Client *client)
+{
+    auto it = std::find_if(clients.begin(), clients.end(),
+                           [client](const std::unique_ptr<Client>& c) { return c.get() == client; });
+    if (it == clients.end()) {
+        return;
+    }
+    // Notifiers may be the sender of the slot running right now
+    client->reader->setEnabled(false);
+    client->writer->setEnabled(false);
+    client->reader->deleteLater();
+    client->writer->deleteLater();
+    ::close(client->fd);
+    clients.erase(it);
+}
+
+void ControlServer::broadcastChange(const QString& name)
+{
+    DeviceControl *control = controls.find(name);
+    if (!control) {
+        return;
+    }
+
+    GALAXYBOOK_TRACE_EVENT(Metrics::attribute(name), Notification);
+    // Always read: a change from elsewhere may arrive with, or instead of,
+    // the echo of our own write
+    ControlResult<QString> result = control->tryGet();
+    if (!result.ok()) {
+        return;
+    }
+    const QString& value = result.value();
+    QString previous = stateCache.value(name);
+    bool echo = false;
+    if (stateCache.update(name, value, &echo)) {
+        GALAXYBOOK_TRACE_EVENT(Metrics::attribute(name), HardwareChange);
+        if (changeJournal) {
+            changeJournal->append(name, previous, value, ChangeJournal::Origin::Hardware);
+        }
+        broadcastEvent(name, value);
+    } else if (echo) {
+        GALAXYBOOK_TRACE_EVENT(Metrics::attribute(name), EchoSuppressed);
+    }
+}
+
+void ControlServer::noteWrite(const QString& name, const QString& value, ChangeJournal::Origin origin)
+{
+    if (changeJournal) {
+        changeJournal->append(name, stateCache.value(name), value, origin, static_cast<quint32>(::getpid()));
+    }
+    stateCache.recordWrite(name, value);
+    broadcastEvent(name, value);
+}
+
+void ControlServer::broadcastEvent(const QString& name, const QString& value)
+{
+    if (statePublisher) {
+        statePublisher->publish(name, value);
+    }
+    QByteArray event = "event " + name.toUtf8() + " " + value.toUtf8() + "\n";
+
+    // Collect first: send() may drop a client and modify the list
+    std::vector<Client *> subscribers;
+    for (const auto& client : clients) {
+        if (client->subscribed) {
+            subscribers.push_back(client.get());
+        }
+    }
+    for (Client *client : subscribers) {
+        if (std::any_of(clients.begin(), clients.end(),
+                        [client](const std::unique_ptr<Client>& c) { return c.get() == client; })) {
+            send(client, event);
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <memory>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+#include "ChangeJournal.h"
+#include "StateCache.h"
+
+class ChangeDispatcher;
+class DeviceControl;
+class DeviceControls;
+class QSocketNotifier;
+class StatePublisher;
+
+// Serves DeviceControls over a Unix domain socket using ControlProtocol.
+// It is the single writer to sysfs: clients never touch the attributes
+// themselves, and subscribers are told about every change, whether it was
+// made through the socket or by the hardware. Every notification is read;
+// the echo of our own write reads back the cached value and is not
+// announced again.
+class ControlServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ControlServer(DeviceControls& controls, QObject *parent = nullptr);
+    ~ControlServer();
+
+    // Group given access to the socket by listen(); by default only the
+    // owner's primary group has it
+    void setSocketGroup(gid_t group) { socketGroup = group; }
+    // Creates the socket and the watcher in the calling thread
+    Q_INVOKABLE bool listen(const QString& socket_path);
+    Q_INVOKABLE void close();
+
+    // After devices were added or removed: refreshes the support flags,
+    // picks up new controls and tells subscribers about values that appeared
+    Q_INVOKABLE void refreshDevices();
+
+    // Records every value transition, with who made it; not owned
+    void setJournal(ChangeJournal *journal) { changeJournal = journal; }
+    // Mirrors every value into a shared-memory snapshot, starting with the
+    // ones already known; not owned
+    void setStatePublisher(StatePublisher *publisher);
+    // A write made in this process without going through the socket, e.g.
+    // by the governor, after it succeeded: subscribers hear of it now and
+    // its echo is not announced again
+    void noteWrite(const QString& name, const QString& value, ChangeJournal::Origin origin);
+
+    QString errorString() const { return error; }
+    int clientCount() const { return static_cast<int>(clients.size()); }
+    const StateCache& cache() const { return stateCache; }
+
+private:
+    struct Client
+    {
+        int fd = -1;
+        QSocketNotifier *reader = nullptr;
+        QSocketNotifier *writer = nullptr;
+        QByteArray input;
+        QByteArray output;
+        bool subscribed = false;
+        quint32 pid = 0;
+
+    };
+
+    void onNewConnection();
+    void onReadable(Client *client);
+    void onWritable(Client *client);
+    QByteArray handleRequest(const QByteArray& line, Client *client);
+    void send(Client *client, const QByteArray& data);
+    void drop(Client *client);
+    void watchControl(DeviceControl *control);
+    void broadcastChange(const QString& name);
+    void broadcastEvent(const QString& name, const QString& value);
+
+    DeviceControls& controls;
+    ChangeDispatcher *changeDispatcher = nullptr;
+    StateCache stateCache;
+    ChangeJournal *changeJournal = nullptr;
+    StatePublisher *statePublisher = nullptr;
+    int listen_fd = -1;
+    QSocketNotifier *acceptNotifier = nullptr;
+    QString socketPath;
+    gid_t socketGroup = static_cast<gid_t>(-1);
+    QString error;
+    std::vector<std::unique_ptr<Client>> clients;
+    // Changes made by the requests being handled; broadcast once the
+    // requesting client is no longer touched
+    std::vector<std::pair<QString, QString>> requestEvents;
+};
+
+#endif // CONTROLSERVER_H
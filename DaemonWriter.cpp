@@ -0,0 +1,106 @@
+#include "DaemonWriter.h"
+#include "DeviceControls.h"
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QMutexLocker>
+
+namespace {
+
+// Longer than any single sysfs write the daemon makes
+constexpr int request_timeout_ms = 2000;
+constexpr int retry_interval_ms = 1000;
+
+} // namespace
+
+DaemonWriter::DaemonWriter(const QString& socket_path)
+    : socketPath(socket_path)
+{
+}
+
+DaemonWriter::~DaemonWriter() = default;
+
+std::unique_ptr<ControlClient> DaemonWriter::take()
+{
+    QMutexLocker locker(&mutex);
+    if (!idle.empty()) {
+        std::unique_ptr<ControlClient> client = std::move(idle.back());
+        idle.pop_back();
+        return client;
+    }
+    qint64 now = QDeadlineTimer::current().deadline();
+    if (now < retry_after_ms) {
+        return nullptr;
+    }
+    // A local connect, quick enough to make under the lock
+    auto client = std::make_unique<ControlClient>();
+    if (client->connectTo(socketPath)) {
+        return client;
+    }
+    retry_after_ms = now + retry_interval_ms;
+    return nullptr;
+}
+
+void DaemonWriter::giveBack(std::unique_ptr<ControlClient> client)
+{
+    if (!client->isConnected()) {
+        return;
+    }
+    QMutexLocker locker(&mutex);
+    idle.push_back(std::move(client));
+}
+
+ControlStatus DaemonWriter::set(DeviceControl *control, const QString& value, const std::function<ControlStatus()>& direct)
+{
+    if (!control->isValid(value)) {
+        return ControlError::InvalidValue;
+    }
+    if (std::unique_ptr<ControlClient> client = take()) {
+        QByteArray reply;
+        bool ok = client->request("set " + control->name().toUtf8() + ' ' + value.trimmed().toUtf8(), reply,
+                                  request_timeout_ms);
+        ControlStatus status = client->status();
+        bool refused = !ok && client->isConnected();
+        if (refused) {
+            qDebug() << "galaxybook-controld refused" << control->name() << value << ":" << client->errorString();
+        }
+        giveBack(std::move(client));
+        if (ok || refused) {
+            return status;
+        }
+        // The daemon went away; whether it wrote or not, writing again is harmless
+    }
+    return direct ? direct() : control->trySet(value);
+}
+
+ProfileApplier::Result DaemonWriter::apply(const Profile& profile, DeviceControls& controls)
+{
+    if (std::unique_ptr<ControlClient> client = take()) {
+        QByteArray request = "apply";
+        for (const auto& setting : profile.settings) {
+            request += ' ' + setting.first.toUtf8() + '=' + setting.second.trimmed().toUtf8();
+        }
+
+        ProfileApplier::Result result;
+        QByteArray reply;
+        bool ok = client->request(request, reply, request_timeout_ms);
+        bool refused = !ok && client->isConnected();
+        if (ok) {
+            // The daemon names what it changed, within the same transaction
+            QList<QByteArray> fields = reply.split(' ');
+            result.ok = true;
+            result.written = fields.value(0).toInt();
+            result.unchanged = fields.value(1).toInt();
+            result.total_ns = fields.value(2).toLongLong();
+            for (int i = 3; i < fields.size(); ++i) {
+                result.changed_controls << QString::fromUtf8(fields.at(i));
+            }
+        } else if (refused) {
+            result.error = client->errorString();
+        }
+        giveBack(std::move(client));
+        if (ok || refused) {
+            return result;
+        }
+    }
+    return ProfileApplier(controls).apply(profile);
+}
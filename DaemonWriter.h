@@ -0,0 +1,50 @@
+#ifndef DAEMONWRITER_H
+#define DAEMONWRITER_H
+
+#include "ControlClient.h"
+#include "ControlProtocol.h"
+#include "ControlResult.h"
+#include "Profiles.h"
+
+#include <QMutex>
+#include <QString>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class DeviceControl;
+
+// Sends the window's writes through galaxybook-controld while it runs, so
+// the daemon stays the only process writing sysfs and its clients,
+// journal and state segment see every change. Without a daemon, or when
+// it goes away mid-request, the write is made directly as before. Each
+// request borrows a connection of its own, so the HardwareWorker lanes
+// wait on the daemon in parallel; a missing daemon is looked for again at
+// most once a second.
+class DaemonWriter
+{
+public:
+    explicit DaemonWriter(const QString& socket_path = ControlProtocol::clientSocketPath());
+    ~DaemonWriter();
+
+    // Validated here first, so a bad value is refused with the same status
+    // either way; a refusal by the daemon keeps its category. direct
+    // defaults to control->trySet(value).
+    ControlStatus set(DeviceControl *control, const QString& value, const std::function<ControlStatus()>& direct = {});
+
+    // Through the daemon's apply, or a local ProfileApplier
+    ProfileApplier::Result apply(const Profile& profile, DeviceControls& controls);
+
+private:
+    // An idle connection, or a new one; null while no daemon answers
+    std::unique_ptr<ControlClient> take();
+    // Kept for the next request unless the daemon went away
+    void giveBack(std::unique_ptr<ControlClient> client);
+
+    const QString socketPath;
+    QMutex mutex;
+    std::vector<std::unique_ptr<ControlClient>> idle;
+    qint64 retry_after_ms = 0;
+};
+
+#endif // DAEMONWRITER_H
@@ -0,0 +1,262 @@
+#include "DeviceControls.h"
+#include "AttributeTable.h"
+#include "FirmwareAttribute.h"
+#include "UnsupportedFeatureException.h"
+#include <utility>
+
+const char* const DeviceControls::keyboard_backlight = "keyboard_backlight";
+const char* const DeviceControls::performance_mode = "performance_mode";
+const char* const DeviceControls::charge_end_threshold = "charge_end_threshold";
+
+namespace {
+
+bool reject(QString *reason, const QString& message)
+{
+    if (reason) {
+        *reason = message;
+    }
+    return false;
+}
+
+bool parseInteger(const QString& value, int& result)
+{
+    bool ok = false;
+    result = value.trimmed().toInt(&ok);
+    return ok;
+}
+
+// A control for an exposed AttributeTable row
+template <int id>
+class TableControl : public DeviceControl
+{
+public:
+    QString name() const override { return QLatin1String(AttributeTable::rows[id].name); }
+    bool isSupported() const override { return AttributeTable::isSupported<id>(); }
+
+    ControlResult<QString> tryGet() const override
+    {
+        if constexpr (AttributeTable::rows[id].type == AttributeTable::Type::Integer) {
+            ControlResult<int> result = AttributeTable::tryGet<id>();
+            if (!result.ok()) {
+                return result.status();
+            }
+            return QString::number(result.value());
+        } else {
+            return AttributeTable::tryGet<id>();
+        }
+    }
+
+    ControlStatus trySet(const QString& value) override
+    {
+        if constexpr (AttributeTable::rows[id].type == AttributeTable::Type::Integer) {
+            int number;
+            if (!parseInteger(value, number)) {
+                return ControlError::InvalidValue;
+            }
+            return AttributeTable::trySet<id>(number);
+        } else {
+            return AttributeTable::trySet<id>(value.trimmed());
+        }
+    }
+
+    bool isValid(const QString& value, QString *reason) const override
+    {
+        if constexpr (AttributeTable::rows[id].type == AttributeTable::Type::Integer) {
+            bool ok = false;
+            int number = value.trimmed().toInt(&ok);
+            if (!ok) {
+                return reject(reason, "Invalid value " + value + " for " + name());
+            }
+            if (!AttributeTable::isValid<id>(number)) {
+                return reject(reason, AttributeTable::outOfRangeMessage(id, AttributeTable::rows[id].minimum,
+                                                                        AttributeTable::maximum<id>()));
+            }
+        } else if (!AttributeTable::isValid<id>(value.trimmed())) {
+            return reject(reason, AttributeTable::invalidMessage(id, value));
+        }
+        return true;
+    }
+
+    QString describe() const override { return AttributeTable::describe<id>(); }
+    QString monitoringFilePath() const override { return AttributeTable::monitoringPath<id>(); }
+    bool notifiesOwnWrites() const override { return AttributeTable::notifiesOwnWrites<id>(); }
+    // The limit and choices rows are cached until the driver is reloaded
+    void reload() override { AttributeTable::invalidate(); }
+};
+
+template <int id>
+void addTableControl(std::vector<std::unique_ptr<DeviceControl>>& controls)
+{
+    if constexpr (AttributeTable::rows[id].exposed) {
+        controls.push_back(std::make_unique<TableControl<id>>());
+    }
+}
+
+template <int... ids>
+void addTableControls(std::vector<std::unique_ptr<DeviceControl>>& controls, std::integer_sequence<int, ids...>)
+{
+    (addTableControl<ids>(controls), ...);
+}
+
+class FirmwareAttributeControl : public DeviceControl
+{
+public:
+    explicit FirmwareAttributeControl(const FirmwareAttribute& attribute) : attribute(attribute) {}
+
+    QString name() const override { return attribute.getAttributeName(); }
+
+    QString displayName() const override
+    {
+        QString label = attribute.getMetadata()->display_name;
+        return label.isEmpty() ? name() : label;
+    }
+
+    bool isSupported() const override { return attribute.isSupported(); }
+    ControlResult<QString> tryGet() const override
+    {
+        ControlResult<int> result = attribute.tryGet();
+        if (!result.ok()) {
+            return result.status();
+        }
+        return QString::number(result.value());
+    }
+
+    ControlStatus trySet(const QString& value) override
+    {
+        int number;
+        if (!parseInteger(value, number)) {
+            return ControlError::InvalidValue;
+        }
+        return attribute.trySet(number);
+    }
+
+    bool isValid(const QString& value, QString *reason) const override
+    {
+        bool ok = false;
+        int number = value.trimmed().toInt(&ok);
+        if (!ok || !attribute.isValidValue(number)) {
+            return reject(reason, "Invalid value " + value + " for " + name());
+        }
+        return true;
+    }
+
+    // "0 1" for enumerations, "min..max" for integers
+    QString describe() const override
+    {
+        std::shared_ptr<const FirmwareAttribute::Metadata> metadata = attribute.getMetadata();
+        if (metadata->type == FirmwareAttribute::Metadata::Type::Integer) {
+            return QString("%1..%2").arg(metadata->min_value).arg(metadata->max_value);
+        }
+        QStringList values;
+        for (int value : metadata->possible_values) {
+            values << QString::number(value);
+        }
+        return values.join(' ');
+    }
+
+    QString monitoringFilePath() const override { return attribute.getMonitoringFilePath(); }
+    void reload() override { attribute.reloadMetadata(); }
+
+private:
+    FirmwareAttribute attribute;
+};
+
+} // namespace
+
+QString DeviceControl::get() const
+{
+    ControlResult<QString> result = tryGet();
+    if (!result.ok()) {
+        throw UnsupportedFeatureException(failureMessage(result.status()));
+    }
+    return result.value();
+}
+
+void DeviceControl::set(const QString& value)
+{
+    ControlStatus status = trySet(value);
+    if (!status.ok()) {
+        throw UnsupportedFeatureException(failureMessage(status, value));
+    }
+}
+
+QString DeviceControl::failureMessage(ControlStatus status, const QString& value) const
+{
+    QString message = status.message(name(), value);
+    if (status.error() == ControlError::InvalidValue || status.error() == ControlError::OutOfRange) {
+        message += ", expected " + describe();
+    }
+    return message;
+}
+
+DeviceControls::DeviceControls()
+{
+    addTableControls(controls, std::make_integer_sequence<int, AttributeTable::count>());
+}
+
+DeviceControls::~DeviceControls() = default;
+
+void DeviceControls::discover() const
+{
+    std::call_once(discovered, [this] {
+        QVector<FirmwareAttribute> attributes = FirmwareAttribute::discover();
+        QMutexLocker locker(&mutex);
+        for (const auto& control : controls) {
+            byName.insert(control->name(), control.get());
+        }
+        adopt(attributes);
+    });
+}
+
+int DeviceControls::adopt(const QVector<FirmwareAttribute>& attributes) const
+{
+    int added = 0;
+    for (const FirmwareAttribute& attribute : attributes) {
+        if (!byName.contains(attribute.getAttributeName())) {
+            controls.push_back(std::make_unique<FirmwareAttributeControl>(attribute));
+            byName.insert(attribute.getAttributeName(), controls.back().get());
+            ++added;
+        }
+    }
+    return added;
+}
+
+int DeviceControls::rescan()
+{
+    // Scanned and reloaded outside the lock so lookups are not held up by
+    // sysfs; controls are never removed, so the pointers stay valid
+    for (DeviceControl *control : all()) {
+        control->reload();
+    }
+    QVector<FirmwareAttribute> attributes = FirmwareAttribute::discover();
+    QMutexLocker locker(&mutex);
+    return adopt(attributes);
+}
+
+std::vector<DeviceControl*> DeviceControls::all() const
+{
+    discover();
+    QMutexLocker locker(&mutex);
+    std::vector<DeviceControl*> result;
+    result.reserve(controls.size());
+    for (const auto& control : controls) {
+        result.push_back(control.get());
+    }
+    return result;
+}
+
+DeviceControl* DeviceControls::find(const QString& name) const
+{
+    discover();
+    QMutexLocker locker(&mutex);
+    return byName.value(name, nullptr);
+}
+
+QStringList DeviceControls::names() const
+{
+    QStringList result;
+    for (const auto& control : all()) {
+        result << control->name();
+    }
+    return result;
+}
@@ -0,0 +1,89 @@
+#ifndef DEVICECONTROLS_H
+#define DEVICECONTROLS_H
+
+#include "ControlResult.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class FirmwareAttribute;
+
+// One hardware setting addressed by name with string values, so the
+// daemon, the command-line tool and profiles can treat every feature class
+// the same way. tryGet() and trySet() report failures as a ControlResult,
+// which is what polling, watching and profile application use; get() and
+// set() throw UnsupportedFeatureException with the same information.
+class DeviceControl
+{
+public:
+    virtual ~DeviceControl() = default;
+
+    virtual QString name() const = 0;
+    // Label for the user interface
+    virtual QString displayName() const { return name(); }
+    virtual bool isSupported() const = 0;
+    virtual ControlResult<QString> tryGet() const = 0;
+    virtual ControlStatus trySet(const QString& value) = 0;
+    QString get() const;
+    void set(const QString& value);
+    // Text for a failed tryGet() or trySet(value), naming the accepted values
+    QString failureMessage(ControlStatus status, const QString& value = QString()) const;
+    // Checks a value without writing it, from cached metadata where possible
+    virtual bool isValid(const QString& value, QString *reason = nullptr) const = 0;
+    // Accepted values, e.g. "0..3" or "low-power quiet balanced performance"
+    virtual QString describe() const = 0;
+    virtual QString monitoringFilePath() const = 0;
+    // Whether our own set() shows up on monitoringFilePath() as a change
+    virtual bool notifiesOwnWrites() const { return true; }
+    // Drops cached metadata after the device was added or removed
+    virtual void reload() {}
+};
+
+// Every control this device may offer: the AttributeTable rows first,
+// then every firmware attribute the driver exposes, sorted by name. The
+// attributes directory is scanned on first use; rescan() appends what
+// appeared since. Controls are never removed, so pointers stay valid for
+// the lifetime of the object; one whose device went away reports
+// isSupported() false.
+class DeviceControls
+{
+public:
+    static const char* const keyboard_backlight;
+    static const char* const performance_mode;
+    static const char* const charge_end_threshold;
+
+    DeviceControls();
+    ~DeviceControls();
+
+    DeviceControls(const DeviceControls&) = delete;
+    DeviceControls& operator=(const DeviceControls&) = delete;
+
+    // A copy, so a rescan on another thread cannot invalidate the iteration
+    std::vector<DeviceControl*> all() const;
+    DeviceControl* find(const QString& name) const;
+    QStringList names() const;
+
+    // Re-reads every control's metadata and adds firmware attributes that
+    // appeared since the last scan, e.g. because the driver loaded late.
+    // Returns the number of controls added. Callers keep it from running
+    // alongside reads or writes of the controls, which use the metadata.
+    int rescan();
+
+private:
+    void discover() const;
+    // Adds attributes not yet known; mutex must be held
+    int adopt(const QVector<FirmwareAttribute>& attributes) const;
+
+    mutable std::once_flag discovered;
+    mutable QMutex mutex;
+    mutable std::vector<std::unique_ptr<DeviceControl>> controls;
+    mutable QHash<QString, DeviceControl*> byName;
+};
+
+#endif // DEVICECONTROLS_H
@@ -0,0 +1,76 @@
+#include "DeviceSupport.h"
+#include "BatteryChargeControl.h"
+#include "FirmwareAttribute.h"
+#include "KeyboardBacklight.h"
+#include "PerformanceMode.h"
+#include <QFile>
+#include <unistd.h>
+
+std::atomic<int> DeviceSupport::states[DeviceSupport::feature_count] = {{-1}, {-1}, {-1}, {-1}, {-1}};
+std::atomic<quint64> DeviceSupport::changes{0};
+
+bool DeviceSupport::probe(Feature feature)
+{
+    QString path;
+    switch (feature) {
+    case Feature::KeyboardBacklight:
+        path = KeyboardBacklight::getBrightnessFilePath();
+        break;
+    case Feature::KeyboardBacklightHwChanged:
+        path = KeyboardBacklight::getHwChangedFilePath();
+        break;
+    case Feature::PerformanceMode:
+        path = PerformanceMode::getMonitoringFilePath();
+        break;
+    case Feature::BatteryChargeControl:
+        path = BatteryChargeControl::getMonitoringFilePath();
+        break;
+    case Feature::FirmwareAttributes:
+        path = FirmwareAttribute::getBasePath();
+        break;
+    }
+    return ::access(QFile::encodeName(path).constData(), F_OK) == 0;
+}
+
+bool DeviceSupport::isPresent(Feature feature)
+{
+    std::atomic<int>& state = states[static_cast<int>(feature)];
+    int present = state.load(std::memory_order_acquire);
+    if (Q_UNLIKELY(present < 0)) {
+        // Racing first probes agree, so whichever store lands is fine
+        present = probe(feature) ? 1 : 0;
+        state.store(present, std::memory_order_release);
+    }
+    return present == 1;
+}
+
+bool DeviceSupport::refresh()
+{
+    bool changed = false;
+    for (int i = 0; i < feature_count; ++i) {
+        int present = probe(static_cast<Feature>(i)) ? 1 : 0;
+        int previous = states[i].exchange(present, std::memory_order_acq_rel);
+        changed |= previous >= 0 && previous != present;
+    }
+    if (changed) {
+        changes.fetch_add(1, std::memory_order_acq_rel);
+    }
+    return changed;
+}
+
+const char* DeviceSupport::featureName(Feature feature)
+{
+    switch (feature) {
+    case Feature::KeyboardBacklight:
+        return "keyboard_backlight";
+    case Feature::KeyboardBacklightHwChanged:
+        return "keyboard_backlight_hw_changed";
+    case Feature::PerformanceMode:
+        return "performance_mode";
+    case Feature::BatteryChargeControl:
+        return "charge_end_threshold";
+    case Feature::FirmwareAttributes:
+        return "firmware_attributes";
+    }
+    return "unknown";
+}
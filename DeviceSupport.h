@@ -0,0 +1,44 @@
+#ifndef DEVICESUPPORT_H
+#define DEVICESUPPORT_H
+
+#include <QString>
+#include <atomic>
+
+// Which hardware features are present, probed with one stat each on first
+// use and then answered from memory, so isSupported() checks on the get,
+// set and notification paths cost no syscall. The flags only change when
+// refresh() is called, which UeventMonitor triggers as devices appear and
+// disappear (the driver loading late, or being reloaded after resume).
+class DeviceSupport
+{
+public:
+    enum class Feature {
+        KeyboardBacklight,
+        KeyboardBacklightHwChanged,
+        PerformanceMode,
+        BatteryChargeControl,
+        FirmwareAttributes,
+    };
+    static constexpr int feature_count = 5;
+
+    static bool isPresent(Feature feature);
+
+    // Probes every feature again; returns true when any flag changed
+    static bool refresh();
+
+    // Bumped by every refresh() that changed a flag
+    static quint64 generation() { return changes.load(std::memory_order_acquire); }
+
+    static const char* featureName(Feature feature);
+
+private:
+    static bool probe(Feature feature);
+
+    // -1 until probed, then 0 or 1
+    static std::atomic<int> states[feature_count];
+    static std::atomic<quint64> changes;
+
+    DeviceSupport() = delete;
+};
+
+#endif // DEVICESUPPORT_H
@@ -1,92 +1,286 @@
 #include "FirmwareAttribute.h"
+#include "Metrics.h"
+#include "SysfsAttribute.h"
+#include "SysfsRoot.h"
 #include <QFile>
-#include <QDir>
-#include <QTextStream>
-#include <QStringList>
-#include <QIODevice>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
 #include <stdexcept>
+#include <unistd.h>
 
 const QString FirmwareAttribute::base_path = "/sys/class/firmware-attributes/samsung-galaxybook/attributes/";
 
+struct FirmwareAttribute::State
+{
+    State(const QString& attribute_name, const QString& attribute_path)
+        : current_value(attribute_path + "/current_value")
+    {
+#ifdef GALAXYBOOK_TRACE
+        metrics = Metrics::attribute(attribute_name);
+#else
+        Q_UNUSED(attribute_name);
+#endif
+    }
+
+    SysfsAttribute current_value;
+    Metrics::Attribute *metrics = nullptr;
+    // Swapped atomically on reload so readers never see a partial update
+    std::shared_ptr<const Metadata> metadata;
+};
+
+namespace {
+
+// Reads a small metadata file relative to an attribute directory
+bool readMetadataFile(int directory_fd, const char *name, QByteArray& content)
+{
+    int fd = ::openat(directory_fd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    char buffer[4096];
+    ssize_t length = ::read(fd, buffer, sizeof(buffer));
+    ::close(fd);
+    if (length < 0) {
+        return false;
+    }
+    content = QByteArray(buffer, static_cast<int>(length)).trimmed();
+    return true;
+}
+
+bool readMetadataInt(int directory_fd, const char *name, int& value)
+{
+    QByteArray content;
+    return readMetadataFile(directory_fd, name, content)
+        && SysfsAttribute::parseInt(content.constData(), static_cast<size_t>(content.size()), value);
+}
+
+} // namespace
+
 FirmwareAttribute::FirmwareAttribute(const QString& attribute_name)
     : attribute_name_(attribute_name)
+    , attribute_path_(getBasePath() + attribute_name)
+    , state_(std::make_shared<State>(attribute_name, attribute_path_))
 {
 }
 
-bool FirmwareAttribute::isSupported() const
+FirmwareAttribute::FirmwareAttribute(const QString& attribute_name, std::shared_ptr<const Metadata> metadata)
+    : FirmwareAttribute(attribute_name)
 {
-    return QDir(base_path + attribute_name_).exists();
+    state_->metadata = std::move(metadata);
 }
 
-void FirmwareAttribute::set(int value)
+QString FirmwareAttribute::getBasePath()
 {
-    if (!isSupported()) {
-        throw std::runtime_error("Attribute " + attribute_name_.toStdString() + " is not supported");
+    return SysfsRoot::path(base_path);
+}
+
+QVector<FirmwareAttribute> FirmwareAttribute::discover()
+{
+    QVector<FirmwareAttribute> attributes;
+    DIR *directory = ::opendir(QFile::encodeName(getBasePath()).constData());
+    if (!directory) {
+        return attributes;
     }
-    
-    if (!isValidValue(value)) {
-        throw std::runtime_error("Invalid value " + std::to_string(value) + " for attribute " + attribute_name_.toStdString());
+
+    int directory_fd = ::dirfd(directory);
+    while (struct dirent *entry = ::readdir(directory)) {
+        // Attributes are directories; files such as pending_reboot are not
+        if (entry->d_name[0] == '.'
+            || (entry->d_type != DT_DIR && entry->d_type != DT_LNK && entry->d_type != DT_UNKNOWN)) {
+            continue;
+        }
+        int fd = ::openat(directory_fd, entry->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        std::shared_ptr<const Metadata> metadata = loadMetadata(fd);
+        ::close(fd);
+        if (metadata->type != Metadata::Type::Unknown) {
+            attributes.append(FirmwareAttribute(QFile::decodeName(entry->d_name), metadata));
+        }
     }
-    
-    QString filePath = base_path + attribute_name_ + "/current_value";
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        throw std::runtime_error("Failed to open file: " + filePath.toStdString());
+    ::closedir(directory);
+
+    std::sort(attributes.begin(), attributes.end(), [](const FirmwareAttribute& a, const FirmwareAttribute& b) {
+        return a.attribute_name_ < b.attribute_name_;
+    });
+    return attributes;
+}
+
+std::shared_ptr<const FirmwareAttribute::Metadata> FirmwareAttribute::loadMetadata(const QString& attribute_path)
+{
+    int fd = ::open(QFile::encodeName(attribute_path).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::make_shared<Metadata>();
     }
-    QTextStream out(&file);
-    out << value;
-    file.close();
+    std::shared_ptr<const Metadata> metadata = loadMetadata(fd);
+    ::close(fd);
+    return metadata;
 }
 
-int FirmwareAttribute::get() const
+std::shared_ptr<const FirmwareAttribute::Metadata> FirmwareAttribute::loadMetadata(int fd)
 {
-    if (!isSupported()) {
-        throw std::runtime_error("Attribute " + attribute_name_.toStdString() + " is not supported");
+    auto metadata = std::make_shared<Metadata>();
+    metadata->present = true;
+
+    QByteArray content;
+    if (readMetadataFile(fd, "display_name", content)) {
+        metadata->display_name = QString::fromUtf8(content);
+    }
+    metadata->has_default_value = readMetadataInt(fd, "default_value", metadata->default_value);
+
+    // Older out-of-tree drivers have no type file; they only expose enumerations
+    QByteArray type;
+    readMetadataFile(fd, "type", type);
+    if (type == "integer") {
+        metadata->type = Metadata::Type::Integer;
+        readMetadataInt(fd, "min_value", metadata->min_value);
+        readMetadataInt(fd, "max_value", metadata->max_value);
+        readMetadataInt(fd, "scalar_increment", metadata->scalar_increment);
+        if (metadata->scalar_increment <= 0) {
+            metadata->scalar_increment = 1;
+        }
+    } else if (readMetadataFile(fd, "possible_values", content)) {
+        metadata->type = Metadata::Type::Enumeration;
+        for (const QByteArray& token : content.split(';')) {
+            int value;
+            if (SysfsAttribute::parseInt(token.constData(), static_cast<size_t>(token.size()), value)) {
+                metadata->possible_values.append(value);
+                if (value >= 0 && value < 64) {
+                    metadata->possible_value_mask |= quint64(1) << value;
+                }
+            }
+        }
+        std::sort(metadata->possible_values.begin(), metadata->possible_values.end());
+        metadata->possible_values.erase(std::unique(metadata->possible_values.begin(), metadata->possible_values.end()),
+                                        metadata->possible_values.end());
+    }
+    return metadata;
+}
+
+std::shared_ptr<const FirmwareAttribute::Metadata> FirmwareAttribute::getMetadata() const
+{
+    std::shared_ptr<const Metadata> metadata = std::atomic_load(&state_->metadata);
+    if (!metadata) {
+        metadata = loadMetadata(attribute_path_);
+        std::shared_ptr<const Metadata> expected;
+        if (!std::atomic_compare_exchange_strong(&state_->metadata, &expected, metadata)) {
+            metadata = expected;
+        }
     }
-    
-    QString filePath = base_path + attribute_name_ + "/current_value";
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        throw std::runtime_error("Failed to open file: " + filePath.toStdString());
+    return metadata;
+}
+
+void FirmwareAttribute::reloadMetadata()
+{
+    std::atomic_store(&state_->metadata, loadMetadata(attribute_path_));
+}
+
+bool FirmwareAttribute::isSupported() const
+{
+    return getMetadata()->present;
+}
+
+ControlStatus FirmwareAttribute::trySet(int value)
+{
+    // Support and validity both come from the cached metadata, so a set is a
+    // single write with no stat, read or allocation
+    std::shared_ptr<const Metadata> metadata = getMetadata();
+    if (!metadata->present) {
+        return ControlError::Unsupported;
+    }
+    if (!isValidValue(*metadata, value)) {
+        return ControlError::InvalidValue;
     }
-    QTextStream in(&file);
+
+    GALAXYBOOK_TRACE_SCOPE(trace, state_->metrics, Write);
+    if (!state_->current_value.writeInt(value)) {
+        GALAXYBOOK_TRACE_FAIL(trace);
+        return errno == ENOENT ? ControlStatus(ControlError::Unsupported, ENOENT) : ControlStatus::fromErrno();
+    }
+    return ControlStatus();
+}
+
+ControlResult<int> FirmwareAttribute::tryGet() const
+{
+    GALAXYBOOK_TRACE_SCOPE(trace, state_->metrics, Read);
     int value;
-    in >> value;
-    file.close();
+    if (!state_->current_value.readInt(value)) {
+        GALAXYBOOK_TRACE_FAIL(trace);
+        return errno == ENOENT ? ControlStatus(ControlError::Unsupported, ENOENT) : ControlStatus::fromErrno();
+    }
     return value;
 }
 
-QVector<int> FirmwareAttribute::getSupportedValues() const
+void FirmwareAttribute::set(int value)
 {
-    QVector<int> supported_values;
-    if (!isSupported()) {
-        return supported_values;
-    }
-    
-    QFile file(base_path + attribute_name_ + "/possible_values");
-    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QString content = file.readAll().trimmed();
-        file.close();
-        
-        // Split the content by semicolon and convert to integers
-        QStringList values = content.split(';', Qt::SkipEmptyParts);
-        for (const QString& valueStr : values) {
-            bool ok;
-            int value = valueStr.toInt(&ok);
-            if (ok) {
-                supported_values.append(value);
-            }
-        }
+    ControlStatus status = trySet(value);
+    if (!status.ok()) {
+        throwStatus(status, value, "write");
     }
-    return supported_values;
+}
+
+int FirmwareAttribute::get() const
+{
+    ControlResult<int> result = tryGet();
+    if (!result.ok()) {
+        throwStatus(result.status(), 0, "read");
+    }
+    return result.value();
+}
+
+void FirmwareAttribute::throwStatus(ControlStatus status, int value, const char *operation) const
+{
+    switch (status.error()) {
+    case ControlError::Unsupported:
+        throw std::runtime_error("Attribute " + attribute_name_.toStdString() + " is not supported");
+    case ControlError::InvalidValue:
+    case ControlError::OutOfRange:
+        throw std::runtime_error("Invalid value " + std::to_string(value) + " for attribute " + attribute_name_.toStdString());
+    default:
+        throw std::runtime_error("Failed to " + std::string(operation) + " file: " + std::string(state_->current_value.nativePath()));
+    }
+}
+
+QVector<int> FirmwareAttribute::getSupportedValues() const
+{
+    return getMetadata()->possible_values;
 }
 
 bool FirmwareAttribute::isValidValue(int value) const
 {
-    return getSupportedValues().contains(value);
+    return isValidValue(*getMetadata(), value);
+}
+
+bool FirmwareAttribute::isValidValue(const Metadata& metadata, int value) const
+{
+    GALAXYBOOK_TRACE_SCOPE(trace, state_->metrics, Validate);
+    bool valid = false;
+    switch (metadata.type) {
+    case Metadata::Type::Enumeration:
+        if (value >= 0 && value < 64) {
+            valid = (metadata.possible_value_mask >> value) & 1;
+        } else {
+            valid = std::binary_search(metadata.possible_values.cbegin(), metadata.possible_values.cend(), value);
+        }
+        break;
+    case Metadata::Type::Integer:
+        valid = value >= metadata.min_value && value <= metadata.max_value
+            && (value - metadata.min_value) % metadata.scalar_increment == 0;
+        break;
+    case Metadata::Type::Unknown:
+        break;
+    }
+    if (!valid) {
+        GALAXYBOOK_TRACE_FAIL(trace);
+    }
+    return valid;
 }
 
 QString FirmwareAttribute::getMonitoringFilePath() const
 {
-    return base_path + attribute_name_ + "/current_value";
+    return attribute_path_ + "/current_value";
 }
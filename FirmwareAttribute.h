@@ -1,17 +1,45 @@
 #ifndef FIRMWAREATTRIBUTE_H
 #define FIRMWAREATTRIBUTE_H
 
+#include "ControlResult.h"
+
 #include <QString>
 #include <QVector>
+#include <QtGlobal>
+#include <memory>
 
 class FirmwareAttribute
 {
 public:
+    // Static description exposed by the firmware-attributes class
+    struct Metadata
+    {
+        enum class Type { Unknown, Enumeration, Integer };
+
+        bool present = false;
+        Type type = Type::Unknown;
+        QString display_name;
+        bool has_default_value = false;
+        int default_value = 0;
+        // Enumeration attributes, sorted ascending
+        QVector<int> possible_values;
+        // Bit n is set when n is a possible value, for values 0..63
+        quint64 possible_value_mask = 0;
+        // Integer attributes
+        int min_value = 0;
+        int max_value = 0;
+        int scalar_increment = 1;
+    };
+
     explicit FirmwareAttribute(const QString& attribute_name);
 
     bool isSupported() const;
+    // Throw std::runtime_error; the try forms report the same failures
+    // without unwinding or allocating
     void set(int value);
     int get() const;
+    ControlStatus trySet(int value);
+    ControlResult<int> tryGet() const;
     QVector<int> getSupportedValues() const;
     bool isValidValue(int value) const;
     QString getMonitoringFilePath() const;
@@ -19,9 +47,38 @@ public:
     // Attribute name getter
     QString getAttributeName() const { return attribute_name_; }
 
+    // Metadata is read once on first use; reload it after the attributes
+    // directory has been re-enumerated. Hold on to the pointer while using
+    // it: a reload replaces the block and drops the attribute's reference.
+    std::shared_ptr<const Metadata> getMetadata() const;
+    void reloadMetadata();
+
+    // Attributes directory below SysfsRoot
+    static QString getBasePath();
+
+    // Every attribute of a known type below getBasePath(), sorted by name.
+    // One directory scan; each attribute's metadata is read right away
+    // through its directory descriptor, so the cost is one readdir pass
+    // plus a handful of small reads per attribute.
+    static QVector<FirmwareAttribute> discover();
+
 private:
+    struct State;
+
+    FirmwareAttribute(const QString& attribute_name, std::shared_ptr<const Metadata> metadata);
+
     QString attribute_name_;
+    // Attribute directory below SysfsRoot
+    QString attribute_path_;
+    // Shared so copies of an attribute reuse the same open descriptors and metadata
+    std::shared_ptr<State> state_;
     static const QString base_path;
+
+    bool isValidValue(const Metadata& metadata, int value) const;
+    [[noreturn]] void throwStatus(ControlStatus status, int value, const char *operation) const;
+
+    static std::shared_ptr<const Metadata> loadMetadata(const QString& attribute_path);
+    static std::shared_ptr<const Metadata> loadMetadata(int attribute_directory_fd);
 };
 
 #endif // FIRMWAREATTRIBUTE_H
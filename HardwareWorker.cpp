@@ -0,0 +1,275 @@
+#include "HardwareWorker.h"
+#include "DeviceControls.h"
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+#include <exception>
+
+namespace {
+
+qint64 nowNs()
+{
+    static QElapsedTimer clock = [] {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock.nsecsElapsed();
+}
+
+} // namespace
+
+HardwareWorker::HardwareWorker(int thread_count, int queue_limit, QObject *parent)
+    : QObject(parent)
+    , queue_limit(queue_limit)
+{
+    for (int i = 0; i < qMax(1, thread_count); ++i) {
+        QThread *thread = QThread::create([this] { run(); });
+        thread->setObjectName(QString("HardwareWorker-%1").arg(i));
+        thread->start();
+        threads.append(thread);
+    }
+}
+
+HardwareWorker::~HardwareWorker()
+{
+    waitForIdle();
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        workAvailable.wakeAll();
+    }
+    for (QThread *thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+bool HardwareWorker::submit(const QString& lane_name, Operation operation, QObject *context, Callback callback)
+{
+    Request request;
+    request.operation = std::move(operation);
+    request.context = context;
+    request.callback = std::move(callback);
+    return enqueue(lane_name, std::move(request));
+}
+
+bool HardwareWorker::submitChecked(const QString& lane_name, CheckedOperation operation, QObject *context,
+                                   Callback callback)
+{
+    Request request;
+    request.checked = std::move(operation);
+    request.context = context;
+    request.callback = std::move(callback);
+    return enqueue(lane_name, std::move(request));
+}
+
+bool HardwareWorker::submitExclusive(const QString& name, Operation operation, QObject *context, Callback callback)
+{
+    Request request;
+    request.operation = std::move(operation);
+    request.context = context;
+    request.callback = std::move(callback);
+
+    QMutexLocker locker(&mutex);
+    if (stopping || queued >= queue_limit) {
+        ++stats.rejected;
+        return false;
+    }
+    ++stats.submitted;
+    request.queued_at = nowNs();
+    request.ticket = ++next_ticket;
+    exclusive.emplace_back(name, std::move(request));
+    stats.max_queued = qMax(stats.max_queued, ++queued);
+    workAvailable.wakeAll();
+    return true;
+}
+
+bool HardwareWorker::enqueue(const QString& lane_name, Request request)
+{
+    QMutexLocker locker(&mutex);
+    if (stopping || queued >= queue_limit) {
+        ++stats.rejected;
+        return false;
+    }
+    ++stats.submitted;
+    request.ticket = ++next_ticket;
+
+    Lane& lane = lanes[lane_name];
+    if (lane.requests.empty() && !lane.running) {
+        ready.push_back(lane_name);
+    }
+    request.queued_at = nowNs();
+    lane.requests.push_back(std::move(request));
+
+    stats.max_queued = qMax(stats.max_queued, ++queued);
+    workAvailable.wakeOne();
+    return true;
+}
+
+bool HardwareWorker::get(DeviceControl *control, QObject *context, Callback callback)
+{
+    Request request;
+    request.control = control;
+    request.context = context;
+    request.callback = std::move(callback);
+    return enqueue(control->name(), std::move(request));
+}
+
+bool HardwareWorker::set(DeviceControl *control, const QString& value, QObject *context, Callback callback)
+{
+    Request request;
+    request.control = control;
+    request.write = true;
+    request.value = value;
+    request.context = context;
+    request.callback = std::move(callback);
+    return enqueue(control->name(), std::move(request));
+}
+
+void HardwareWorker::waitForIdle()
+{
+    QMutexLocker locker(&mutex);
+    while (queued > 0 || running > 0) {
+        idle.wait(&mutex);
+    }
+}
+
+int HardwareWorker::queuedCount() const
+{
+    QMutexLocker locker(&mutex);
+    return queued;
+}
+
+HardwareWorker::Statistics HardwareWorker::statistics() const
+{
+    QMutexLocker locker(&mutex);
+    return stats;
+}
+
+int HardwareWorker::nextReady()
+{
+    if (exclusive_running) {
+        return -1;
+    }
+    quint64 barrier = exclusive.empty() ? ~quint64(0) : exclusive.front().second.ticket;
+    for (size_t i = 0; i < ready.size(); ++i) {
+        if (lanes[ready[i]].requests.front().ticket < barrier) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+HardwareReply HardwareWorker::execute(Request& request, const QString& lane_name)
+{
+    HardwareReply reply;
+    qint64 started = nowNs();
+    reply.wait_ns = started - request.queued_at;
+    if (request.control) {
+        // Expected failures (busy EC, driver gone) come back as a status
+        if (request.write) {
+            reply.status = request.control->trySet(request.value);
+        } else {
+            ControlResult<QString> result = request.control->tryGet();
+            reply.status = result.status();
+            reply.value = result.value();
+        }
+        reply.ok = reply.status.ok();
+        if (!reply.ok) {
+            reply.error = request.control->failureMessage(reply.status, request.value);
+        }
+    } else if (request.checked) {
+        ControlResult<QString> result = request.checked();
+        reply.status = result.status();
+        reply.value = result.value();
+        reply.ok = reply.status.ok();
+        if (!reply.ok) {
+            reply.error = reply.status.message(lane_name);
+        }
+    } else {
+        try {
+            reply.value = request.operation();
+            reply.ok = true;
+        } catch (const std::exception& e) {
+            reply.error = QString::fromUtf8(e.what());
+        }
+    }
+    reply.run_ns = nowNs() - started;
+
+    if (request.callback) {
+        if (!request.context) {
+            request.callback(reply);
+        } else {
+            Callback callback = std::move(request.callback);
+            QMetaObject::invokeMethod(request.context, [callback, reply] { callback(reply); }, Qt::QueuedConnection);
+        }
+    }
+    return reply;
+}
+
+void HardwareWorker::run()
+{
+    QMutexLocker locker(&mutex);
+    for (;;) {
+        int index = nextReady();
+        // An exclusive request starts once everything before it is done
+        bool alone = index < 0 && !exclusive.empty() && running == 0;
+        if (index < 0 && !alone) {
+            if (stopping && ready.empty() && exclusive.empty()) {
+                return;
+            }
+            workAvailable.wait(&mutex);
+            continue;
+        }
+
+        QString lane_name;
+        Request request;
+        if (alone) {
+            lane_name = exclusive.front().first;
+            request = std::move(exclusive.front().second);
+            exclusive.pop_front();
+            exclusive_running = true;
+        } else {
+            lane_name = ready[index];
+            ready.erase(ready.begin() + index);
+            Lane& lane = lanes[lane_name];
+            request = std::move(lane.requests.front());
+            lane.requests.pop_front();
+            lane.running = true;
+        }
+        --queued;
+        ++running;
+        locker.unlock();
+
+        HardwareReply reply = execute(request, lane_name);
+
+        locker.relock();
+        if (reply.ok) {
+            ++stats.completed;
+        } else {
+            ++stats.failed;
+        }
+        --running;
+        if (alone) {
+            exclusive_running = false;
+            // Every lane held back by it may go now
+            workAvailable.wakeAll();
+        } else {
+            // The lane may only run again now, which keeps its requests in order
+            Lane& done = lanes[lane_name];
+            done.running = false;
+            if (!done.requests.empty()) {
+                ready.push_back(lane_name);
+                workAvailable.wakeOne();
+            }
+            // The last request ahead of an exclusive one has finished
+            if (running == 0 && !exclusive.empty()) {
+                workAvailable.wakeAll();
+            }
+        }
+        if (queued == 0 && running == 0) {
+            idle.wakeAll();
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#ifndef HARDWAREWORKER_H
+#define HARDWAREWORKER_H
+
+#include "ControlResult.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include <deque>
+#include <functional>
+#include <utility>
+
+class DeviceControl;
+class QThread;
+
+// Outcome of one request; value is empty for writes
+struct HardwareReply
+{
+    bool ok = false;
+    QString value;
+    QString error;
+    // Set by the DeviceControl shortcuts and checked operations
+    ControlStatus status;
+    qint64 wait_ns = 0;     // time spent queued
+    qint64 run_ns = 0;      // time spent in the operation
+};
+
+// Runs sysfs reads and writes off the calling thread. Requests are queued
+// per lane (normally the control name): a lane runs its requests one at a
+// time in submission order, while different lanes proceed in parallel on
+// a few I/O threads, so a slow EC write to one attribute does not hold up
+// the others. The queue is bounded; submit() refuses work beyond the limit
+// instead of letting a stuck attribute pile up requests.
+class HardwareWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Returns the value read, or an empty string; throws on failure
+    using Operation = std::function<QString()>;
+    // Reports failure as a status instead, named after the lane in the reply
+    using CheckedOperation = std::function<ControlResult<QString>()>;
+    using Callback = std::function<void(const HardwareReply&)>;
+
+    struct Statistics
+    {
+        quint64 submitted = 0;
+        quint64 rejected = 0;       // refused because the queue was full
+        quint64 completed = 0;      // operations that returned
+        quint64 failed = 0;         // operations that threw or reported an error
+        int max_queued = 0;
+    };
+
+    explicit HardwareWorker(int threads = 2, int queue_limit = 256, QObject *parent = nullptr);
+    // Finishes every queued request before returning
+    ~HardwareWorker();
+
+    // Queues operation behind earlier requests of the same lane. The
+    // callback runs in context's thread, or in the I/O thread without a
+    // context. A context must outlive the worker; callbacks still queued
+    // when it is destroyed are dropped with it.
+    bool submit(const QString& lane, Operation operation, QObject *context = nullptr, Callback callback = {});
+    bool submitChecked(const QString& lane, CheckedOperation operation, QObject *context = nullptr,
+                       Callback callback = {});
+    // Runs operation alone: after every request submitted before it, on any
+    // lane, has finished, and before any submitted after it starts. For
+    // work that spans controls, e.g. a profile or a rescan. name labels the
+    // request in errors.
+    bool submitExclusive(const QString& name, Operation operation, QObject *context = nullptr,
+                         Callback callback = {});
+
+    // DeviceControl shortcuts through tryGet()/trySet(); the lane is the
+    // control's name
+    bool get(DeviceControl *control, QObject *context, Callback callback);
+    bool set(DeviceControl *control, const QString& value, QObject *context, Callback callback = {});
+
+    // Blocks until every queued request has run
+    void waitForIdle();
+
+    int queuedCount() const;
+    Statistics statistics() const;
+
+private:
+    struct Request
+    {
+        // One of operation, checked or control is set
+        Operation operation;
+        CheckedOperation checked;
+        // For the DeviceControl shortcuts
+        DeviceControl *control = nullptr;
+        bool write = false;
+        QString value;
+        QObject *context = nullptr;
+        Callback callback;
+        qint64 queued_at = 0;
+        // Submission order across all lanes
+        quint64 ticket = 0;
+    };
+
+    struct Lane
+    {
+        std::deque<Request> requests;
+        bool running = false;
+    };
+
+    bool enqueue(const QString& lane, Request request);
+    // Index into ready of a lane that may start, or -1; mutex must be held
+    int nextReady();
+    HardwareReply execute(Request& request, const QString& lane_name);
+    void run();
+
+    const int queue_limit;
+    mutable QMutex mutex;
+    QWaitCondition workAvailable;
+    QWaitCondition idle;
+    QHash<QString, Lane> lanes;
+    // Lanes with work and no running request, served round robin
+    std::deque<QString> ready;
+    // Exclusive requests with their names, in submission order; requests
+    // with a later ticket than the first wait for it
+    std::deque<std::pair<QString, Request>> exclusive;
+    bool exclusive_running = false;
+    quint64 next_ticket = 0;
+    int queued = 0;
+    int running = 0;
+    bool stopping = false;
+    QVector<QThread *> threads;
+    Statistics stats;
+};
+
+#endif // HARDWAREWORKER_H
@@ -4,10 +4,12 @@
 #include <QString>
 #include "UnsupportedFeatureException.h"
 
+// Named entry points for the keyboard rows of AttributeTable
 class KeyboardBacklight
 {
 public:
     static bool isSupported();
+    // Throws when level is outside 0..getMaxBrightness()
     static void setBrightness(int brightness_level);
     static int getBrightness();
     static int getMaxBrightness();
@@ -18,8 +20,6 @@ public:
     static QString getBrightnessFilePath();
 
 private:
-    static const QString base_path;
-    
     KeyboardBacklight() = delete;
 };
 
@@ -1,167 +1,546 @@
 #include "MainWindow.h"
 #include "ui_MainWindow.h"
-#include "KeyboardBacklight.h"
-#include "PerformanceMode.h"
-#include "BatteryChargeControl.h"
-#include <QFile>
-#include <QFileSystemWatcher>
+#include "AttributeTable.h"
+#include "BatteryHealthDialog.h"
+#include "ChangeDispatcher.h"
+#include "DaemonWriter.h"
+#include "DeviceControls.h"
+#include "DeviceSupport.h"
+#include "HardwareWorker.h"
+#include "Metrics.h"
+#include "SysfsWatcher.h"
+#include "UeventMonitor.h"
+#include "WriteScheduler.h"
+#include <QComboBox>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QHBoxLayout>
+#include <QInputDialog>
+#include <QLabel>
+#include <QMenu>
+#include <QMenuBar>
 #include <QMessageBox>
+#include <QSpinBox>
 #include <functional>
 #include <algorithm>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow())
-    , fileWatcher(std::make_unique<QFileSystemWatcher>(this))
-    , power_on_lid_open("power_on_lid_open")
-    , usb_charging("usb_charging")
-    , block_recording("block_recording")
+    , changeDispatcher(new ChangeDispatcher(this))
+    , hotplugMonitor(new UeventMonitor(this))
+    , deviceControls(std::make_unique<DeviceControls>())
+    , daemonWriter(std::make_unique<DaemonWriter>())
+    , hardwareWorker(std::make_unique<HardwareWorker>())
+    , writeScheduler(std::make_unique<WriteScheduler>(*hardwareWorker))
 {
     ui->setupUi(this);
 
-    // Connect fileWatcher signal (only once)
-    connect(fileWatcher.get(), &QFileSystemWatcher::fileChanged, 
-            this, &MainWindow::onFileChanged);
+    // Fold a burst of hotkey presses into a single UI update per frame
+    changeDispatcher->setCoalescingInterval(16);
+    connect(writeScheduler.get(), &WriteScheduler::committed, this, &MainWindow::handleWriteCommitted);
 
-    bool atLeastOneUiSetup = false;
-    atLeastOneUiSetup |= setupUiKeyboardBacklight();
-    atLeastOneUiSetup |= setupUiPerformanceMode();
-    atLeastOneUiSetup |= setupUiBatteryChargeEndThreshold();
-    atLeastOneUiSetup |= setupUiPowerOnLidOpen();
-    atLeastOneUiSetup |= setupUiUsbCharging();
-    atLeastOneUiSetup |= setupUiBlockRecording();
+    setupUiKeyboardBacklight();
+    setupUiPerformanceMode();
+    setupUiBatteryChargeEndThreshold();
+    setupUiPowerOnLidOpen();
+    setupUiUsbCharging();
+    setupUiBlockRecording();
+    setupUiProfiles();
+    setupUiBatteryHealth();
 
-    if (!atLeastOneUiSetup) {
+    // A snapshot from an earlier run on this kernel and machine paints the
+    // window without touching the hardware
+    CapabilitySnapshot cached;
+    if (cached.load()) {
+        applySnapshot(cached);
+    }
+    if (!changeJournal.open(ChangeJournal::defaultPath())) {
+        qDebug() << changeJournal.errorString();
+    }
+    startProbe(cached);
+
+    // Features follow the driver: it may load after us or be reloaded on resume
+    if (hotplugMonitor->open()) {
+        connect(hotplugMonitor, &UeventMonitor::devicesChanged, this, &MainWindow::startHotplugProbe);
+    } else {
+        qDebug() << hotplugMonitor->errorString();
+    }
+}
+
+void MainWindow::paintEvent(QPaintEvent *event)
+{
+    QMainWindow::paintEvent(event);
+    if (!painted) {
+        painted = true;
+        emit firstPainted();
+    }
+}
+
+void MainWindow::setupUiKeyboardBacklight()
+{
+    ui->hsliderKeyboardBacklight->setEnabled(false);
+    ui->hsliderKeyboardBacklight->setTickPosition(QSlider::TicksBelow);
+    ui->hsliderKeyboardBacklight->setTickInterval(1);
+    ui->hsliderKeyboardBacklight->setSingleStep(1);
+    connect(ui->hsliderKeyboardBacklight, &QSlider::valueChanged, this, &MainWindow::onHsliderKeyboardBacklightValueChanged);
+    connect(ui->hsliderKeyboardBacklight, &QSlider::sliderReleased, this,
+            [this] { writeScheduler->flush(DeviceControls::keyboard_backlight); });
+    widgetUpdaters.insert(DeviceControls::keyboard_backlight,
+                          [this](const QString& value) { showKeyboardBacklight(value); });
+}
+
+void MainWindow::setupUiPerformanceMode()
+{
+    ui->comboPerformanceMode->setEnabled(false);
+    connect(ui->comboPerformanceMode, &QComboBox::currentTextChanged, this, &MainWindow::onComboPerformanceModeCurrentTextChanged);
+    widgetUpdaters.insert(DeviceControls::performance_mode,
+                          [this](const QString& value) { showPerformanceMode(value); });
+}
+
+void MainWindow::setupUiBatteryChargeEndThreshold()
+{
+    // Battery Charge End Threshold setup
+    ui->hsliderBatteryChargeEndThreshold->setEnabled(false);
+    ui->hsliderBatteryChargeEndThreshold->setMinimum(30);
+    ui->hsliderBatteryChargeEndThreshold->setMaximum(100);
+    ui->hsliderBatteryChargeEndThreshold->setTickPosition(QSlider::TicksBelow);
+    ui->hsliderBatteryChargeEndThreshold->setTickInterval(10);
+    ui->hsliderBatteryChargeEndThreshold->setSingleStep(10);
+    connect(ui->hsliderBatteryChargeEndThreshold, &QSlider::valueChanged, this, &MainWindow::onHsliderBatteryChargeEndThresholdValueChanged);
+    connect(ui->hsliderBatteryChargeEndThreshold, &QSlider::sliderReleased, this,
+            [this] { writeScheduler->flush(DeviceControls::charge_end_threshold); });
+    widgetUpdaters.insert(DeviceControls::charge_end_threshold,
+                          [this](const QString& value) { showBatteryChargeEndThreshold(value); });
+}
+
+void MainWindow::setupUiPowerOnLidOpen()
+{
+    setupUiFirmwareAttribute("power_on_lid_open",
+                             *ui->cboxPowerOnLidOpen,
+                             "Power on lid open",
+                             [this](int state) { onCboxPowerOnLidOpenStateChanged(state); });
+}
+
+void MainWindow::setupUiUsbCharging()
+{
+    setupUiFirmwareAttribute("usb_charging",
+                             *ui->cboxUsbCharging,
+                             "USB charging",
+                             [this](int state) { onCboxUsbChargingStateChanged(state); });
+}
+
+void MainWindow::setupUiBlockRecording()
+{
+    setupUiFirmwareAttribute("block_recording",
+                             *ui->cboxBlockRecording,
+                             "Block recording",
+                             [this](int state) { onCboxBlockRecordingStateChanged(state); });
+}
+
+// Generic function to setup checkbox-based firmware attributes
+void MainWindow::setupUiFirmwareAttribute(const QString& name,
+                                          QCheckBox& checkbox,
+                                          const QString& featureName,
+                                          std::function<void(int)> stateChangeSlot)
+{
+    checkbox.setEnabled(false);
+    connect(&checkbox, &QCheckBox::checkStateChanged, this, stateChangeSlot);
+    widgetUpdaters.insert(name, [this, &checkbox, featureName](const QString& value) {
+        showFirmwareAttribute(checkbox, featureName, value);
+    });
+}
+
+void MainWindow::startProbe(const CapabilitySnapshot& cached)
+{
+    DeviceControls *controls = deviceControls.get();
+    auto probed = std::make_shared<CapabilitySnapshot>();
+    hardwareWorker->submit("startup", [controls, probed] {
+        *probed = CapabilitySnapshot::probe(*controls);
+        return QString();
+    }, this, [this, probed, cached](const HardwareReply&) {
+        handleProbed(*probed, cached);
+    });
+}
+
+void MainWindow::handleProbed(const CapabilitySnapshot& probed, const CapabilitySnapshot& cached)
+{
+    applySnapshot(probed);
+    for (const CapabilitySnapshot::Entry& entry : probed.entries) {
+        watchControl(entry.name, entry.value);
+    }
+    if (probed.key != cached.key || probed.entries != cached.entries) {
+        probed.save();
+    }
+
+    if (probed.isEmpty()) {
         QMessageBox::warning(this, "No Features Supported",
             "No features are supported. Please use Linux kernel 6.15 or higher.\n\n"
             "If you are using kernel version below 6.15, please install https://github.com/joshuagrisham/samsung-galaxybook-extras manually.");
     }
+    emit startupFinished();
+}
+
+void MainWindow::startHotplugProbe()
+{
+    DeviceControls *controls = deviceControls.get();
+    auto probed = std::make_shared<CapabilitySnapshot>();
+    // Reloading metadata must not overlap any read or write of a control,
+    // nor the startup probe, so the rescan runs alone on the worker
+    hardwareWorker->submitExclusive("hotplug", [controls, probed] {
+        DeviceSupport::refresh();
+        controls->rescan();
+        *probed = CapabilitySnapshot::probe(*controls);
+        return QString();
+    }, this, [this, probed](const HardwareReply&) {
+        handleHotplugProbed(*probed);
+    });
 }
 
-bool MainWindow::setupUiKeyboardBacklight()
+void MainWindow::handleHotplugProbed(const CapabilitySnapshot& probed)
 {
-    if (KeyboardBacklight::isSupported()) {
-        ui->hsliderKeyboardBacklight->setMaximum(KeyboardBacklight::getMaxBrightness());
-        ui->hsliderKeyboardBacklight->setValue(KeyboardBacklight::getBrightness());
-        ui->hsliderKeyboardBacklight->setTickPosition(QSlider::TicksBelow);
-        ui->hsliderKeyboardBacklight->setTickInterval(1);
-        ui->hsliderKeyboardBacklight->setSingleStep(1);
-        connect(ui->hsliderKeyboardBacklight, &QSlider::valueChanged, this, &MainWindow::onHsliderKeyboardBacklightValueChanged);
-        // Set up monitoring for brightness_hw_changed file
-        if (KeyboardBacklight::isHwChangedMonitoringSupported()) {
-            QString hwChangedPath = KeyboardBacklight::getHwChangedFilePath();
-            
-            fileWatcher->addPath(hwChangedPath);
+    changeDispatcher->watcher()->rearm();
+    applySnapshot(probed);
+    for (const CapabilitySnapshot::Entry& entry : probed.entries) {
+        watchControl(entry.name, entry.value);
+        // Show what the device reports now, unless the user is changing it
+        if (!writeScheduler->isBusy(entry.name) && stateCache.update(entry.name, entry.value)) {
+            showControl(entry.name, entry.value);
         }
-        return true;
-    } else {
-        ui->hsliderKeyboardBacklight->setEnabled(false);
-        return false;
     }
+    probed.save();
+    ui->statusbar->showMessage(QString("Devices changed: %1 features available").arg(probed.entries.size()));
 }
 
-bool MainWindow::setupUiPerformanceMode()
+void MainWindow::applySnapshot(const CapabilitySnapshot& snapshot)
 {
-    if (PerformanceMode::isSupported()) {
-        ui->comboPerformanceMode->addItems(PerformanceMode::getSupportedPerformanceModes());
-        ui->comboPerformanceMode->setCurrentText(PerformanceMode::getPerformanceMode());
-        connect(ui->comboPerformanceMode, &QComboBox::currentTextChanged, this, &MainWindow::onComboPerformanceModeCurrentTextChanged);
+    configureKeyboardBacklight(snapshot.find(DeviceControls::keyboard_backlight));
+    configurePerformanceMode(snapshot.find(DeviceControls::performance_mode));
+    configureBatteryChargeEndThreshold(snapshot.find(DeviceControls::charge_end_threshold));
+    configureFirmwareAttribute(*ui->cboxPowerOnLidOpen, snapshot.find("power_on_lid_open"));
+    configureFirmwareAttribute(*ui->cboxUsbCharging, snapshot.find("usb_charging"));
+    configureFirmwareAttribute(*ui->cboxBlockRecording, snapshot.find("block_recording"));
 
-        QString monitoringFilePath = PerformanceMode::getMonitoringFilePath();
-        if (!monitoringFilePath.isEmpty()) {
-            fileWatcher->addPath(monitoringFilePath);
+    // Attributes the driver exposes beyond the ones above get generated rows
+    for (auto it = discoveredWidgets.cbegin(); it != discoveredWidgets.cend(); ++it) {
+        it.value().row->setEnabled(snapshot.find(it.key()) != nullptr);
+    }
+    for (const CapabilitySnapshot::Entry& entry : snapshot.entries) {
+        if (discoveredWidgets.contains(entry.name) || !widgetUpdaters.contains(entry.name)) {
+            configureDiscoveredControl(entry);
         }
-        return true;
-    } else {
-        ui->comboPerformanceMode->setEnabled(false);
-        return false;
     }
 }
 
-bool MainWindow::setupUiBatteryChargeEndThreshold()
+bool MainWindow::untouched(const QString& name) const
 {
-    // Battery Charge End Threshold setup
-    if (BatteryChargeControl::isSupported()) {
-        ui->hsliderBatteryChargeEndThreshold->setMinimum(30);
-        ui->hsliderBatteryChargeEndThreshold->setMaximum(100);
-        
-        int currentThreshold = BatteryChargeControl::getChargeEndThreshold();
-        int adjustedThreshold = std::max(30, (currentThreshold / 10) * 10);
-        ui->hsliderBatteryChargeEndThreshold->setValue(adjustedThreshold);
-        
-        ui->hsliderBatteryChargeEndThreshold->setTickPosition(QSlider::TicksBelow);
-        ui->hsliderBatteryChargeEndThreshold->setTickInterval(10);
-        ui->hsliderBatteryChargeEndThreshold->setSingleStep(10);
-        connect(ui->hsliderBatteryChargeEndThreshold, &QSlider::valueChanged, this, &MainWindow::onHsliderBatteryChargeEndThresholdValueChanged);
-
-        QString monitoringFilePath = BatteryChargeControl::getMonitoringFilePath();
-        if (!monitoringFilePath.isEmpty()) {
-            fileWatcher->addPath(monitoringFilePath);
-        }
-        return true;
+    return !stateCache.contains(name) && !writeScheduler->isBusy(name);
+}
+
+void MainWindow::configureKeyboardBacklight(const CapabilitySnapshot::Entry *entry)
+{
+    QSlider *slider = ui->hsliderKeyboardBacklight;
+    slider->setEnabled(entry != nullptr);
+    if (!entry) {
+        return;
+    }
+    // Described as "0..<max_brightness>"
+    slider->blockSignals(true);
+    slider->setMaximum(entry->description.section("..", 1).toInt());
+    if (untouched(entry->name)) {
+        slider->setValue(entry->value.toInt());
+    }
+    slider->blockSignals(false);
+}
+
+void MainWindow::configurePerformanceMode(const CapabilitySnapshot::Entry *entry)
+{
+    QComboBox *combo = ui->comboPerformanceMode;
+    combo->setEnabled(entry != nullptr);
+    if (!entry) {
+        return;
+    }
+    combo->blockSignals(true);
+    QStringList modes = entry->description.split(' ', Qt::SkipEmptyParts);
+    QStringList current;
+    for (int i = 0; i < combo->count(); ++i) {
+        current << combo->itemText(i);
+    }
+    if (current != modes) {
+        QString selected = combo->currentText();
+        combo->clear();
+        combo->addItems(modes);
+        combo->setCurrentText(selected);
+    }
+    if (untouched(entry->name)) {
+        combo->setCurrentText(entry->value);
+    }
+    combo->blockSignals(false);
+}
+
+void MainWindow::configureBatteryChargeEndThreshold(const CapabilitySnapshot::Entry *entry)
+{
+    QSlider *slider = ui->hsliderBatteryChargeEndThreshold;
+    slider->setEnabled(entry != nullptr);
+    if (!entry || !untouched(entry->name)) {
+        return;
+    }
+    slider->blockSignals(true);
+    slider->setValue(std::max(30, (entry->value.toInt() / 10) * 10));
+    slider->blockSignals(false);
+}
+
+void MainWindow::configureFirmwareAttribute(QCheckBox& checkbox, const CapabilitySnapshot::Entry *entry)
+{
+    checkbox.setEnabled(entry != nullptr);
+    if (!entry || !untouched(entry->name)) {
+        return;
+    }
+    checkbox.blockSignals(true);
+    checkbox.setChecked(entry->value.toInt() != 0);
+    checkbox.blockSignals(false);
+}
+
+void MainWindow::configureDiscoveredControl(const CapabilitySnapshot::Entry& entry)
+{
+    auto it = discoveredWidgets.find(entry.name);
+    if (it == discoveredWidgets.end()) {
+        it = discoveredWidgets.insert(entry.name, createDiscoveredWidget(entry));
+    }
+    if (untouched(entry.name)) {
+        it.value().setValue(entry.value);
+    }
+}
+
+MainWindow::DiscoveredWidget MainWindow::createDiscoveredWidget(const CapabilitySnapshot::Entry& entry)
+{
+    const QString name = entry.name;
+    const QString label = entry.display_name.isEmpty() ? name : entry.display_name;
+
+    DiscoveredWidget widget;
+    widget.row = new QWidget(ui->centralwidget);
+    auto *layout = new QHBoxLayout(widget.row);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    if (entry.description == "0 1") {
+        auto *checkbox = new QCheckBox(label, widget.row);
+        layout->addWidget(checkbox);
+        widget.setValue = [checkbox](const QString& value) {
+            checkbox->blockSignals(true);
+            checkbox->setChecked(value.toInt() != 0);
+            checkbox->blockSignals(false);
+        };
+        connect(checkbox, &QCheckBox::checkStateChanged, this, [this, name, label](Qt::CheckState state) {
+            QString value = state == Qt::Checked ? "1" : "0";
+            writeControl(name, value);
+            ui->statusbar->showMessage(label + " set to " + value);
+        });
+    } else if (entry.description.contains("..")) {
+        auto *spinbox = new QSpinBox(widget.row);
+        spinbox->setRange(entry.description.section("..", 0, 0).toInt(), entry.description.section("..", 1).toInt());
+        // Typing writes once on enter or focus loss, not per keystroke
+        spinbox->setKeyboardTracking(false);
+        layout->addWidget(new QLabel(label, widget.row));
+        layout->addStretch();
+        layout->addWidget(spinbox);
+        widget.setValue = [spinbox](const QString& value) {
+            spinbox->blockSignals(true);
+            spinbox->setValue(value.toInt());
+            spinbox->blockSignals(false);
+        };
+        connect(spinbox, &QSpinBox::valueChanged, this, [this, name, label](int value) {
+            writeControl(name, QString::number(value));
+            ui->statusbar->showMessage(label + " set to " + QString::number(value));
+        });
     } else {
-        ui->hsliderBatteryChargeEndThreshold->setEnabled(false);
-        return false;
+        auto *combo = new QComboBox(widget.row);
+        combo->addItems(entry.description.split(' ', Qt::SkipEmptyParts));
+        layout->addWidget(new QLabel(label, widget.row));
+        layout->addStretch();
+        layout->addWidget(combo);
+        widget.setValue = [combo](const QString& value) {
+            combo->blockSignals(true);
+            combo->setCurrentText(value);
+            combo->blockSignals(false);
+        };
+        connect(combo, &QComboBox::currentTextChanged, this, [this, name, label](const QString& value) {
+            writeControl(name, value);
+            ui->statusbar->showMessage(label + " set to " + value);
+        });
     }
+
+    ui->verticalLayout_3->addWidget(widget.row);
+    std::function<void(const QString&)> setValue = widget.setValue;
+    widgetUpdaters.insert(name, [this, setValue, label](const QString& value) {
+        setValue(value);
+        ui->statusbar->showMessage(label + " changed to " + value);
+    });
+    return widget;
 }
 
-bool MainWindow::setupUiPowerOnLidOpen()
+void MainWindow::setupUiProfiles()
 {
-    return setupUiFirmwareAttribute(power_on_lid_open, 
-                                   *ui->cboxPowerOnLidOpen,
-                                   [this](int state) { onCboxPowerOnLidOpenStateChanged(state); });
+    QMenu *menu = menuBar()->addMenu("&Profiles");
+    // Rebuilt on every open so profiles saved by galaxybook-ctl show up too
+    connect(menu, &QMenu::aboutToShow, this, [this, menu] {
+        menu->clear();
+        ProfileStore store;
+        store.load();
+        for (const Profile& profile : store.profiles()) {
+            QString name = profile.name;
+            menu->addAction(name, this, [this, name] { applyProfile(name); });
+        }
+        if (!store.profiles().isEmpty()) {
+            menu->addSeparator();
+        }
+        menu->addAction("Save current settings as...", this, &MainWindow::saveProfile);
+    });
 }
 
-bool MainWindow::setupUiUsbCharging()
+void MainWindow::setupUiBatteryHealth()
 {
-    return setupUiFirmwareAttribute(usb_charging, 
-                                   *ui->cboxUsbCharging,
-                                   [this](int state) { onCboxUsbChargingStateChanged(state); });
+    QMenu *menu = menuBar()->addMenu("&Battery");
+    menu->addAction("Health history...", this, [this] {
+        BatteryHealthDialog *dialog = new BatteryHealthDialog(this);
+        dialog->setAttribute(Qt::WA_DeleteOnClose);
+        dialog->show();
+    });
 }
 
-bool MainWindow::setupUiBlockRecording()
+void MainWindow::applyProfile(const QString& name)
 {
-    return setupUiFirmwareAttribute(block_recording, 
-                                   *ui->cboxBlockRecording,
-                                   [this](int state) { onCboxBlockRecordingStateChanged(state); });
+    ProfileStore store;
+    const Profile *found = store.load() ? store.find(name) : nullptr;
+    if (!found) {
+        ui->statusbar->showMessage("Profile " + name + " not found");
+        return;
+    }
+    if (profileInFlight) {
+        ui->statusbar->showMessage("Another profile is still being applied");
+        return;
+    }
+
+    // The applier touches several controls, so it runs alone on the worker:
+    // after every write already queued for any of them, slider values still
+    // waiting for their commit interval included, and before later ones
+    Profile profile = *found;
+    for (const auto& setting : profile.settings) {
+        writeScheduler->flush(setting.first);
+    }
+    DeviceControls *controls = deviceControls.get();
+    DaemonWriter *writer = daemonWriter.get();
+    auto result = std::make_shared<ProfileApplier::Result>();
+    bool queued = hardwareWorker->submitExclusive("profiles", [controls, writer, profile, result] {
+        *result = writer->apply(profile, *controls);
+        return QString();
+    }, this, [this, name, profile, result](const HardwareReply&) {
+        handleProfileApplied(name, profile, *result);
+    });
+    if (!queued) {
+        ui->statusbar->showMessage("Hardware is busy; profile " + name + " was not applied");
+        return;
+    }
+    profileInFlight = true;
+    ui->statusbar->showMessage("Applying profile " + name + "...");
 }
 
-// Generic function to setup checkbox-based firmware attributes
-bool MainWindow::setupUiFirmwareAttribute(FirmwareAttribute& attribute, 
-                                         QCheckBox& checkbox, 
-                                         std::function<void(int)> stateChangeSlot)
-{
-    if (attribute.isSupported()) {
-        checkbox.setEnabled(true);
-        checkbox.setChecked(attribute.get());
-        connect(&checkbox, &QCheckBox::checkStateChanged, this, stateChangeSlot);
-
-        QString monitoringFilePath = attribute.getMonitoringFilePath();
-        if (!monitoringFilePath.isEmpty()) {
-            fileWatcher->addPath(monitoringFilePath);
+void MainWindow::handleProfileApplied(const QString& name, const Profile& profile, const ProfileApplier::Result& result)
+{
+    profileInFlight = false;
+    QSet<QString> deferred;
+    deferred.swap(deferredChanges);
+
+    if (result.ok) {
+        for (const auto& setting : profile.settings) {
+            if (!result.changed_controls.contains(setting.first)) {
+                continue;
+            }
+            QString value = setting.second.trimmed();
+            journalChange(setting.first, value, ChangeJournal::Origin::Profile);
+            stateCache.recordWrite(setting.first, value);
+            showControl(setting.first, value);
         }
-        return true;
+        ui->statusbar->showMessage(QString("Profile %1 applied in %2 ms (%3 changed)")
+                                       .arg(name)
+                                       .arg(result.total_ns / 1e6, 0, 'f', 2)
+                                       .arg(result.written));
     } else {
-        checkbox.setEnabled(false);
-        return false;
+        QMessageBox::warning(this, "Profile not applied", result.error + (result.rolled_back ? "\n\nPrevious settings were restored." : ""));
+    }
+
+    // Notifications that arrived meanwhile: our echoes read back the values
+    // just recorded, anything else is a change from elsewhere
+    for (const QString& controlName : deferred) {
+        if (writeScheduler->isBusy(controlName)) {
+            deferredChanges.insert(controlName);
+        } else {
+            refreshControl(controlName);
+        }
     }
 }
 
+void MainWindow::saveProfile()
+{
+    bool ok = false;
+    QString name = QInputDialog::getText(this, "Save Profile", "Profile name:", QLineEdit::Normal, QString(), &ok).trimmed();
+    if (!ok || name.isEmpty()) {
+        return;
+    }
+    // The file format separates fields with spaces
+    name.replace(' ', '-');
+
+    // Every watched control is in the cache, so saving reads no hardware
+    Profile profile;
+    profile.name = name;
+    for (const QString& controlName : deviceControls->names()) {
+        if (stateCache.contains(controlName)) {
+            profile.settings.append({controlName, stateCache.value(controlName)});
+        }
+    }
+
+    ProfileStore store;
+    store.load();
+    store.insert(profile);
+    if (!store.save()) {
+        QMessageBox::warning(this, "Profile not saved", store.errorString());
+        return;
+    }
+    ui->statusbar->showMessage("Profile " + name + " saved");
+}
+
 MainWindow::~MainWindow()
 {
     delete ui;
 }
 
+void MainWindow::finishWrites()
+{
+    writeScheduler->flushAll();
+    hardwareWorker->waitForIdle();
+    // Completions are queued to the scheduler and to us; deliver them now,
+    // the scheduler's first since it reports through handleWriteCommitted()
+    QCoreApplication::sendPostedEvents(writeScheduler.get(), QEvent::MetaCall);
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+}
+
 void MainWindow::onHsliderKeyboardBacklightValueChanged(int value)
 {
     // Only set value when not updated from hardware
-    KeyboardBacklight::setBrightness(value);
+    // Intermediate drag positions are coalesced; see handleWriteCommitted()
+    DaemonWriter *writer = daemonWriter.get();
+    DeviceControl *control = deviceControls->find(DeviceControls::keyboard_backlight);
+    writeScheduler->schedule(DeviceControls::keyboard_backlight, QString::number(value),
+                             [writer, control](const QString& level) {
+                                 return writer->set(control, level, [&level] {
+                                     return AttributeTable::trySet<AttributeTable::KeyboardBrightness>(level.toInt());
+                                 });
+                             });
     ui->statusbar->showMessage("Keyboard backlight brightness set to " + QString::number(value));
 }
 
 void MainWindow::onComboPerformanceModeCurrentTextChanged(const QString &text)
 {
-    PerformanceMode::setPerformanceMode(text);
+    writeControl(DeviceControls::performance_mode, text);
     ui->statusbar->showMessage("Performance mode set to " + text);
 }
 
@@ -176,7 +555,14 @@ void MainWindow::onHsliderBatteryChargeEndThresholdValueChanged(int value)
         ui->hsliderBatteryChargeEndThreshold->blockSignals(false);
     }
     
-    BatteryChargeControl::setChargeEndThreshold(adjustedValue);
+    DaemonWriter *writer = daemonWriter.get();
+    DeviceControl *control = deviceControls->find(DeviceControls::charge_end_threshold);
+    writeScheduler->schedule(DeviceControls::charge_end_threshold, QString::number(adjustedValue),
+                             [writer, control](const QString& threshold) {
+                                 return writer->set(control, threshold, [&threshold] {
+                                     return AttributeTable::trySet<AttributeTable::ChargeEndThreshold>(threshold.toInt());
+                                 });
+                             });
     ui->statusbar->showMessage("Battery charge end threshold set to " + QString::number(adjustedValue) + "%");
 }
 
@@ -185,7 +571,7 @@ void MainWindow::onCboxPowerOnLidOpenStateChanged(int state)
     // Qt checkbox states: 0=Unchecked, 1=PartiallyChecked, 2=Checked
     // Convert to boolean: 0=false, non-zero=true
     int booleanValue = (state == Qt::Checked) ? 1 : 0;
-    power_on_lid_open.set(booleanValue);
+    writeControl("power_on_lid_open", QString::number(booleanValue));
     ui->statusbar->showMessage("Power on lid open set to " + QString::number(booleanValue));
 }
 
@@ -194,7 +580,7 @@ void MainWindow::onCboxUsbChargingStateChanged(int state)
     // Qt checkbox states: 0=Unchecked, 1=PartiallyChecked, 2=Checked
     // Convert to boolean: 0=false, non-zero=true
     int booleanValue = (state == Qt::Checked) ? 1 : 0;
-    usb_charging.set(booleanValue);
+    writeControl("usb_charging", QString::number(booleanValue));
     ui->statusbar->showMessage("Usb charging set to " + QString::number(booleanValue));
 }
 
@@ -203,97 +589,167 @@ void MainWindow::onCboxBlockRecordingStateChanged(int state)
     // Qt checkbox states: 0=Unchecked, 1=PartiallyChecked, 2=Checked
     // Convert to boolean: 0=false, non-zero=true
     int booleanValue = (state == Qt::Checked) ? 1 : 0;
-    block_recording.set(booleanValue);
+    writeControl("block_recording", QString::number(booleanValue));
     ui->statusbar->showMessage("Block recording set to " + QString::number(booleanValue));
 }
 
-void MainWindow::onFileChanged(const QString &path)
-{
-    // Determine which file was changed based on file path
-    if (KeyboardBacklight::isHwChangedMonitoringSupported() && 
-        path == KeyboardBacklight::getHwChangedFilePath()) {
-        // Handle keyboard backlight changes
-        ui->hsliderKeyboardBacklight->blockSignals(true);
-        try {
-            int currentBrightness = KeyboardBacklight::getBrightness();
-            qDebug() << "onFileChanged - Keyboard brightness: " << currentBrightness;
-            ui->hsliderKeyboardBacklight->setValue(currentBrightness);
-            ui->statusbar->showMessage("Keyboard backlight changed to " + QString::number(currentBrightness));
-        } catch (const std::exception& e) {
-            qDebug() << "Error: " << __FUNCTION__ << " brightness " << e.what();
+void MainWindow::watchControl(const QString& name, const QString& value)
+{
+    DeviceControl *control = deviceControls->find(name);
+    if (!control) {
+        return;
+    }
+    // A value the user set since the first paint is newer than the probe
+    if (!stateCache.contains(name)) {
+        stateCache.prime(name, value, control->notifiesOwnWrites());
+    }
+    changeDispatcher->watch(control->monitoringFilePath(), [this, name] { handleControlChanged(name); }, name);
+}
+
+void MainWindow::handleControlChanged(const QString& name)
+{
+    GALAXYBOOK_TRACE_EVENT(Metrics::attribute(name), Notification);
+    // A value the user is still setting wins over what the file says now;
+    // the file is read again once the write has landed
+    if (writeScheduler->isBusy(name) || profileInFlight) {
+        deferredChanges.insert(name);
+        return;
+    }
+    refreshControl(name);
+}
+
+void MainWindow::refreshControl(const QString& name)
+{
+    DeviceControl *control = deviceControls->find(name);
+    if (!control) {
+        return;
+    }
+    // Reads and writes of a control share its lane and their replies arrive
+    // in lane order, so a value read is never older than a write recorded
+    hardwareWorker->get(control, this, [this, name](const HardwareReply& reply) {
+        if (!reply.ok) {
+            qDebug() << "Error: refreshControl " << name << " " << reply.error;
+            return;
         }
-        ui->hsliderKeyboardBacklight->blockSignals(false);
-    }
-    else if (PerformanceMode::isSupported() && 
-             path == PerformanceMode::getMonitoringFilePath()) {
-        // Handle performance mode changes
-        ui->comboPerformanceMode->blockSignals(true);
-        try {
-            QString currentPerformanceMode = PerformanceMode::getPerformanceMode();
-            ui->comboPerformanceMode->setCurrentText(currentPerformanceMode);
-            ui->statusbar->showMessage("Performance mode changed to " + currentPerformanceMode);
-        } catch (const std::exception& e) {
-            qDebug() << "Error: " << __FUNCTION__ << " performance mode " << e.what();
+        QString previous = stateCache.value(name);
+        bool echo = false;
+        if (stateCache.update(name, reply.value, &echo)) {
+            GALAXYBOOK_TRACE_EVENT(Metrics::attribute(name), HardwareChange);
+            changeJournal.append(name, previous, reply.value, ChangeJournal::Origin::Hardware);
+            showControl(name, reply.value);
+        } else if (echo) {
+            GALAXYBOOK_TRACE_EVENT(Metrics::attribute(name), EchoSuppressed);
         }
-        ui->comboPerformanceMode->blockSignals(false);
+    });
+}
+
+void MainWindow::writeControl(const QString& name, const QString& value)
+{
+    DeviceControl *control = deviceControls->find(name);
+    if (!control) {
+        return;
     }
-    else if (BatteryChargeControl::isSupported() && 
-             path == BatteryChargeControl::getMonitoringFilePath()) {
-        // Handle battery charge threshold changes
-        ui->hsliderBatteryChargeEndThreshold->blockSignals(true);
-        try {
-            int currentThreshold = BatteryChargeControl::getChargeEndThreshold();
-            int adjustedThreshold = std::max(30, (currentThreshold / 10) * 10);
-            ui->hsliderBatteryChargeEndThreshold->setValue(adjustedThreshold);
-            ui->statusbar->showMessage("Battery charge end threshold changed to " + QString::number(currentThreshold) + "%");
-        } catch (const std::exception& e) {
-            qDebug() << "Error: " << __FUNCTION__ << " battery threshold " << e.what();
+    DaemonWriter *writer = daemonWriter.get();
+    quint64 generation = stateCache.generation(name);
+    bool queued = hardwareWorker->submitChecked(name, [writer, control, value]() -> ControlResult<QString> {
+        ControlStatus status = writer->set(control, value);
+        if (!status.ok()) {
+            return status;
         }
-        ui->hsliderBatteryChargeEndThreshold->blockSignals(false);
+        return QString();
+    }, this, [this, control, name, value, generation](const HardwareReply& reply) {
+        if (reply.ok) {
+            // A change read while the write was queued landed before it
+            bool overtaken = stateCache.generation(name) != generation;
+            journalChange(name, value, ChangeJournal::Origin::Application);
+            stateCache.recordWrite(name, value);
+            if (overtaken) {
+                showControl(name, value);
+            }
+            return;
+        }
+        QString error = control->failureMessage(reply.status, value);
+        qDebug() << "Error: writeControl " << name << " " << error;
+        ui->statusbar->showMessage("Could not set " + name + " to " + value + ": " + error);
+        // Put the widget back, then read what the hardware kept
+        showControl(name, stateCache.value(name));
+        refreshControl(name);
+    });
+    if (!queued) {
+        ui->statusbar->showMessage("Hardware is busy; " + name + " was not changed");
+        showControl(name, stateCache.value(name));
     }
-    else if (power_on_lid_open.isSupported() && 
-             path == power_on_lid_open.getMonitoringFilePath()) {
-        handleFirmwareAttributeFileChanged(path, power_on_lid_open, *ui->cboxPowerOnLidOpen, "Power on lid open");
+}
+
+void MainWindow::showControl(const QString& name, const QString& value)
+{
+    auto it = widgetUpdaters.constFind(name);
+    if (it != widgetUpdaters.constEnd()) {
+        it.value()(value);
     }
-    else if (usb_charging.isSupported() && 
-             path == usb_charging.getMonitoringFilePath()) {
-        handleFirmwareAttributeFileChanged(path, usb_charging, *ui->cboxUsbCharging, "USB charging");
+}
+
+void MainWindow::journalChange(const QString& name, const QString& value, ChangeJournal::Origin origin)
+{
+    QString previous = stateCache.value(name);
+    if (previous != value) {
+        changeJournal.append(name, previous, value, origin, static_cast<quint32>(QCoreApplication::applicationPid()));
     }
-    else if (block_recording.isSupported() && 
-             path == block_recording.getMonitoringFilePath()) {
-        handleFirmwareAttributeFileChanged(path, block_recording, *ui->cboxBlockRecording, "Block recording");
+}
+
+void MainWindow::handleWriteCommitted(const QString& name, const QString& value, bool ok, const QString& error)
+{
+    if (ok) {
+        journalChange(name, value, ChangeJournal::Origin::Application);
+        stateCache.recordWrite(name, value);
+    } else {
+        qDebug() << "Error: " << __FUNCTION__ << " " << name << " " << error;
+        // Put the widget back to the last value the hardware accepted
+        if (!writeScheduler->isBusy(name)) {
+            showControl(name, stateCache.value(name));
+        }
+        ui->statusbar->showMessage("Could not set " + name + " to " + value + ": " + error);
     }
-    
-    // Re-add file monitoring (file may be deleted and recreated on some systems)
-    if (!fileWatcher->files().contains(path)) {
-        fileWatcher->addPath(path);
+    // Changes that arrived while the user was setting it
+    if (!writeScheduler->isBusy(name) && !profileInFlight && deferredChanges.remove(name)) {
+        refreshControl(name);
     }
 }
 
-// Generic function to handle hardware changes for firmware attributes
-void MainWindow::handleFirmwareAttributeFileChanged(const QString &path, 
-                                                  FirmwareAttribute& attribute,
-                                                  QCheckBox& checkbox,
-                                                  const QString& featureName)
+void MainWindow::showKeyboardBacklight(const QString& value)
 {
-    Q_UNUSED(path);
-    
-    // Block signals to prevent infinite loop
+    int currentBrightness = value.toInt();
+    qDebug() << "onFileChanged - Keyboard brightness: " << currentBrightness;
+    ui->hsliderKeyboardBacklight->blockSignals(true);
+    ui->hsliderKeyboardBacklight->setValue(currentBrightness);
+    ui->hsliderKeyboardBacklight->blockSignals(false);
+    ui->statusbar->showMessage("Keyboard backlight changed to " + value);
+}
+
+void MainWindow::showPerformanceMode(const QString& value)
+{
+    ui->comboPerformanceMode->blockSignals(true);
+    ui->comboPerformanceMode->setCurrentText(value);
+    ui->comboPerformanceMode->blockSignals(false);
+    ui->statusbar->showMessage("Performance mode changed to " + value);
+}
+
+void MainWindow::showBatteryChargeEndThreshold(const QString& value)
+{
+    int currentThreshold = value.toInt();
+    int adjustedThreshold = std::max(30, (currentThreshold / 10) * 10);
+    ui->hsliderBatteryChargeEndThreshold->blockSignals(true);
+    ui->hsliderBatteryChargeEndThreshold->setValue(adjustedThreshold);
+    ui->hsliderBatteryChargeEndThreshold->blockSignals(false);
+    ui->statusbar->showMessage("Battery charge end threshold changed to " + value + "%");
+}
+
+// Generic function to show hardware changes of firmware attributes
+void MainWindow::showFirmwareAttribute(QCheckBox& checkbox, const QString& featureName, const QString& value)
+{
+    // Block signals to prevent writing the value straight back
     checkbox.blockSignals(true);
-    
-    try {
-        int currentValue = attribute.get();
-        checkbox.setChecked(currentValue != 0);
-        ui->statusbar->showMessage(featureName + " changed to " + QString::number(currentValue));
-    } catch (const std::exception& e) {
-        qDebug() << "Error: " << __FUNCTION__ << " " << e.what();
-    }
-    
-    // Unblock signals
+    checkbox.setChecked(value.toInt() != 0);
     checkbox.blockSignals(false);
-    
-    // Re-add file monitoring (file may be deleted and recreated on some systems)
-    if (!fileWatcher->files().contains(path)) {
-        fileWatcher->addPath(path);
-    }
+    ui->statusbar->showMessage(featureName + " changed to " + value);
 }
@@ -2,11 +2,22 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QFileSystemWatcher>
 #include <QCheckBox>
-#include <memory>
+#include <QHash>
+#include <QSet>
 #include <functional>
-#include "FirmwareAttribute.h"
+#include <memory>
+#include "CapabilitySnapshot.h"
+#include "ChangeJournal.h"
+#include "Profiles.h"
+#include "StateCache.h"
+
+class ChangeDispatcher;
+class DaemonWriter;
+class DeviceControls;
+class HardwareWorker;
+class UeventMonitor;
+class WriteScheduler;
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -22,6 +33,21 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // Last known values, handed to the tray when the window goes away
+    const StateCache& cache() const { return stateCache; }
+    // Commits what the user is still changing and waits for every queued
+    // write to complete, so cache() and the journal include them
+    void finishWrites();
+
+signals:
+    // Startup milestones, for measurements: the window has been painted
+    // once, and every widget reflects the probed hardware and is live
+    void firstPainted();
+    void startupFinished();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
 public slots:
     // User interface slots
     void onHsliderKeyboardBacklightValueChanged(int value);
@@ -31,33 +57,92 @@ public slots:
     void onCboxUsbChargingStateChanged(int state);
     void onCboxBlockRecordingStateChanged(int state);
 
-    // File change monitoring slots
-    void onFileChanged(const QString &path);
-
 private:
     Ui::MainWindow *ui;
-    std::unique_ptr<QFileSystemWatcher> fileWatcher;
+    ChangeDispatcher *changeDispatcher;
+    UeventMonitor *hotplugMonitor;
+    std::unique_ptr<DeviceControls> deviceControls;
+    // Writes go through galaxybook-controld when it runs
+    std::unique_ptr<DaemonWriter> daemonWriter;
+    // All hardware access after startup goes through the worker, so the
+    // window never waits for the firmware. Destroyed before the controls.
+    std::unique_ptr<HardwareWorker> hardwareWorker;
+    std::unique_ptr<WriteScheduler> writeScheduler;
+    // Last known value of every watched control; see handleControlChanged()
+    StateCache stateCache;
+    // History of every change the window made or saw
+    ChangeJournal changeJournal;
+    QHash<QString, std::function<void(const QString&)>> widgetUpdaters;
+    // Notifications that arrive while a profile is being applied or the
+    // user is setting the control; read once that is done
+    bool profileInFlight = false;
+    QSet<QString> deferredChanges;
+
+    bool painted = false;
+
+    // Rows built at runtime for firmware attributes without a fixed widget
+    struct DiscoveredWidget
+    {
+        QWidget *row = nullptr;
+        // Sets the value without writing it back or touching the status bar
+        std::function<void(const QString&)> setValue;
+    };
+    QHash<QString, DiscoveredWidget> discoveredWidgets;
 
-    FirmwareAttribute power_on_lid_open;
-    FirmwareAttribute usb_charging;
-    FirmwareAttribute block_recording;
+    // Static widget setup and signal connections; widgets stay disabled
+    // until a snapshot says the feature exists
+    void setupUiKeyboardBacklight();
+    void setupUiPerformanceMode();
+    void setupUiBatteryChargeEndThreshold();
+    void setupUiPowerOnLidOpen();
+    void setupUiUsbCharging();
+    void setupUiBlockRecording();
+    void setupUiProfiles();
+    void setupUiBatteryHealth();
 
-    bool setupUiKeyboardBacklight();
-    bool setupUiPerformanceMode();
-    bool setupUiBatteryChargeEndThreshold();
-    bool setupUiPowerOnLidOpen();
-    bool setupUiUsbCharging();
-    bool setupUiBlockRecording();
+    // Startup: paint from the cached snapshot, then probe on the worker
+    // and patch the window with what the hardware reports
+    void startProbe(const CapabilitySnapshot& cached);
+    void handleProbed(const CapabilitySnapshot& probed, const CapabilitySnapshot& cached);
+    // Devices came or went: probe again and enable or disable widgets
+    void startHotplugProbe();
+    void handleHotplugProbed(const CapabilitySnapshot& probed);
+    void applySnapshot(const CapabilitySnapshot& snapshot);
+    void configureKeyboardBacklight(const CapabilitySnapshot::Entry *entry);
+    void configurePerformanceMode(const CapabilitySnapshot::Entry *entry);
+    void configureBatteryChargeEndThreshold(const CapabilitySnapshot::Entry *entry);
+    void configureFirmwareAttribute(QCheckBox& checkbox, const CapabilitySnapshot::Entry *entry);
+    void configureDiscoveredControl(const CapabilitySnapshot::Entry& entry);
+    // A checkbox for "0 1", a spin box for "min..max", a combo box otherwise
+    DiscoveredWidget createDiscoveredWidget(const CapabilitySnapshot::Entry& entry);
+    // False once the user has changed name, so a late probe leaves it alone
+    bool untouched(const QString& name) const;
+
+    void applyProfile(const QString& name);
+    void handleProfileApplied(const QString& name, const Profile& profile, const ProfileApplier::Result& result);
+    void saveProfile();
 
     // Generic function to setup checkbox-based firmware attributes
-    bool setupUiFirmwareAttribute(FirmwareAttribute& attribute, 
-                                 QCheckBox& checkbox, 
-                                 std::function<void(int)> stateChangeSlot);
-    
-    // Generic function to handle file changes for firmware attributes
-    void handleFirmwareAttributeFileChanged(const QString &path, 
-                                          FirmwareAttribute& attribute,
-                                          QCheckBox& checkbox,
-                                          const QString& featureName);
+    void setupUiFirmwareAttribute(const QString& name,
+                                  QCheckBox& checkbox,
+                                  const QString& featureName,
+                                  std::function<void(int)> stateChangeSlot);
+
+    // Watches a control's monitoring file, starting from the probed value;
+    // changes reach the widget through widgetUpdaters
+    void watchControl(const QString& name, const QString& value);
+    void handleControlChanged(const QString& name);
+    void refreshControl(const QString& name);
+    void writeControl(const QString& name, const QString& value);
+    void showControl(const QString& name, const QString& value);
+    // Call before the state cache takes value, so the old value is known
+    void journalChange(const QString& name, const QString& value, ChangeJournal::Origin origin);
+    void handleWriteCommitted(const QString& name, const QString& value, bool ok, const QString& error);
+
+    // Widget updates for values that changed outside this window
+    void showKeyboardBacklight(const QString& value);
+    void showPerformanceMode(const QString& value);
+    void showBatteryChargeEndThreshold(const QString& value);
+    void showFirmwareAttribute(QCheckBox& checkbox, const QString& featureName, const QString& value);
 };
 #endif // MAINWINDOW_H
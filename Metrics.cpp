@@ -0,0 +1,252 @@
+#include "Metrics.h"
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QVector>
+#include <algorithm>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+std::atomic<bool> Metrics::recording{false};
+std::atomic<bool> Metrics::capturing{false};
+
+namespace {
+
+const char* const op_names[Metrics::op_count] = {"read", "write", "validate", "dispatch"};
+const char* const event_names[Metrics::event_count] = {"notification", "echo_suppressed", "hardware_change"};
+
+struct Registry
+{
+    QMutex mutex;
+    QHash<QString, Metrics::Attribute *> attributes;
+    // Registration order, so the export is stable between scrapes
+    QVector<Metrics::Attribute *> ordered;
+};
+
+Registry& registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+struct CaptureEvent
+{
+    Metrics::Attribute *attribute;
+    Metrics::Op op;
+    bool ok;
+    int tid;
+    int64_t start_ns;
+    int64_t end_ns;
+};
+
+struct Capture
+{
+    QMutex mutex;
+    std::vector<CaptureEvent> events;
+    size_t max_events = 0;
+};
+
+Capture& capture()
+{
+    static Capture instance;
+    return instance;
+}
+
+int threadId()
+{
+    static thread_local int tid = static_cast<int>(::syscall(SYS_gettid));
+    return tid;
+}
+
+// Index of the smallest bound 2^i us that is >= ns
+int bucketFor(int64_t ns)
+{
+    uint64_t us = ns > 0 ? (static_cast<uint64_t>(ns) + 999) / 1000 : 0;
+    if (us <= 1) {
+        return 0;
+    }
+    int bucket = 64 - __builtin_clzll(us - 1);
+    return bucket < Metrics::bucket_count - 1 ? bucket : Metrics::bucket_count - 1;
+}
+
+QByteArray label(const QString& value)
+{
+    QByteArray text = value.toUtf8();
+    text.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+    return text;
+}
+
+} // namespace
+
+bool Metrics::compiledIn()
+{
+#ifdef GALAXYBOOK_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Metrics::setEnabled(bool on)
+{
+    recording.store(on, std::memory_order_relaxed);
+}
+
+Metrics::Attribute *Metrics::attribute(const QString& name)
+{
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    Attribute *&entry = r.attributes[name];
+    if (!entry) {
+        entry = new Attribute;
+        entry->name = name;
+        r.ordered.append(entry);
+    }
+    return entry;
+}
+
+int64_t Metrics::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void Metrics::record(Attribute *attribute, Op op, int64_t start_ns, int64_t end_ns, bool ok)
+{
+    Histogram& histogram = attribute->ops[static_cast<int>(op)];
+    int64_t duration = end_ns - start_ns;
+    histogram.buckets[bucketFor(duration)].fetch_add(1, std::memory_order_relaxed);
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+    histogram.sum_ns.fetch_add(static_cast<quint64>(duration > 0 ? duration : 0), std::memory_order_relaxed);
+    if (!ok) {
+        histogram.errors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (Q_UNLIKELY(capturing.load(std::memory_order_relaxed))) {
+        Capture& c = capture();
+        QMutexLocker locker(&c.mutex);
+        if (c.events.size() < c.max_events) {
+            c.events.push_back({attribute, op, ok, threadId(), start_ns, end_ns});
+        }
+    }
+}
+
+void Metrics::count(Attribute *attribute, Event event)
+{
+    attribute->events[static_cast<int>(event)].fetch_add(1, std::memory_order_relaxed);
+}
+
+QByteArray Metrics::prometheusText()
+{
+    QVector<Attribute *> attributes;
+    {
+        Registry& r = registry();
+        QMutexLocker locker(&r.mutex);
+        attributes = r.ordered;
+    }
+
+    QByteArray text;
+    if (!compiledIn()) {
+        text += "# galaxybook-control was built without CONFIG+=galaxybook_trace\n";
+    }
+
+    text += "# HELP galaxybook_operation_duration_seconds Latency of attribute reads, writes, validations and change dispatches.\n"
+            "# TYPE galaxybook_operation_duration_seconds histogram\n";
+    for (Attribute *attribute : attributes) {
+        for (int op = 0; op < op_count; ++op) {
+            const Histogram& histogram = attribute->ops[op];
+            quint64 count = histogram.count.load(std::memory_order_relaxed);
+            if (count == 0) {
+                continue;
+            }
+            QByteArray labels = "attribute=\"" + label(attribute->name) + "\",op=\"" + op_names[op] + "\"";
+            quint64 cumulative = 0;
+            for (int bucket = 0; bucket < bucket_count; ++bucket) {
+                cumulative += histogram.buckets[bucket].load(std::memory_order_relaxed);
+                QByteArray bound = bucket == bucket_count - 1 ? QByteArray("+Inf")
+                                                              : QByteArray::number((1ULL << bucket) / 1e6, 'g', 9);
+                text += "galaxybook_operation_duration_seconds_bucket{" + labels + ",le=\"" + bound + "\"} "
+                      + QByteArray::number(cumulative) + "\n";
+            }
+            text += "galaxybook_operation_duration_seconds_sum{" + labels + "} "
+                  + QByteArray::number(histogram.sum_ns.load(std::memory_order_relaxed) / 1e9, 'g', 12) + "\n";
+            text += "galaxybook_operation_duration_seconds_count{" + labels + "} " + QByteArray::number(count) + "\n";
+        }
+    }
+
+    text += "# HELP galaxybook_operation_errors_total Operations that failed.\n"
+            "# TYPE galaxybook_operation_errors_total counter\n";
+    for (Attribute *attribute : attributes) {
+        for (int op = 0; op < op_count; ++op) {
+            if (attribute->ops[op].count.load(std::memory_order_relaxed) == 0) {
+                continue;
+            }
+            text += "galaxybook_operation_errors_total{attribute=\"" + label(attribute->name) + "\",op=\"" + op_names[op]
+                  + "\"} " + QByteArray::number(attribute->ops[op].errors.load(std::memory_order_relaxed)) + "\n";
+        }
+    }
+
+    text += "# HELP galaxybook_events_total Change notifications and how they were resolved.\n"
+            "# TYPE galaxybook_events_total counter\n";
+    for (Attribute *attribute : attributes) {
+        for (int event = 0; event < event_count; ++event) {
+            quint64 value = attribute->events[event].load(std::memory_order_relaxed);
+            if (value == 0) {
+                continue;
+            }
+            text += "galaxybook_events_total{attribute=\"" + label(attribute->name) + "\",event=\"" + event_names[event]
+                  + "\"} " + QByteArray::number(value) + "\n";
+        }
+    }
+    return text;
+}
+
+bool Metrics::writePrometheus(const QString& path)
+{
+    // Atomic replace, so a textfile collector never reads half a file
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(prometheusText());
+    return file.commit();
+}
+
+void Metrics::startCapture(int max_events)
+{
+    Capture& c = capture();
+    QMutexLocker locker(&c.mutex);
+    c.events.clear();
+    c.events.reserve(static_cast<size_t>(std::min(max_events, 1 << 16)));
+    c.max_events = static_cast<size_t>(max_events);
+    capturing.store(true, std::memory_order_relaxed);
+}
+
+QByteArray Metrics::stopCapture()
+{
+    capturing.store(false, std::memory_order_relaxed);
+    std::vector<CaptureEvent> events;
+    {
+        Capture& c = capture();
+        QMutexLocker locker(&c.mutex);
+        events.swap(c.events);
+    }
+
+    const QByteArray pid = QByteArray::number(static_cast<qint64>(::getpid()));
+    QByteArray json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const CaptureEvent& event = events[i];
+        json += "{\"name\":\"" + QByteArray(op_names[static_cast<int>(event.op)]) + " " + label(event.attribute->name)
+              + "\",\"cat\":\"hardware\",\"ph\":\"X\",\"pid\":" + pid
+              + ",\"tid\":" + QByteArray::number(event.tid)
+              + ",\"ts\":" + QByteArray::number(event.start_ns / 1e3, 'f', 3)
+              + ",\"dur\":" + QByteArray::number((event.end_ns - event.start_ns) / 1e3, 'f', 3)
+              + ",\"args\":{\"ok\":" + (event.ok ? "true" : "false") + "}}"
+              + (i + 1 < events.size() ? ",\n" : "\n");
+    }
+    json += "]}\n";
+    return json;
+}
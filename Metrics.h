@@ -0,0 +1,115 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <cstdint>
+
+// Latency histograms, error and event counters per hardware attribute,
+// exported as Prometheus text, plus an optional Chrome trace-event capture.
+//
+// Instrumentation is compiled in only with CONFIG+=galaxybook_trace (which
+// defines GALAXYBOOK_TRACE); otherwise the macros below expand to nothing.
+// When compiled in, recording is still off until setEnabled(true), and an
+// instrumented call then costs one relaxed load and a predicted branch.
+class Metrics
+{
+public:
+    enum class Op { Read, Write, Validate, Dispatch };
+    enum class Event { Notification, EchoSuppressed, HardwareChange };
+    static constexpr int op_count = 4;
+    static constexpr int event_count = 3;
+    // Upper bounds 1 us, 2 us, 4 us ... 2^20 us (about 1 s), then +Inf
+    static constexpr int bucket_count = 22;
+
+    struct Histogram
+    {
+        std::atomic<quint64> buckets[bucket_count] = {};
+        std::atomic<quint64> count{0};
+        std::atomic<quint64> sum_ns{0};
+        std::atomic<quint64> errors{0};
+    };
+
+    // Registered once and never freed, so call sites can keep the pointer
+    struct Attribute
+    {
+        QString name;
+        Histogram ops[op_count];
+        std::atomic<quint64> events[event_count] = {};
+    };
+
+    static bool compiledIn();
+    static bool enabled() { return Q_UNLIKELY(recording.load(std::memory_order_relaxed)); }
+    static void setEnabled(bool on);
+
+    static Attribute *attribute(const QString& name);
+    static int64_t now();
+
+    static void record(Attribute *attribute, Op op, int64_t start_ns, int64_t end_ns, bool ok);
+    static void count(Attribute *attribute, Event event);
+
+    // Prometheus text exposition format, version 0.0.4
+    static QByteArray prometheusText();
+    static bool writePrometheus(const QString& path);
+
+    // Keeps every recorded operation as a trace event until stopCapture(),
+    // up to max_events
+    static void startCapture(int max_events = 1 << 20);
+    // Chrome trace-event JSON, loadable in chrome://tracing or Perfetto
+    static QByteArray stopCapture();
+
+private:
+    static std::atomic<bool> recording;
+    static std::atomic<bool> capturing;
+
+    Metrics() = delete;
+};
+
+// Times one operation on an attribute; call fail() on the error path
+class TraceScope
+{
+public:
+    TraceScope(Metrics::Attribute *attribute, Metrics::Op op)
+        : attribute(Metrics::enabled() ? attribute : nullptr)
+        , op(op)
+        , start(this->attribute ? Metrics::now() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (attribute) {
+            Metrics::record(attribute, op, start, Metrics::now(), ok);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    void fail() { ok = false; }
+
+private:
+    Metrics::Attribute *attribute;
+    Metrics::Op op;
+    int64_t start;
+    bool ok = true;
+};
+
+#ifdef GALAXYBOOK_TRACE
+// The attribute for a fixed name, registered on first use at this call site
+#define GALAXYBOOK_TRACE_ATTRIBUTE(name) \
+    ([]() { static Metrics::Attribute *const attribute = Metrics::attribute(name); return attribute; }())
+#define GALAXYBOOK_TRACE_SCOPE(scope, attribute, op) TraceScope scope((attribute), Metrics::Op::op)
+#define GALAXYBOOK_TRACE_FAIL(scope) scope.fail()
+#define GALAXYBOOK_TRACE_EVENT(attribute, event) \
+    do { if (Metrics::enabled()) Metrics::count((attribute), Metrics::Event::event); } while (0)
+#else
+#define GALAXYBOOK_TRACE_ATTRIBUTE(name) nullptr
+#define GALAXYBOOK_TRACE_SCOPE(scope, attribute, op) static_cast<void>(0)
+#define GALAXYBOOK_TRACE_FAIL(scope) static_cast<void>(0)
+#define GALAXYBOOK_TRACE_EVENT(attribute, event) static_cast<void>(0)
+#endif
+
+#endif // METRICS_H
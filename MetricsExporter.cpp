@@ -0,0 +1,225 @@
+#include "MetricsExporter.h"
+#include "Metrics.h"
+#include <QDeadlineTimer>
+#include <QFile>
+#include <QSocketNotifier>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+MetricsExporter::MetricsExporter(QObject *parent)
+    : QObject(parent)
+{
+    connect(&fileTimer, &QTimer::timeout, this, [this] { Metrics::writePrometheus(filePath); });
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    close();
+}
+
+bool MetricsExporter::listen(const QString& socket_path)
+{
+    QByteArray native = QFile::encodeName(socket_path);
+    struct sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (native.size() >= static_cast<int>(sizeof(address.sun_path))) {
+        error = "Socket path is too long: " + socket_path;
+        return false;
+    }
+    std::memcpy(address.sun_path, native.constData(), native.size());
+
+    // As in ControlServer::listen: only a socket nobody accepts on is stale
+    int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (probe < 0) {
+        error = QString("Cannot create socket: %1").arg(strerror(errno));
+        return false;
+    }
+    int connected = ::connect(probe, reinterpret_cast<struct sockaddr *>(&address), sizeof(address));
+    int connect_error = errno;
+    ::close(probe);
+    if (connected == 0 || connect_error == EAGAIN) {
+        error = "Metrics are already served on " + socket_path;
+        return false;
+    }
+    if (connect_error == ECONNREFUSED) {
+        ::unlink(native.constData());
+    }
+
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        error = QString("Cannot create socket: %1").arg(strerror(errno));
+        return false;
+    }
+    if (::bind(listen_fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0
+        || ::listen(listen_fd, 16) != 0) {
+        error = QString("Cannot listen on %1: %2").arg(socket_path, strerror(errno));
+        ::close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    ::chmod(native.constData(), 0660);
+    socketPath = socket_path;
+
+    acceptNotifier = new QSocketNotifier(listen_fd, QSocketNotifier::Read, this);
+    connect(acceptNotifier, &QSocketNotifier::activated, this, &MetricsExporter::onNewConnection);
+    return true;
+}
+
+bool MetricsExporter::writeFile(const QString& path, int interval_ms)
+{
+    filePath = path;
+    if (!Metrics::writePrometheus(path)) {
+        error = "Cannot write " + path;
+        return false;
+    }
+    fileTimer.start(interval_ms);
+    return true;
+}
+
+void MetricsExporter::close()
+{
+    fileTimer.stop();
+    if (!filePath.isEmpty()) {
+        Metrics::writePrometheus(filePath);
+    }
+    while (!clients.empty()) {
+        drop(clients.front().get());
+    }
+    delete acceptNotifier;
+    acceptNotifier = nullptr;
+    if (listen_fd >= 0) {
+        ::close(listen_fd);
+        listen_fd = -1;
+        ::unlink(QFile::encodeName(socketPath).constData());
+    }
+}
+
+namespace {
+
+// A scraper that has not finished by then is dropped
+constexpr qint64 client_timeout_ms = 10000;
+// Requests are not parsed; this much is enough for any scrape's headers
+constexpr int max_request = 8192;
+
+} // namespace
+
+void MetricsExporter::onNewConnection()
+{
+    // Clients that stalled are only noticed here; there are few scrapers
+    const qint64 now = QDeadlineTimer::current().deadline();
+    for (size_t i = clients.size(); i-- > 0;) {
+        if (now - clients[i]->accepted_ms > client_timeout_ms) {
+            drop(clients[i].get());
+        }
+    }
+
+    for (;;) {
+        int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+
+        auto client = std::make_unique<Client>();
+        Client *raw = client.get();
+        raw->fd = fd;
+        raw->accepted_ms = now;
+        raw->reader = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+        raw->writer = new QSocketNotifier(fd, QSocketNotifier::Write, this);
+        raw->writer->setEnabled(false);
+        connect(raw->reader, &QSocketNotifier::activated, this, [this, raw] { onReadable(raw); });
+        connect(raw->writer, &QSocketNotifier::activated, this, [this, raw] { onWritable(raw); });
+        clients.push_back(std::move(client));
+    }
+}
+
+void MetricsExporter::onReadable(Client *client)
+{
+    // The request is not parsed: every connection gets the metrics. It is
+    // still read, since closing with unread input resets the connection
+    // before the client sees the reply.
+    char buffer[4096];
+    bool closed = false;
+    for (;;) {
+        ssize_t length = ::read(client->fd, buffer, sizeof(buffer));
+        if (length == 0) {
+            closed = true;
+            break;
+        }
+        if (length < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                break;
+            }
+            drop(client);
+            return;
+        }
+        if (!client->answered && client->input.size() < max_request) {
+            client->input.append(buffer, length);
+        }
+    }
+
+    if (client->answered) {
+        // Our side is shut down; the client closing ends the connection
+        if (closed) {
+            drop(client);
+        }
+        return;
+    }
+    if (!closed && !client->input.contains("\r\n\r\n") && !client->input.contains("\n\n")
+        && client->input.size() < max_request) {
+        return;
+    }
+
+    client->answered = true;
+    client->input.clear();
+    QByteArray body = Metrics::prometheusText();
+    client->output = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+                   + QByteArray::number(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+    if (closed) {
+        // Nothing more will arrive; stop polling for the end of input
+        client->reader->setEnabled(false);
+    }
+    onWritable(client);
+}
+
+void MetricsExporter::onWritable(Client *client)
+{
+    while (!client->output.isEmpty()) {
+        ssize_t written = ::send(client->fd, client->output.constData(), client->output.size(), MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                client->writer->setEnabled(true);
+                return;
+            }
+            drop(client);
+            return;
+        }
+        client->output.remove(0, written);
+    }
+
+    client->writer->setEnabled(false);
+    ::shutdown(client->fd, SHUT_WR);
+    if (!client->reader->isEnabled()) {
+        drop(client);
+    }
+}
+
+void MetricsExporter::drop(Client *client)
+{
+    auto it = std::find_if(clients.begin(), clients.end(),
+                           [client](const std::unique_ptr<Client>& c) { return c.get() == client; });
+    if (it == clients.end()) {
+        return;
+    }
+    // Notifiers may be the sender of the slot running right now
+    client->reader->setEnabled(false);
+    client->writer->setEnabled(false);
+    client->reader->deleteLater();
+    client->writer->deleteLater();
+    ::close(client->fd);
+    clients.erase(it);
+}
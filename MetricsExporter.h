@@ -0,0 +1,59 @@
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <memory>
+#include <vector>
+
+class QSocketNotifier;
+
+// Publishes Metrics::prometheusText() without an HTTP server library:
+// rewritten into a file for node_exporter's textfile collector, and served
+// as a minimal HTTP response on a Unix socket, e.g. for
+// curl --unix-socket <path> http://localhost/metrics
+class MetricsExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MetricsExporter(QObject *parent = nullptr);
+    ~MetricsExporter();
+
+    bool listen(const QString& socket_path);
+    // Writes the file now and then every interval_ms
+    bool writeFile(const QString& path, int interval_ms = 15000);
+    void close();
+
+    QString errorString() const { return error; }
+
+private:
+    // One scrape; the socket is non-blocking and driven by the event loop
+    struct Client
+    {
+        int fd = -1;
+        QSocketNotifier *reader = nullptr;
+        QSocketNotifier *writer = nullptr;
+        QByteArray input;
+        QByteArray output;
+        bool answered = false;
+        qint64 accepted_ms = 0;     // monotonic
+    };
+
+    void onNewConnection();
+    void onReadable(Client *client);
+    void onWritable(Client *client);
+    void drop(Client *client);
+
+    int listen_fd = -1;
+    QSocketNotifier *acceptNotifier = nullptr;
+    std::vector<std::unique_ptr<Client>> clients;
+    QString socketPath;
+    QString filePath;
+    QTimer fileTimer;
+    QString error;
+};
+
+#endif // METRICSEXPORTER_H
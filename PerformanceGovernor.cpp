@@ -0,0 +1,241 @@
+#include "PerformanceGovernor.h"
+#include "AttributeTable.h"
+#include "BatteryChargeControl.h"
+#include "SysfsRoot.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <cstring>
+#include <time.h>
+
+namespace {
+
+// Preferred platform_profile choices per tier, best match first
+const char* const tier_preferences[][4] = {
+    {"low-power", "quiet", "cool", nullptr},
+    {"quiet", "low-power", "cool", "balanced"},
+    {"balanced", "balanced-performance", nullptr, nullptr},
+    {"performance", "balanced-performance", "balanced", nullptr},
+};
+
+// online attribute of the first mains power supply, or empty
+QString mainsOnlinePath()
+{
+    const QString supplies = SysfsRoot::path("/sys/class/power_supply");
+    for (const QString& name : QDir(supplies).entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+        QFile type(supplies + "/" + name + "/type");
+        if (type.open(QIODevice::ReadOnly) && type.readAll().trimmed() == "Mains") {
+            return supplies + "/" + name + "/online";
+        }
+    }
+    return QString();
+}
+
+// Parses an unsigned decimal at text, advancing it past the digits
+bool parseField(const char*& text, uint64_t& value)
+{
+    while (*text == ' ') {
+        ++text;
+    }
+    if (*text < '0' || *text > '9') {
+        return false;
+    }
+    value = 0;
+    while (*text >= '0' && *text <= '9') {
+        value = value * 10 + static_cast<uint64_t>(*text - '0');
+        ++text;
+    }
+    return true;
+}
+
+int64_t monotonicMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+} // namespace
+
+GovernorPolicy::GovernorPolicy(const Settings& settings)
+    : settings(settings)
+{
+}
+
+GovernorPolicy::Tier GovernorPolicy::update(const Input& input)
+{
+    // A spike needs about three samples to move the average across a threshold.
+    // Kept in 1/256 % so a steady load is reached exactly, not settled below.
+    const int sample = input.cpu_percent * load_scale;
+    smoothed = smoothed < 0 ? sample : (3 * smoothed + sample + 2) / 4;
+    const int load = smoothedLoad();
+
+    const bool battery_low = !input.on_ac && input.battery_percent >= 0 && input.battery_percent <= settings.low_battery;
+    const bool allow_performance = input.on_ac || settings.performance_on_battery;
+
+    Tier target = decided ? current : Tier::Balanced;
+    if (battery_low) {
+        target = Tier::LowPower;
+    } else if (load >= settings.high_load) {
+        target = allow_performance ? Tier::Performance : Tier::Balanced;
+    } else if (load <= settings.low_load) {
+        target = input.on_ac ? Tier::Quiet : Tier::LowPower;
+    } else if (target == Tier::Performance && !allow_performance) {
+        // Unplugged in the middle of the band
+        target = Tier::Balanced;
+    }
+
+    if (decided && target != current) {
+        // Running out of battery does not wait for the dwell time
+        if (!battery_low && input.now_ms - last_switch_ms < settings.dwell_ms) {
+            return current;
+        }
+    }
+    if (!decided || target != current) {
+        decided = true;
+        current = target;
+        last_switch_ms = input.now_ms;
+    }
+    return current;
+}
+
+const char* GovernorPolicy::tierName(Tier tier)
+{
+    switch (tier) {
+    case Tier::LowPower:
+        return "low-power";
+    case Tier::Quiet:
+        return "quiet";
+    case Tier::Balanced:
+        return "balanced";
+    case Tier::Performance:
+        return "performance";
+    }
+    return "unknown";
+}
+
+CpuLoadSampler::CpuLoadSampler()
+    : stat(SysfsRoot::path("/proc/stat"))
+{
+}
+
+int CpuLoadSampler::sample()
+{
+    if (stat.read(buffer, sizeof(buffer)) < 0 || std::strncmp(buffer, "cpu ", 4) != 0) {
+        return -1;
+    }
+
+    // cpu  user nice system idle iowait irq softirq steal [guest guest_nice]
+    // Guest time is already included in user and nice.
+    const char* text = buffer + 4;
+    uint64_t fields[8];
+    for (uint64_t& field : fields) {
+        if (!parseField(text, field)) {
+            return -1;
+        }
+    }
+    uint64_t total = 0;
+    for (uint64_t field : fields) {
+        total += field;
+    }
+    uint64_t idle = fields[3] + fields[4];
+
+    if (!primed || total < previous_total) {
+        primed = true;
+        previous_total = total;
+        previous_idle = idle;
+        return -1;
+    }
+    uint64_t elapsed = total - previous_total;
+    if (elapsed == 0) {
+        return 0;
+    }
+    uint64_t idle_elapsed = idle >= previous_idle ? idle - previous_idle : 0;
+    previous_total = total;
+    previous_idle = idle;
+    if (idle_elapsed > elapsed) {
+        idle_elapsed = elapsed;
+    }
+    return static_cast<int>(100 * (elapsed - idle_elapsed) / elapsed);
+}
+
+PerformanceGovernor::PerformanceGovernor(const GovernorPolicy::Settings& settings, QObject *parent)
+    : QObject(parent)
+    , governorPolicy(settings)
+    , acOnline(mainsOnlinePath())
+    , batteryCapacity(BatteryChargeControl::getBasePath() + "/capacity")
+{
+    connect(&timer, &QTimer::timeout, this, [this] { tick(monotonicMs()); });
+}
+
+bool PerformanceGovernor::resolveModes()
+{
+    if (resolved) {
+        return true;
+    }
+    ControlResult<QStringList> choices = AttributeTable::tryGet<AttributeTable::PlatformProfileChoices>();
+    const QStringList& modes = choices.value();
+    if (modes.isEmpty()) {
+        return false;
+    }
+    for (int tier = 0; tier < 4; ++tier) {
+        tierModes[tier].clear();
+        for (const char* preference : tier_preferences[tier]) {
+            if (preference && modes.contains(preference)) {
+                tierModes[tier] = preference;
+                break;
+            }
+        }
+        // Nothing suitable: stay with whatever the firmware lists first
+        if (tierModes[tier].isEmpty()) {
+            tierModes[tier] = modes.first();
+        }
+    }
+    resolved = true;
+    return true;
+}
+
+bool PerformanceGovernor::start(int interval_ms)
+{
+    if (!resolveModes()) {
+        return false;
+    }
+    cpu.sample();
+    timer.start(interval_ms);
+    return true;
+}
+
+void PerformanceGovernor::stop()
+{
+    timer.stop();
+}
+
+void PerformanceGovernor::tick(int64_t now_ms)
+{
+    int load = cpu.sample();
+    if (load < 0 || !resolveModes()) {
+        return;
+    }
+
+    GovernorPolicy::Input input;
+    input.now_ms = now_ms;
+    input.cpu_percent = load;
+    int online;
+    input.on_ac = !acOnline.readInt(online) || online != 0;
+    int capacity;
+    input.battery_percent = batteryCapacity.readInt(capacity) ? capacity : -1;
+
+    const QString& mode = tierModes[static_cast<int>(governorPolicy.update(input))];
+    if (mode == applied) {
+        return;
+    }
+    ControlStatus status = AttributeTable::trySet<AttributeTable::PlatformProfile>(mode);
+    if (!status.ok()) {
+        qDebug() << "Error: PerformanceGovernor::tick "
+                 << status.message(AttributeTable::rows[AttributeTable::PlatformProfile].name, mode);
+        return;
+    }
+    applied = mode;
+    ++switches;
+    emit modeChanged(mode, governorPolicy.smoothedLoad());
+}
@@ -0,0 +1,118 @@
+#ifndef PERFORMANCEGOVERNOR_H
+#define PERFORMANCEGOVERNOR_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <cstdint>
+#include "SysfsAttribute.h"
+
+// Chooses a performance tier from CPU load, AC and battery level. Pure
+// decision logic with no I/O, so a recorded trace can be fed straight in.
+// Load is smoothed over a few samples and has to cross separate up and
+// down thresholds, and a switch is held for a minimum dwell time, so a
+// short spike or a pause between compile jobs does not flip the profile.
+class GovernorPolicy
+{
+public:
+    enum class Tier { LowPower, Quiet, Balanced, Performance };
+
+    struct Settings
+    {
+        int high_load = 60;         // smoothed busy % that asks for performance
+        int low_load = 15;          // smoothed busy % that counts as idle
+        int dwell_ms = 15000;       // minimum time between two switches
+        int low_battery = 20;       // on battery at or below this %, always low power
+        bool performance_on_battery = false;
+    };
+
+    struct Input
+    {
+        int64_t now_ms = 0;
+        int cpu_percent = 0;
+        bool on_ac = true;
+        int battery_percent = -1;   // -1 when there is no battery
+    };
+
+    explicit GovernorPolicy(const Settings& settings = Settings());
+
+    // Feeds one sample and returns the tier to run at from now on
+    Tier update(const Input& input);
+
+    Tier tier() const { return current; }
+    int smoothedLoad() const { return smoothed < 0 ? -1 : (smoothed + load_scale / 2) / load_scale; }
+
+    static const char* tierName(Tier tier);
+
+private:
+    Settings settings;
+    Tier current = Tier::Balanced;
+    bool decided = false;
+    static constexpr int load_scale = 256;
+    int smoothed = -1;              // in 1/load_scale %
+    int64_t last_switch_ms = 0;
+};
+
+// Busy percentage of all CPUs between two calls, from the aggregate line of
+// /proc/stat (below SysfsRoot). The file stays open and is read into a
+// member buffer, so a sample allocates nothing.
+class CpuLoadSampler
+{
+public:
+    CpuLoadSampler();
+
+    // -1 on the first call and when /proc/stat cannot be parsed
+    int sample();
+
+private:
+    SysfsAttribute stat;
+    // The aggregate line comes first and is well under this size
+    char buffer[256];
+    uint64_t previous_total = 0;
+    uint64_t previous_idle = 0;
+    bool primed = false;
+};
+
+// Runs GovernorPolicy on a timer and writes the chosen platform_profile.
+// Tiers map to whatever PerformanceMode::getSupportedPerformanceModes()
+// offers, e.g. quiet falls back to low-power on firmware without it.
+class PerformanceGovernor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PerformanceGovernor(const GovernorPolicy::Settings& settings = GovernorPolicy::Settings(),
+                                 QObject *parent = nullptr);
+
+    // False when platform_profile is not supported
+    bool start(int interval_ms = 2000);
+    void stop();
+    bool isRunning() const { return timer.isActive(); }
+
+    // One sampling step at now_ms; the timer calls it with the monotonic
+    // clock, a trace replay with the recorded time
+    void tick(int64_t now_ms);
+
+    const GovernorPolicy& policy() const { return governorPolicy; }
+    QString currentMode() const { return applied; }
+    quint64 switchCount() const { return switches; }
+
+signals:
+    void modeChanged(const QString& mode, int smoothed_load);
+
+private:
+    bool resolveModes();
+
+    GovernorPolicy governorPolicy;
+    CpuLoadSampler cpu;
+    SysfsAttribute acOnline;        // empty path when there is no mains supply
+    SysfsAttribute batteryCapacity;
+    QTimer timer;
+    // Indexed by GovernorPolicy::Tier
+    QString tierModes[4];
+    bool resolved = false;
+    QString applied;
+    quint64 switches = 0;
+};
+
+#endif // PERFORMANCEGOVERNOR_H
@@ -6,6 +6,7 @@
 #include <QString>
 #include <QStringList>
 
+// Named entry points for the platform_profile rows of AttributeTable
 class PerformanceMode
 {
 public:
@@ -16,7 +17,7 @@ public:
     static QString getMonitoringFilePath();
 
 private:
-    static const QString base_path;
+    PerformanceMode() = delete;
 };
 
 #endif // PERFORMANCEMODE_H
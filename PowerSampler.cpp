@@ -0,0 +1,179 @@
+#include "PowerSampler.h"
+#include "BatteryChargeControl.h"
+#include <QThread>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+QString batteryPath(const QString& path)
+{
+    return path.isEmpty() ? BatteryChargeControl::getBasePath() : path;
+}
+
+int readInt(const SysfsAttribute& attribute)
+{
+    int value;
+    return attribute.readInt(value) ? value : -1;
+}
+
+PowerSample::Status parseStatus(const char* text)
+{
+    if (std::strcmp(text, "Charging") == 0) {
+        return PowerSample::Status::Charging;
+    }
+    if (std::strcmp(text, "Discharging") == 0) {
+        return PowerSample::Status::Discharging;
+    }
+    if (std::strcmp(text, "Not charging") == 0) {
+        return PowerSample::Status::NotCharging;
+    }
+    if (std::strcmp(text, "Full") == 0) {
+        return PowerSample::Status::Full;
+    }
+    return PowerSample::Status::Unknown;
+}
+
+} // namespace
+
+PowerSampler::PowerSampler(const QString& battery_path)
+    : power_now(batteryPath(battery_path) + "/power_now")
+    , energy_now(batteryPath(battery_path) + "/energy_now")
+    , voltage_now(batteryPath(battery_path) + "/voltage_now")
+    , current_now(batteryPath(battery_path) + "/current_now")
+    , status(batteryPath(battery_path) + "/status")
+{
+}
+
+PowerSampler::~PowerSampler()
+{
+    stop();
+}
+
+bool PowerSampler::isSupported() const
+{
+    return power_now.exists() || (voltage_now.exists() && current_now.exists());
+}
+
+bool PowerSampler::start(int interval_ms)
+{
+    stop();
+    if (interval_ms <= 0) {
+        error = "Sampling interval must be positive";
+        return false;
+    }
+
+    timer_fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    stop_fd = ::eventfd(0, EFD_CLOEXEC);
+    if (timer_fd < 0 || stop_fd < 0) {
+        error = QString("Cannot create sampling timer: %1").arg(strerror(errno));
+        stop();
+        return false;
+    }
+
+    // First sample right away, then every interval
+    struct itimerspec spec = {};
+    spec.it_value.tv_nsec = 1;
+    spec.it_interval.tv_sec = interval_ms / 1000;
+    spec.it_interval.tv_nsec = static_cast<long>(interval_ms % 1000) * 1000000;
+    if (::timerfd_settime(timer_fd, 0, &spec, nullptr) != 0) {
+        error = QString("Cannot arm sampling timer: %1").arg(strerror(errno));
+        stop();
+        return false;
+    }
+
+    thread = QThread::create([this] { run(); });
+    thread->start();
+    return true;
+}
+
+void PowerSampler::stop()
+{
+    if (thread) {
+        uint64_t one = 1;
+        ssize_t written = ::write(stop_fd, &one, sizeof(one));
+        Q_UNUSED(written);
+        thread->wait();
+        delete thread;
+        thread = nullptr;
+    }
+    if (timer_fd >= 0) {
+        ::close(timer_fd);
+        timer_fd = -1;
+    }
+    if (stop_fd >= 0) {
+        ::close(stop_fd);
+        stop_fd = -1;
+    }
+}
+
+void PowerSampler::run()
+{
+    struct pollfd fds[2] = {{timer_fd, POLLIN, 0}, {stop_fd, POLLIN, 0}};
+    for (;;) {
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (fds[1].revents) {
+            return;
+        }
+
+        uint64_t expirations = 0;
+        if (::read(timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+            continue;
+        }
+        if (expirations > 1) {
+            missed.fetch_add(expirations - 1, std::memory_order_relaxed);
+        }
+        if (!ring.push(sample())) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+PowerSample PowerSampler::sample() const
+{
+    PowerSample result;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    result.timestamp_ns = static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+
+    result.power_uw = readInt(power_now);
+    result.energy_uwh = readInt(energy_now);
+    result.voltage_uv = readInt(voltage_now);
+    result.current_ua = readInt(current_now);
+    if (result.power_uw < 0 && result.voltage_uv >= 0 && result.current_ua >= 0) {
+        result.power_uw = static_cast<int>(static_cast<int64_t>(result.voltage_uv) * result.current_ua / 1000000);
+    }
+
+    char text[32];
+    if (status.read(text, sizeof(text)) >= 0) {
+        result.status = parseStatus(text);
+    }
+    return result;
+}
+
+const char* PowerSampler::statusName(PowerSample::Status status)
+{
+    switch (status) {
+    case PowerSample::Status::Charging:
+        return "Charging";
+    case PowerSample::Status::Discharging:
+        return "Discharging";
+    case PowerSample::Status::NotCharging:
+        return "Not charging";
+    case PowerSample::Status::Full:
+        return "Full";
+    case PowerSample::Status::Unknown:
+        break;
+    }
+    return "Unknown";
+}
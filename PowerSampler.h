@@ -0,0 +1,83 @@
+#ifndef POWERSAMPLER_H
+#define POWERSAMPLER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <cstdint>
+#include "SpscRing.h"
+#include "SysfsAttribute.h"
+
+class QThread;
+
+// One reading of the battery; fields the driver does not expose are -1
+struct PowerSample
+{
+    enum class Status : qint8 { Unknown, Charging, Discharging, NotCharging, Full };
+
+    int64_t timestamp_ns = 0;   // CLOCK_MONOTONIC
+    int power_uw = -1;          // derived from voltage and current when power_now is missing
+    int energy_uwh = -1;
+    int voltage_uv = -1;
+    int current_ua = -1;
+    Status status = Status::Unknown;
+};
+
+// Samples power_now, energy_now, voltage_now, current_now and status of the
+// battery BatteryChargeControl manages, on a timerfd in a thread of its own.
+// The attributes stay open, so a sample is five preads and no allocation.
+// Samples go into a lock-free ring that one consumer (the window, an
+// exporter or galaxybook-ctl) drains with pop(); when the consumer falls
+// behind, new samples are dropped and counted rather than blocking.
+class PowerSampler
+{
+public:
+    // 68 minutes at 1 Hz, 40 seconds at 100 Hz
+    static constexpr size_t ring_capacity = 4096;
+
+    // battery_path defaults to BatteryChargeControl::getBasePath()
+    explicit PowerSampler(const QString& battery_path = QString());
+    ~PowerSampler();
+
+    PowerSampler(const PowerSampler&) = delete;
+    PowerSampler& operator=(const PowerSampler&) = delete;
+
+    // Whether the battery reports power, or voltage and current
+    bool isSupported() const;
+
+    bool start(int interval_ms);
+    void stop();
+    bool isRunning() const { return thread != nullptr; }
+    QString errorString() const { return error; }
+
+    // Reads every attribute once; what the sampler thread does per tick
+    PowerSample sample() const;
+
+    // Consumer side; false when no sample is waiting
+    bool pop(PowerSample& sample) { return ring.pop(sample); }
+
+    // Samples lost because the ring was full
+    quint64 droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+    // Ticks that were never sampled because the thread ran late
+    quint64 missedTicks() const { return missed.load(std::memory_order_relaxed); }
+
+    static const char* statusName(PowerSample::Status status);
+
+private:
+    void run();
+
+    SysfsAttribute power_now;
+    SysfsAttribute energy_now;
+    SysfsAttribute voltage_now;
+    SysfsAttribute current_now;
+    SysfsAttribute status;
+    SpscRing<PowerSample, ring_capacity> ring;
+    int timer_fd = -1;
+    int stop_fd = -1;
+    QThread *thread = nullptr;
+    std::atomic<quint64> dropped{0};
+    std::atomic<quint64> missed{0};
+    QString error;
+};
+
+#endif // POWERSAMPLER_H
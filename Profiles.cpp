@@ -0,0 +1,199 @@
+#include "Profiles.h"
+#include "DeviceControls.h"
+#include "StateCache.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+ProfileStore::ProfileStore(const QString& path)
+    : path(path)
+{
+}
+
+QString ProfileStore::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + "/galaxybook-control/profiles";
+}
+
+bool ProfileStore::load()
+{
+    entries.clear();
+    QFile file(path);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        error = "Cannot read " + path + ": " + file.errorString();
+        return false;
+    }
+
+    while (!file.atEnd()) {
+        QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        QStringList fields = line.split(' ', Qt::SkipEmptyParts);
+        Profile profile;
+        profile.name = fields.takeFirst();
+        for (const QString& field : fields) {
+            int equals = field.indexOf('=');
+            if (equals > 0) {
+                profile.settings.append({field.left(equals), field.mid(equals + 1)});
+            }
+        }
+        entries.append(profile);
+    }
+    return true;
+}
+
+bool ProfileStore::save() const
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        error = "Cannot write " + path + ": " + file.errorString();
+        return false;
+    }
+    for (const Profile& profile : entries) {
+        QByteArray line = profile.name.toUtf8();
+        for (const auto& setting : profile.settings) {
+            line += ' ' + setting.first.toUtf8() + '=' + setting.second.toUtf8();
+        }
+        file.write(line + '\n');
+    }
+    if (!file.commit()) {
+        error = "Cannot write " + path + ": " + file.errorString();
+        return false;
+    }
+    return true;
+}
+
+const Profile *ProfileStore::find(const QString& name) const
+{
+    for (const Profile& profile : entries) {
+        if (profile.name == name) {
+            return &profile;
+        }
+    }
+    return nullptr;
+}
+
+void ProfileStore::insert(const Profile& profile)
+{
+    for (Profile& existing : entries) {
+        if (existing.name == profile.name) {
+            existing = profile;
+            return;
+        }
+    }
+    entries.append(profile);
+}
+
+bool ProfileStore::remove(const QString& name)
+{
+    for (int i = 0; i < entries.size(); ++i) {
+        if (entries.at(i).name == name) {
+            entries.remove(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+Profile ProfileStore::capture(const QString& name, DeviceControls& controls)
+{
+    Profile profile;
+    profile.name = name;
+    for (const auto& control : controls.all()) {
+        if (!control->isSupported()) {
+            continue;
+        }
+        // Leave unreadable controls out of the profile
+        ControlResult<QString> value = control->tryGet();
+        if (value.ok()) {
+            profile.settings.append({control->name(), value.value()});
+        }
+    }
+    return profile;
+}
+
+ProfileApplier::ProfileApplier(DeviceControls& controls)
+    : controls(controls)
+{
+}
+
+ProfileApplier::Result ProfileApplier::apply(const Profile& profile)
+{
+    Result result;
+    QElapsedTimer timer;
+    timer.start();
+
+    struct Step
+    {
+        DeviceControl *control;
+        QString value;
+        QString previous;
+    };
+    QVector<Step> steps;
+
+    // Validate everything before the first write
+    for (const auto& setting : profile.settings) {
+        DeviceControl *control = controls.find(setting.first);
+        if (!control || !control->isSupported()) {
+            result.error = "Control " + setting.first + " is not available";
+            return result;
+        }
+        QString reason;
+        if (!control->isValid(setting.second, &reason)) {
+            result.error = reason;
+            return result;
+        }
+        ControlResult<QString> current = control->tryGet();
+        if (!current.ok()) {
+            result.error = control->failureMessage(current.status());
+            return result;
+        }
+        if (current.value() == setting.second.trimmed()) {
+            ++result.unchanged;
+            continue;
+        }
+        steps.append({control, setting.second, current.value()});
+    }
+    result.validate_ns = timer.nsecsElapsed();
+
+    int done = 0;
+    for (; done < steps.size(); ++done) {
+        const Step& step = steps.at(done);
+        ControlStatus status = step.control->trySet(step.value);
+        if (!status.ok()) {
+            result.error = step.control->failureMessage(status, step.value);
+            break;
+        }
+        if (stateCache) {
+            stateCache->recordWrite(step.control->name(), step.value.trimmed());
+        }
+        result.changed_controls << step.control->name();
+    }
+    result.written = done;
+
+    if (done < steps.size()) {
+        // Restore in reverse order so dependent settings unwind cleanly
+        for (int i = done - 1; i >= 0; --i) {
+            // Best effort: keep restoring the rest
+            if (steps.at(i).control->trySet(steps.at(i).previous).ok() && stateCache) {
+                stateCache->recordWrite(steps.at(i).control->name(), steps.at(i).previous);
+            }
+        }
+        result.rolled_back = done > 0;
+        result.changed_controls.clear();
+    } else {
+        result.ok = true;
+    }
+
+    result.total_ns = timer.nsecsElapsed();
+    result.write_ns = result.total_ns - result.validate_ns;
+    return result;
+}
@@ -0,0 +1,78 @@
+#ifndef PROFILES_H
+#define PROFILES_H
+
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class DeviceControls;
+class StateCache;
+
+// A named set of control values, e.g. "travel" = quiet mode, backlight off
+struct Profile
+{
+    QString name;
+    QVector<QPair<QString, QString>> settings;
+};
+
+// All profiles in one small text file, one profile per line:
+//   <name> <control>=<value> <control>=<value> ...
+class ProfileStore
+{
+public:
+    explicit ProfileStore(const QString& path = defaultPath());
+
+    static QString defaultPath();
+
+    bool load();
+    bool save() const;
+    QString errorString() const { return error; }
+
+    const QVector<Profile>& profiles() const { return entries; }
+    const Profile *find(const QString& name) const;
+    void insert(const Profile& profile);
+    bool remove(const QString& name);
+
+    // Snapshot of every supported control's current value
+    static Profile capture(const QString& name, DeviceControls& controls);
+
+private:
+    QString path;
+    QVector<Profile> entries;
+    mutable QString error;
+};
+
+// Applies a profile as one transaction: everything is validated before the
+// first write, unchanged values are skipped, the writes are issued back to
+// back and a failure rolls the already written controls back.
+class ProfileApplier
+{
+public:
+    struct Result
+    {
+        bool ok = false;
+        QString error;
+        int written = 0;
+        int unchanged = 0;
+        bool rolled_back = false;
+        qint64 validate_ns = 0;
+        qint64 write_ns = 0;
+        qint64 total_ns = 0;
+        QStringList changed_controls;
+    };
+
+    explicit ProfileApplier(DeviceControls& controls);
+
+    // Records every successful write, including rollbacks, so their echoes
+    // are recognised
+    void setStateCache(StateCache *cache) { stateCache = cache; }
+
+    Result apply(const Profile& profile);
+
+private:
+    DeviceControls& controls;
+    StateCache *stateCache = nullptr;
+};
+
+#endif // PROFILES_H
@@ -0,0 +1,58 @@
+#include "StateCache.h"
+
+void StateCache::prime(const QString& key, const QString& value, bool writes_echo)
+{
+    Entry& entry = entries[key];
+    entry.value = value;
+    entry.echo_expected = false;
+    entry.writes_echo = writes_echo;
+}
+
+void StateCache::recordWrite(const QString& key, const QString& value)
+{
+    Entry& entry = entries[key];
+    if (entry.value != value) {
+        entry.value = value;
+        ++entry.generation;
+    }
+    // Several writes before the watcher reports back still echo only once
+    entry.echo_expected = entry.writes_echo;
+    ++stats.own_writes;
+}
+
+bool StateCache::update(const QString& key, const QString& value, bool *echo)
+{
+    if (echo) {
+        *echo = false;
+    }
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        it = entries.insert(key, Entry());
+    } else if (it->value == value) {
+        if (it->echo_expected) {
+            it->echo_expected = false;
+            ++stats.suppressed_echoes;
+            if (echo) {
+                *echo = true;
+            }
+        } else {
+            ++stats.unchanged_notifications;
+        }
+        return false;
+    }
+    it->value = value;
+    it->echo_expected = false;
+    ++it->generation;
+    ++stats.hardware_changes;
+    return true;
+}
+
+QString StateCache::value(const QString& key) const
+{
+    return entries.value(key).value;
+}
+
+quint64 StateCache::generation(const QString& key) const
+{
+    return entries.value(key).generation;
+}
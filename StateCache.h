@@ -0,0 +1,59 @@
+#ifndef STATECACHE_H
+#define STATECACHE_H
+
+#include <QHash>
+#include <QString>
+
+// Last known value of every control, keyed by control name. Every
+// notification is read and compared; only a value that differs from the
+// cache counts as a hardware change. Our own writes go through
+// recordWrite() once they have succeeded, so the watcher's echo of them
+// reads back the value already cached and is recognised by that value.
+// A change from elsewhere that lands in the same window reads differently
+// and is never mistaken for the echo.
+class StateCache
+{
+public:
+    struct Counters
+    {
+        quint64 own_writes = 0;
+        quint64 suppressed_echoes = 0;          // read, and matched our last write
+        quint64 unchanged_notifications = 0;    // read, but matched the cache
+        quint64 hardware_changes = 0;           // read and differed
+    };
+
+    StateCache() = default;
+
+    // Sets the initial value without counting it as a change. Attributes
+    // whose watcher never reports our own writes must not expect an echo.
+    void prime(const QString& key, const QString& value, bool writes_echo = true);
+
+    // Our own write of value to key, after it succeeded
+    void recordWrite(const QString& key, const QString& value);
+
+    // Stores a value read after a notification; false if it matches the
+    // cache. echo is set when the value is the one our last write expected
+    // to see echoed.
+    bool update(const QString& key, const QString& value, bool *echo = nullptr);
+
+    bool contains(const QString& key) const { return entries.contains(key); }
+    QString value(const QString& key) const;
+    // Increases on every change of key, whatever its origin
+    quint64 generation(const QString& key) const;
+
+    const Counters& counters() const { return stats; }
+
+private:
+    struct Entry
+    {
+        QString value;
+        quint64 generation = 0;
+        bool echo_expected = false;
+        bool writes_echo = true;
+    };
+
+    QHash<QString, Entry> entries;
+    Counters stats;
+};
+
+#endif // STATECACHE_H
@@ -0,0 +1,151 @@
+#include "StatePublisher.h"
+#include <QFile>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+using Segment = StateSnapshotReader::Segment;
+
+qint64 realtimeNs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<qint64>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+// NUL padded; false when bytes did not fit
+bool copyField(char *target, const QByteArray& bytes, int size)
+{
+    int length = qMin(static_cast<int>(bytes.size()), size - 1);
+    std::memcpy(target, bytes.constData(), static_cast<size_t>(length));
+    std::memset(target + length, 0, static_cast<size_t>(size - length));
+    return length == bytes.size();
+}
+
+} // namespace
+
+StatePublisher::~StatePublisher()
+{
+    close();
+}
+
+bool StatePublisher::open(const QString& name)
+{
+    close();
+    QByteArray native = QFile::encodeName(name);
+    // Always a fresh segment: one created by another user must not be
+    // taken over, and the sticky /dev/shm only lets us remove our own
+    if (::shm_unlink(native.constData()) != 0 && errno != ENOENT) {
+        error = QString("Cannot replace shared memory %1: %2").arg(name, strerror(errno));
+        return false;
+    }
+    int fd = ::shm_open(native.constData(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error = QString("Cannot create shared memory %1: %2").arg(name, strerror(errno));
+        return false;
+    }
+    // The umask may have dropped the read bits
+    ::fchmod(fd, 0644);
+    void *mapping = MAP_FAILED;
+    if (::ftruncate(fd, sizeof(Segment)) == 0) {
+        mapping = ::mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    int saved_errno = errno;
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error = QString("Cannot map shared memory %1: %2").arg(name, strerror(saved_errno));
+        ::shm_unlink(native.constData());
+        return false;
+    }
+
+    // The new segment is zero filled, which readers reject until the
+    // header is written under the sequence lock
+    segment = static_cast<Segment *>(mapping);
+    uint64_t sequence = 0;
+    __atomic_store_n(&segment->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    std::memcpy(segment->magic, StateSnapshotReader::magic, sizeof(segment->magic));
+    segment->version = StateSnapshotReader::format_version;
+    segment->entry_size = sizeof(StateSnapshotReader::Entry);
+    segment->max_entries = StateSnapshotReader::max_entries;
+    segment->publisher_pid = static_cast<uint32_t>(::getpid());
+    segment->created_ns = realtimeNs();
+    segment->published_ns = segment->created_ns;
+    segment->count = 0;
+    std::memset(segment->entries, 0, sizeof(segment->entries));
+    __atomic_store_n(&segment->sequence, sequence + 2, __ATOMIC_RELEASE);
+
+    segmentName = name;
+    slotOf.clear();
+    rejected.clear();
+    return true;
+}
+
+void StatePublisher::close()
+{
+    if (!segment) {
+        return;
+    }
+    ::munmap(segment, sizeof(Segment));
+    segment = nullptr;
+    ::shm_unlink(QFile::encodeName(segmentName).constData());
+    slotOf.clear();
+}
+
+bool StatePublisher::publish(const QString& name, const QString& value)
+{
+    if (!segment) {
+        return false;
+    }
+    QByteArray bytes = value.toUtf8();
+    auto it = slotOf.constFind(name);
+    int slot;
+    if (it != slotOf.constEnd()) {
+        slot = it.value();
+        const StateSnapshotReader::Entry& entry = segment->entries[slot];
+        if (strnlen(entry.value, StateSnapshotReader::value_size) == static_cast<size_t>(bytes.size())
+            && std::memcmp(entry.value, bytes.constData(), static_cast<size_t>(bytes.size())) == 0) {
+            return true;
+        }
+    } else {
+        if (slotOf.size() >= StateSnapshotReader::max_entries || rejected.contains(name)) {
+            return false;
+        }
+        // Truncated names could collide, so they are not published at all
+        if (name.toUtf8().size() >= StateSnapshotReader::name_size) {
+            rejected.insert(name);
+            error = QString("Name %1 is longer than %2 bytes; not published")
+                        .arg(name).arg(StateSnapshotReader::name_size - 1);
+            qWarning("StatePublisher: %s", qPrintable(error));
+            return false;
+        }
+        slot = static_cast<int>(slotOf.size());
+        slotOf.insert(name, slot);
+    }
+
+    // Writer side of the sequence lock: odd while the entry is inconsistent
+    uint64_t sequence = __atomic_load_n(&segment->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&segment->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    StateSnapshotReader::Entry& entry = segment->entries[slot];
+    if (static_cast<uint32_t>(slot) >= segment->count) {
+        copyField(entry.name, name.toUtf8(), StateSnapshotReader::name_size);
+        entry.changes = 0;
+        segment->count = static_cast<uint32_t>(slot + 1);
+    }
+    copyField(entry.value, bytes, StateSnapshotReader::value_size);
+    entry.changed_ns = realtimeNs();
+    ++entry.changes;
+    segment->published_ns = entry.changed_ns;
+
+    __atomic_store_n(&segment->sequence, sequence + 2, __ATOMIC_RELEASE);
+    ++update_count;
+    return true;
+}
@@ -0,0 +1,51 @@
+#ifndef STATEPUBLISHER_H
+#define STATEPUBLISHER_H
+
+#include "StateSnapshotReader.h"
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+// Writes the current control values into the shared-memory segment that
+// StateSnapshotReader maps, so other programs can see them without
+// touching sysfs. Updates are guarded by a sequence lock: the sequence is
+// made odd, the entry rewritten and the sequence made even again, which
+// takes no syscall. There is one writer; call it from one thread.
+class StatePublisher
+{
+public:
+    StatePublisher() = default;
+    // Removes the segment, so readers can tell the publisher is gone
+    ~StatePublisher();
+
+    StatePublisher(const StatePublisher&) = delete;
+    StatePublisher& operator=(const StatePublisher&) = delete;
+
+    // Creates the segment, readable by every user. One left under the name
+    // is replaced, so only open it once no other publisher can be running,
+    // e.g. after ControlServer::listen(); one owned by another user is an
+    // error.
+    bool open(const QString& name = StateSnapshotReader::default_name);
+    void close();
+    bool isOpen() const { return segment != nullptr; }
+    QString errorString() const { return error; }
+
+    // Sets name to value; unchanged values are not republished. Returns
+    // false when the segment is full or not open, or when name does not
+    // fit an entry (reported once through errorString()).
+    bool publish(const QString& name, const QString& value);
+
+    // Number of publish() calls that changed the segment
+    quint64 updates() const { return update_count; }
+
+private:
+    StateSnapshotReader::Segment *segment = nullptr;
+    QString segmentName;
+    QString error;
+    QHash<QString, int> slotOf;
+    QSet<QString> rejected;
+    quint64 update_count = 0;
+};
+
+#endif // STATEPUBLISHER_H
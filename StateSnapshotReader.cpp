@@ -0,0 +1,134 @@
+#include "StateSnapshotReader.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Retries before giving up on a publisher stuck mid-update; an update is a
+// few hundred nanoseconds, so this only trips when it really is stuck
+constexpr int max_attempts = 10000;
+
+} // namespace
+
+const StateSnapshotReader::Entry *StateSnapshotReader::Snapshot::find(const char *name) const
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        if (std::strncmp(entries[i].name, name, name_size) == 0) {
+            return &entries[i];
+        }
+    }
+    return nullptr;
+}
+
+StateSnapshotReader::~StateSnapshotReader()
+{
+    close();
+}
+
+bool StateSnapshotReader::open(const char *name)
+{
+    close();
+    int fd = ::shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status;
+    void *mapping = MAP_FAILED;
+    if (::fstat(fd, &status) == 0 && status.st_size >= static_cast<off_t>(sizeof(Segment))) {
+        mapping = ::mmap(nullptr, sizeof(Segment), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    // The mapping stays valid without the descriptor
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    const Segment *candidate = static_cast<const Segment *>(mapping);
+    if (std::memcmp(candidate->magic, magic, sizeof(magic)) != 0 || candidate->version != format_version
+        || candidate->entry_size != sizeof(Entry) || candidate->max_entries != max_entries) {
+        ::munmap(mapping, sizeof(Segment));
+        return false;
+    }
+    segment = candidate;
+    return true;
+}
+
+void StateSnapshotReader::close()
+{
+    if (segment) {
+        ::munmap(const_cast<Segment *>(segment), sizeof(Segment));
+        segment = nullptr;
+    }
+}
+
+uint64_t StateSnapshotReader::version() const
+{
+    return segment ? __atomic_load_n(&segment->sequence, __ATOMIC_ACQUIRE) : 0;
+}
+
+uint32_t StateSnapshotReader::publisherPid() const
+{
+    return segment ? __atomic_load_n(&segment->publisher_pid, __ATOMIC_RELAXED) : 0;
+}
+
+template <typename Fn>
+bool StateSnapshotReader::consistent(Fn&& copy, uint64_t *version) const
+{
+    if (!segment) {
+        return false;
+    }
+    for (int attempt = 0; attempt < max_attempts; ++attempt) {
+        uint64_t before = __atomic_load_n(&segment->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            continue;
+        }
+        copy();
+        // Orders the copy before the second load of the sequence
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&segment->sequence, __ATOMIC_RELAXED) == before) {
+            if (version) {
+                *version = before;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool StateSnapshotReader::read(Snapshot& snapshot) const
+{
+    return consistent([&] {
+        snapshot.published_ns = segment->published_ns;
+        snapshot.count = segment->count < static_cast<uint32_t>(max_entries) ? segment->count : max_entries;
+        std::memcpy(snapshot.entries, segment->entries, snapshot.count * sizeof(Entry));
+    }, &snapshot.version);
+}
+
+bool StateSnapshotReader::get(const char *name, char *buffer, size_t size, uint64_t *version) const
+{
+    if (size == 0) {
+        return false;
+    }
+    bool found = false;
+    bool ok = consistent([&] {
+        found = false;
+        uint32_t count = segment->count < static_cast<uint32_t>(max_entries) ? segment->count : max_entries;
+        for (uint32_t i = 0; i < count; ++i) {
+            const Entry& entry = segment->entries[i];
+            if (std::strncmp(entry.name, name, name_size) == 0) {
+                size_t length = strnlen(entry.value, value_size);
+                if (length >= size) {
+                    length = size - 1;
+                }
+                std::memcpy(buffer, entry.value, length);
+                buffer[length] = '\0';
+                found = true;
+                break;
+            }
+        }
+    }, version);
+    return ok && found;
+}
@@ -0,0 +1,104 @@
+#ifndef STATESNAPSHOTREADER_H
+#define STATESNAPSHOTREADER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Reads the control values galaxybook-controld publishes in a POSIX
+// shared-memory segment, for panel applets, status bar scripts and
+// monitoring agents. After open() a read is a copy out of the mapping
+// guarded by a sequence lock: no syscall, no lock and no allocation, and
+// the publisher is never held up by its readers.
+//
+// This file and its .cpp use nothing but libc, so other programs can
+// build them as they are (reader/galaxybook-state.pro makes a static
+// library of them).
+class StateSnapshotReader
+{
+public:
+    static constexpr const char *default_name = "/galaxybook-control-state";
+
+    static constexpr int name_size = 24;
+    static constexpr int value_size = 24;
+    static constexpr int max_entries = 60;
+    static constexpr uint32_t format_version = 1;
+    static constexpr char magic[8] = {'G', 'B', 'S', 'T', 'A', 'T', 'E', '\0'};
+
+    struct Entry
+    {
+        char name[name_size];       // NUL padded
+        char value[value_size];     // NUL padded, truncated if longer
+        int64_t changed_ns;         // CLOCK_REALTIME of the last change
+        uint32_t changes;           // since the publisher started
+        uint32_t reserved;
+    };
+    static_assert(sizeof(Entry) == 64, "entries are one cache line");
+
+    // The whole segment; one page
+    struct Segment
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t entry_size;
+        uint32_t max_entries;
+        uint32_t publisher_pid;
+        int64_t created_ns;
+        char padding1[32];
+
+        // Odd while the publisher is writing; bumped by two per update
+        alignas(64) uint64_t sequence;
+        int64_t published_ns;
+        uint32_t count;
+        char padding2[44];
+
+        Entry entries[StateSnapshotReader::max_entries];
+    };
+    static_assert(sizeof(Segment) <= 4096, "the segment is one page");
+
+    // A consistent copy of the published values
+    struct Snapshot
+    {
+        uint64_t version = 0;       // the sequence it was taken at; even
+        int64_t published_ns = 0;
+        uint32_t count = 0;
+        Entry entries[max_entries];
+
+        // nullptr when name is not published
+        const Entry *find(const char *name) const;
+    };
+
+    StateSnapshotReader() = default;
+    ~StateSnapshotReader();
+
+    StateSnapshotReader(const StateSnapshotReader&) = delete;
+    StateSnapshotReader& operator=(const StateSnapshotReader&) = delete;
+
+    // Maps the segment read-only; false when it does not exist or is not
+    // a snapshot of this format
+    bool open(const char *name = default_name);
+    void close();
+    bool isOpen() const { return segment != nullptr; }
+
+    // Changes whenever a value does; comparing it is the cheapest way to
+    // poll. 0 before open().
+    uint64_t version() const;
+
+    // False when the publisher did not finish an update in time (it died
+    // mid-write, or was descheduled); try again later
+    bool read(Snapshot& snapshot) const;
+
+    // Copies one value, NUL terminated, into buffer
+    bool get(const char *name, char *buffer, size_t size, uint64_t *version = nullptr) const;
+
+    // Pid of the publisher, e.g. to tell whether it is still running
+    uint32_t publisherPid() const;
+
+private:
+    // Runs copy under the sequence lock until it sees a stable version
+    template <typename Fn>
+    bool consistent(Fn&& copy, uint64_t *version) const;
+
+    const Segment *segment = nullptr;
+};
+
+#endif // STATESNAPSHOTREADER_H
@@ -0,0 +1,308 @@
+#include "SysfsAttribute.h"
+#include <QFile>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/magic.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+namespace {
+
+bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+// Errors after which the held descriptor no longer refers to a live
+// attribute, e.g. the driver was unbound and the node recreated
+bool isStaleDescriptorError(int error)
+{
+    return error == ENODEV || error == EBADF || error == ESTALE || error == ENOENT;
+}
+
+} // namespace
+
+SysfsAttribute::SysfsAttribute(const QString& path)
+    : path_(QFile::encodeName(path))
+{
+}
+
+SysfsAttribute::~SysfsAttribute()
+{
+    close();
+    // Nobody can be using the object any more
+    for (int fd : retired_) {
+        ::close(fd);
+    }
+}
+
+bool SysfsAttribute::exists() const
+{
+    return ::access(path_.constData(), F_OK) == 0;
+}
+
+int SysfsAttribute::fd() const
+{
+    return open(false);
+}
+
+void SysfsAttribute::close() const
+{
+    int fd = fd_.exchange(-1);
+    if (fd >= 0) {
+        retire(fd);
+    }
+}
+
+// A thread that loaded fd counted itself in users_ first, so once users_
+// is seen at zero after fd left fd_, nobody holds it
+void SysfsAttribute::retire(int fd) const
+{
+    {
+        std::lock_guard<std::mutex> lock(retired_mutex_);
+        retired_.push_back(fd);
+        has_retired_.store(true);
+    }
+    if (users_.load() == 0) {
+        closeRetired();
+    }
+}
+
+void SysfsAttribute::release() const
+{
+    if (users_.fetch_sub(1) == 1 && has_retired_.load()) {
+        closeRetired();
+    }
+}
+
+void SysfsAttribute::closeRetired() const
+{
+    std::vector<int> closing;
+    {
+        std::lock_guard<std::mutex> lock(retired_mutex_);
+        // A use that started since may have loaded a descriptor retired
+        // after the caller checked; its own release() closes it then
+        if (users_.load() != 0) {
+            return;
+        }
+        closing.swap(retired_);
+        has_retired_.store(false);
+    }
+    int saved_errno = errno;
+    for (int fd : closing) {
+        ::close(fd);
+    }
+    errno = saved_errno;
+}
+
+int SysfsAttribute::open(bool need_write) const
+{
+    int fd = fd_.load();
+    if (fd >= 0 && (!need_write || writable_.load(std::memory_order_relaxed))) {
+        return fd;
+    }
+    return reopen(need_write);
+}
+
+int SysfsAttribute::reopen(bool need_write) const
+{
+    // Prefer a read-write descriptor so one fd serves both directions; most
+    // attributes are 0644 root-owned, so fall back to read-only for readers
+    bool writable = true;
+    int fd = ::open(path_.constData(), O_RDWR | O_CLOEXEC);
+    if (fd < 0 && !need_write && (errno == EACCES || errno == EPERM)) {
+        writable = false;
+        fd = ::open(path_.constData(), O_RDONLY | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        return -1;
+    }
+
+    // sysfs regenerates the whole value on every write; a regular file (as
+    // used by a fake device tree) has to be truncated to behave the same
+    struct statfs fs;
+    truncate_on_write_.store(::fstatfs(fd, &fs) == 0 && fs.f_type != SYSFS_MAGIC, std::memory_order_relaxed);
+    writable_.store(writable, std::memory_order_relaxed);
+
+    int previous = fd_.exchange(fd);
+    if (previous >= 0) {
+        retire(previous);
+    }
+    return fd;
+}
+
+ssize_t SysfsAttribute::read(char* buffer, size_t size) const
+{
+    if (size == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    Use use(*this);
+    int fd = open(false);
+    if (fd < 0) {
+        return -1;
+    }
+
+    ssize_t length = ::pread(fd, buffer, size - 1, 0);
+    if (length < 0 && isStaleDescriptorError(errno)) {
+        fd = reopen(false);
+        if (fd < 0) {
+            return -1;
+        }
+        length = ::pread(fd, buffer, size - 1, 0);
+    }
+    if (length < 0) {
+        return -1;
+    }
+
+    while (length > 0 && isWhitespace(buffer[length - 1])) {
+        --length;
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+bool SysfsAttribute::readInt(int& value) const
+{
+    char buffer[32];
+    ssize_t length = read(buffer, sizeof(buffer));
+    if (length < 0) {
+        return false;
+    }
+    if (!parseInt(buffer, static_cast<size_t>(length), value)) {
+        errno = EINVAL;
+        return false;
+    }
+    return true;
+}
+
+bool SysfsAttribute::write(const char* data, size_t length) const
+{
+    Use use(*this);
+    int fd = open(true);
+    if (fd < 0) {
+        return false;
+    }
+
+    ssize_t written = ::pwrite(fd, data, length, 0);
+    if (written < 0 && isStaleDescriptorError(errno)) {
+        fd = reopen(true);
+        if (fd < 0) {
+            return false;
+        }
+        written = ::pwrite(fd, data, length, 0);
+    }
+    if (written < 0) {
+        return false;
+    }
+    if (static_cast<size_t>(written) != length) {
+        errno = EIO;
+        return false;
+    }
+
+    if (truncate_on_write_.load(std::memory_order_relaxed) && ::ftruncate(fd, static_cast<off_t>(length)) != 0) {
+        return false;
+    }
+    return true;
+}
+
+bool SysfsAttribute::writeInt(int value) const
+{
+    char buffer[16];
+    size_t length = formatInt(value, buffer);
+    return write(buffer, length);
+}
+
+bool SysfsAttribute::parseInt(const char* data, size_t length, int& value)
+{
+    size_t i = 0;
+    while (i < length && isWhitespace(data[i])) {
+        ++i;
+    }
+
+    bool negative = false;
+    if (i < length && (data[i] == '-' || data[i] == '+')) {
+        negative = data[i] == '-';
+        ++i;
+    }
+
+    if (i == length || data[i] < '0' || data[i] > '9') {
+        return false;
+    }
+
+    long long result = 0;
+    for (; i < length && data[i] >= '0' && data[i] <= '9'; ++i) {
+        result = result * 10 + (data[i] - '0');
+        if (result > static_cast<long long>(INT_MAX) + 1) {
+            return false;
+        }
+    }
+
+    // Only trailing whitespace may follow the number
+    for (; i < length; ++i) {
+        if (!isWhitespace(data[i])) {
+            return false;
+        }
+    }
+
+    if (negative) {
+        result = -result;
+    }
+    if (result > INT_MAX || result < INT_MIN) {
+        return false;
+    }
+    value = static_cast<int>(result);
+    return true;
+}
+
+size_t SysfsAttribute::formatInt(int value, char* buffer)
+{
+    // buffer must hold at least 12 bytes ("-2147483648" plus NUL)
+    char digits[12];
+    size_t count = 0;
+    unsigned int magnitude = value < 0 ? 0u - static_cast<unsigned int>(value) : static_cast<unsigned int>(value);
+    do {
+        digits[count++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    size_t length = 0;
+    if (value < 0) {
+        buffer[length++] = '-';
+    }
+    while (count > 0) {
+        buffer[length++] = digits[--count];
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+bool SysfsAttribute::containsToken(const char* data, size_t length, const char* token, size_t token_length, char separator)
+{
+    size_t start = 0;
+    while (start < length) {
+        size_t end = start;
+        while (end < length && data[end] != separator) {
+            ++end;
+        }
+
+        // Tolerate whitespace around separators ("0; 1" as well as "0;1")
+        size_t first = start;
+        size_t last = end;
+        while (first < last && isWhitespace(data[first])) {
+            ++first;
+        }
+        while (last > first && isWhitespace(data[last - 1])) {
+            --last;
+        }
+
+        if (token_length > 0 && last - first == token_length && std::memcmp(data + first, token, token_length) == 0) {
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
@@ -0,0 +1,83 @@
+#ifndef SYSFSATTRIBUTE_H
+#define SYSFSATTRIBUTE_H
+
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <sys/types.h>
+#include <vector>
+
+// A single sysfs attribute file that stays open for the lifetime of the
+// object. Reads and writes use pread/pwrite at offset 0 on a stack buffer,
+// so a get or set costs one syscall and no heap allocation.
+class SysfsAttribute
+{
+public:
+    // Large enough for every attribute we access (platform_profile_choices
+    // is the longest at roughly 60 bytes)
+    static constexpr size_t buffer_size = 256;
+
+    explicit SysfsAttribute(const QString& path);
+    ~SysfsAttribute();
+
+    SysfsAttribute(const SysfsAttribute&) = delete;
+    SysfsAttribute& operator=(const SysfsAttribute&) = delete;
+
+    bool exists() const;
+
+    // Reads the file content with trailing whitespace stripped and NUL
+    // terminated. Returns the content length, or -1 with errno set.
+    ssize_t read(char* buffer, size_t size) const;
+    bool readInt(int& value) const;
+
+    bool write(const char* data, size_t length) const;
+    bool writeInt(int value) const;
+
+    QString path() const { return QString::fromLocal8Bit(path_); }
+    const char* nativePath() const { return path_.constData(); }
+
+    // Returns the held file descriptor, opening it on first use
+    int fd() const;
+    void close() const;
+
+    // Allocation-free parsing helpers for attribute content
+    static bool parseInt(const char* data, size_t length, int& value);
+    static size_t formatInt(int value, char* buffer);
+    static bool containsToken(const char* data, size_t length, const char* token, size_t token_length, char separator);
+
+private:
+    // Held across every pread/pwrite, so a descriptor replaced by reopen()
+    // or close() is only closed once no thread can still be using it
+    class Use
+    {
+    public:
+        explicit Use(const SysfsAttribute& attribute)
+            : attribute(attribute)
+        {
+            attribute.users_.fetch_add(1);
+        }
+        ~Use() { attribute.release(); }
+
+    private:
+        const SysfsAttribute& attribute;
+    };
+
+    int open(bool need_write) const;
+    int reopen(bool need_write) const;
+    void retire(int fd) const;
+    void release() const;
+    void closeRetired() const;
+
+    QByteArray path_;
+    mutable std::atomic<int> fd_{-1};
+    mutable std::atomic<int> users_{0};
+    mutable std::atomic<bool> has_retired_{false};
+    mutable std::mutex retired_mutex_;
+    mutable std::vector<int> retired_;
+    mutable std::atomic<bool> writable_{false};
+    mutable std::atomic<bool> truncate_on_write_{false};
+};
+
+#endif // SYSFSATTRIBUTE_H
@@ -0,0 +1,29 @@
+#include "SysfsRoot.h"
+#include <QDir>
+
+const char* const SysfsRoot::environment_variable = "GALAXYBOOK_SYSFS_ROOT";
+
+QString& SysfsRoot::storage()
+{
+    static QString root = QDir::cleanPath(qEnvironmentVariable(environment_variable));
+    return root;
+}
+
+QString SysfsRoot::root()
+{
+    return storage();
+}
+
+void SysfsRoot::setRoot(const QString& root)
+{
+    storage() = root.isEmpty() ? QString() : QDir::cleanPath(root);
+}
+
+QString SysfsRoot::path(const QString& absolute_path)
+{
+    const QString& root = storage();
+    if (root.isEmpty() || root == "/") {
+        return absolute_path;
+    }
+    return root + absolute_path;
+}
@@ -0,0 +1,28 @@
+#ifndef SYSFSROOT_H
+#define SYSFSROOT_H
+
+#include <QString>
+
+// Prefix applied to every /sys and /proc path the feature classes access, so the
+// application and its tools can run against a synthetic device tree.
+// Set it before the first hardware access; attribute files are opened
+// lazily and keep the root that was active at that point.
+class SysfsRoot
+{
+public:
+    static const char* const environment_variable;
+
+    // Defaults to $GALAXYBOOK_SYSFS_ROOT, or empty for the real /sys
+    static QString root();
+    static void setRoot(const QString& root);
+
+    // Maps an absolute path such as "/sys/firmware/acpi" or "/proc/stat" below the root
+    static QString path(const QString& absolute_path);
+
+private:
+    static QString& storage();
+
+    SysfsRoot() = delete;
+};
+
+#endif // SYSFSROOT_H
@@ -0,0 +1,296 @@
+#include "SysfsWatcher.h"
+#include <QFile>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/magic.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+namespace {
+
+// epoll user data: 0 is the inotify descriptor, n + 1 is entry n
+constexpr quint64 inotify_tag = 0;
+
+constexpr uint32_t inotify_mask = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF;
+
+bool isSysfs(int fd)
+{
+    struct statfs fs;
+    return ::fstatfs(fd, &fs) == 0 && fs.f_type == SYSFS_MAGIC;
+}
+
+} // namespace
+
+SysfsWatcher::SysfsWatcher(QObject *parent)
+    : QObject(parent)
+    , coalescingTimer(new QTimer(this))
+{
+    coalescingTimer->setSingleShot(true);
+    coalescingTimer->setInterval(0);
+    connect(coalescingTimer, &QTimer::timeout, this, &SysfsWatcher::flushPending);
+
+    epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (epoll_fd < 0 || inotify_fd < 0) {
+        qWarning("SysfsWatcher: cannot create epoll/inotify instance: %s", strerror(errno));
+        return;
+    }
+
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = inotify_tag;
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, inotify_fd, &event);
+
+    notifier = new QSocketNotifier(epoll_fd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &SysfsWatcher::onActivated);
+}
+
+SysfsWatcher::~SysfsWatcher()
+{
+    for (Entry& entry : entries) {
+        releaseEntry(entry);
+    }
+    if (inotify_fd >= 0) {
+        ::close(inotify_fd);
+    }
+    if (epoll_fd >= 0) {
+        ::close(epoll_fd);
+    }
+}
+
+void SysfsWatcher::setCoalescingInterval(int msec)
+{
+    coalescingTimer->setInterval(msec);
+}
+
+bool SysfsWatcher::addPath(const QString& path)
+{
+    if (!isValid() || path.isEmpty() || indexByPath.contains(path)) {
+        return false;
+    }
+
+    int index = entries.size();
+    Entry entry;
+    entry.path = path;
+    entries.append(entry);
+    indexByPath.insert(path, index);
+
+    bool watching = armInotify(entries[index]);
+    watching |= armPoll(index);
+    return watching;
+}
+
+bool SysfsWatcher::removePath(const QString& path)
+{
+    auto it = indexByPath.find(path);
+    if (it == indexByPath.end()) {
+        return false;
+    }
+    // Slots are never reused so pending epoll data stays unambiguous
+    Entry& entry = entries[it.value()];
+    releaseEntry(entry);
+    entry.removed = true;
+    entry.pending = false;
+    indexByPath.erase(it);
+    return true;
+}
+
+QStringList SysfsWatcher::files() const
+{
+    return indexByPath.keys();
+}
+
+void SysfsWatcher::rearm()
+{
+    for (int index = 0; index < entries.size(); ++index) {
+        Entry& entry = entries[index];
+        if (entry.removed) {
+            continue;
+        }
+        releaseEntry(entry);
+        armInotify(entry);
+        armPoll(index);
+    }
+}
+
+bool SysfsWatcher::armInotify(Entry& entry)
+{
+    QByteArray native = QFile::encodeName(entry.path);
+    int wd = ::inotify_add_watch(inotify_fd, native.constData(), inotify_mask);
+    if (wd < 0) {
+        return false;
+    }
+    entry.watch_descriptor = wd;
+    indexByWatch.insert(wd, &entry - entries.data());
+    return true;
+}
+
+bool SysfsWatcher::armPoll(int index)
+{
+    Entry& entry = entries[index];
+    QByteArray native = QFile::encodeName(entry.path);
+    int fd = ::open(native.constData(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (fd < 0) {
+        return false;
+    }
+
+    // Only sysfs attributes raise POLLPRI; regular files are always readable
+    if (!isSysfs(fd)) {
+        ::close(fd);
+        return false;
+    }
+
+    // sysfs only reports POLLPRI for changes after the value has been read
+    char buffer[64];
+    if (::pread(fd, buffer, sizeof(buffer), 0) < 0) {
+        ::close(fd);
+        return false;
+    }
+
+    struct epoll_event event = {};
+    event.events = EPOLLPRI | EPOLLERR;
+    event.data.u64 = static_cast<quint64>(index) + 1;
+    if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        ::close(fd);
+        return false;
+    }
+    entry.poll_fd = fd;
+    return true;
+}
+
+void SysfsWatcher::releaseEntry(Entry& entry)
+{
+    if (entry.watch_descriptor >= 0) {
+        int index = &entry - entries.data();
+        indexByWatch.remove(entry.watch_descriptor, index);
+        if (!indexByWatch.contains(entry.watch_descriptor)) {
+            ::inotify_rm_watch(inotify_fd, entry.watch_descriptor);
+        }
+        entry.watch_descriptor = -1;
+    }
+    if (entry.poll_fd >= 0) {
+        ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, entry.poll_fd, nullptr);
+        ::close(entry.poll_fd);
+        entry.poll_fd = -1;
+    }
+}
+
+void SysfsWatcher::onActivated()
+{
+    ++stats.wakeups;
+
+    struct epoll_event events[16];
+    int count;
+    do {
+        count = ::epoll_wait(epoll_fd, events, 16, 0);
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.u64 == inotify_tag) {
+                drainInotify();
+            } else {
+                drainPoll(static_cast<int>(events[i].data.u64 - 1));
+            }
+        }
+    } while (count == 16);
+
+    if (!pendingIndexes.isEmpty() && !coalescingTimer->isActive()) {
+        if (coalescingTimer->interval() == 0) {
+            flushPending();
+        } else {
+            coalescingTimer->start();
+        }
+    }
+}
+
+void SysfsWatcher::drainInotify()
+{
+    alignas(struct inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t length = ::read(inotify_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+
+        for (char *p = buffer; p < buffer + length; ) {
+            auto *event = reinterpret_cast<struct inotify_event *>(p);
+            p += sizeof(struct inotify_event) + event->len;
+            ++stats.raw_events;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were dropped; report everything rather than lose one
+                ++stats.overflows;
+                for (int i = 0; i < entries.size(); ++i) {
+                    markPending(i);
+                }
+                continue;
+            }
+
+            const QList<int> indexes = indexByWatch.values(event->wd);
+            for (int index : indexes) {
+                markPending(index);
+                if (event->mask & IN_IGNORED) {
+                    // The file was deleted or replaced: try to follow the new one
+                    indexByWatch.remove(event->wd, index);
+                    entries[index].watch_descriptor = -1;
+                    armInotify(entries[index]);
+                }
+            }
+        }
+    }
+}
+
+void SysfsWatcher::drainPoll(int index)
+{
+    if (index < 0 || index >= entries.size()) {
+        return;
+    }
+    Entry& entry = entries[index];
+    if (entry.poll_fd < 0) {
+        return;
+    }
+    ++stats.raw_events;
+
+    // Reading the value re-arms POLLPRI for the next sysfs_notify()
+    char buffer[64];
+    if (::pread(entry.poll_fd, buffer, sizeof(buffer), 0) < 0 && errno == ENODEV) {
+        // The device went away; stop polling a dead descriptor
+        ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, entry.poll_fd, nullptr);
+        ::close(entry.poll_fd);
+        entry.poll_fd = -1;
+    }
+    markPending(index);
+}
+
+void SysfsWatcher::markPending(int index)
+{
+    Entry& entry = entries[index];
+    if (entry.removed || entry.pending) {
+        return;
+    }
+    entry.pending = true;
+    pendingIndexes.append(index);
+}
+
+void SysfsWatcher::flushPending()
+{
+    // Handlers may add or remove paths, so work on a snapshot
+    QVector<int> indexes;
+    indexes.swap(pendingIndexes);
+    for (int index : indexes) {
+        Entry& entry = entries[index];
+        if (!entry.pending) {
+            continue;
+        }
+        entry.pending = false;
+        if (entry.watch_descriptor < 0) {
+            armInotify(entry);
+        }
+        ++stats.emitted;
+        QString path = entry.path;
+        emit fileChanged(path);
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef SYSFSWATCHER_H
+#define SYSFSWATCHER_H
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QSocketNotifier;
+class QTimer;
+
+// Watches attribute files for changes. All sources are multiplexed in one
+// epoll set that reaches the Qt event loop through a single QSocketNotifier:
+//  - one inotify instance for modify/delete events, which is what writes
+//    from userspace and files on a fake tree (tmpfs) produce
+//  - POLLPRI on held-open descriptors for real sysfs attributes, which is
+//    how drivers announce hardware changes via sysfs_notify()
+// Everything pending is drained per wakeup and each changed path is
+// reported once, so a burst of notifications yields one fileChanged().
+class SysfsWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Statistics
+    {
+        quint64 wakeups = 0;         // QSocketNotifier activations
+        quint64 raw_events = 0;      // inotify events and POLLPRI wakeups
+        quint64 emitted = 0;         // fileChanged() signals
+        quint64 overflows = 0;       // inotify queue overflows
+    };
+
+    explicit SysfsWatcher(QObject *parent = nullptr);
+    ~SysfsWatcher();
+
+    bool isValid() const { return epoll_fd >= 0; }
+
+    bool addPath(const QString& path);
+    bool removePath(const QString& path);
+    QStringList files() const;
+
+    // Opens every path again, for files that were missing when added or
+    // whose device was removed and re-created since
+    void rearm();
+
+    // Delay between the first pending change and fileChanged(); 0 reports
+    // at the end of the wakeup that saw it
+    void setCoalescingInterval(int msec);
+
+    const Statistics& statistics() const { return stats; }
+
+signals:
+    void fileChanged(const QString &path);
+
+private slots:
+    void onActivated();
+    void flushPending();
+
+private:
+    struct Entry
+    {
+        QString path;
+        int watch_descriptor = -1;
+        int poll_fd = -1;
+        bool pending = false;
+        bool removed = false;
+    };
+
+    bool armInotify(Entry& entry);
+    bool armPoll(int index);
+    void drainInotify();
+    void drainPoll(int index);
+    void markPending(int index);
+    void releaseEntry(Entry& entry);
+
+    int epoll_fd = -1;
+    int inotify_fd = -1;
+    QSocketNotifier *notifier = nullptr;
+    QTimer *coalescingTimer = nullptr;
+    QVector<Entry> entries;
+    QHash<QString, int> indexByPath;
+    QMultiHash<int, int> indexByWatch;
+    QVector<int> pendingIndexes;
+    Statistics stats;
+};
+
+#endif // SYSFSWATCHER_H
@@ -0,0 +1,119 @@
+#include "TrayResidence.h"
+#include "BackgroundMonitor.h"
+#include "DeviceControls.h"
+#include "MainWindow.h"
+#include <QAction>
+#include <QApplication>
+#include <QCloseEvent>
+#include <QDebug>
+#include <QIcon>
+#include <QMenu>
+#include <QSystemTrayIcon>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+TrayResidence::TrayResidence(QObject *parent)
+    : QObject(parent)
+{
+    // Without a tray there is no way back to the window, so closing it
+    // quits as usual
+    if (!QSystemTrayIcon::isSystemTrayAvailable()) {
+        return;
+    }
+    QApplication::setQuitOnLastWindowClosed(false);
+
+    trayMenu = new QMenu();
+    connect(trayMenu->addAction("Show"), &QAction::triggered, this, [this] { showWindow(); });
+    connect(trayMenu->addAction("Quit"), &QAction::triggered, qApp, &QCoreApplication::quit);
+
+    trayIcon = new QSystemTrayIcon(QIcon::fromTheme("input-keyboard"), this);
+    trayIcon->setContextMenu(trayMenu);
+    connect(trayIcon, &QSystemTrayIcon::activated, this, [this](QSystemTrayIcon::ActivationReason reason) {
+        if (reason != QSystemTrayIcon::Trigger) {
+            return;
+        }
+        if (mainWindow) {
+            mainWindow->close();
+        } else {
+            showWindow();
+        }
+    });
+    trayIcon->show();
+}
+
+TrayResidence::~TrayResidence()
+{
+    // The window and the monitor may still emit into us while going away
+    mainWindow.reset();
+    backgroundMonitor.reset();
+    delete trayMenu;
+}
+
+MainWindow *TrayResidence::showWindow()
+{
+    if (!mainWindow) {
+        // The window watches and journals for itself
+        backgroundMonitor.reset();
+        changeJournal.close();
+        mainWindow = std::make_unique<MainWindow>();
+        mainWindow->installEventFilter(this);
+        emit windowCreated(mainWindow.get());
+    }
+    mainWindow->show();
+    mainWindow->raise();
+    mainWindow->activateWindow();
+    return mainWindow.get();
+}
+
+void TrayResidence::hideToTray()
+{
+    if (backgroundMonitor || !trayIcon) {
+        return;
+    }
+    std::unique_ptr<StateCache> seed;
+    if (mainWindow) {
+        // Writes still pending land in the cache before it is copied
+        mainWindow->finishWrites();
+        seed = std::make_unique<StateCache>(mainWindow->cache());
+        mainWindow.reset();
+    }
+#ifdef __GLIBC__
+    // Hand the widget tree's heap back, or the idle RSS barely moves
+    malloc_trim(0);
+#endif
+
+    if (!changeJournal.open(ChangeJournal::defaultPath())) {
+        qDebug() << changeJournal.errorString();
+    }
+    backgroundMonitor = std::make_unique<BackgroundMonitor>();
+    backgroundMonitor->setJournal(changeJournal.isOpen() ? &changeJournal : nullptr);
+    connect(backgroundMonitor.get(), &BackgroundMonitor::valueChanged, this, &TrayResidence::updateToolTip);
+    backgroundMonitor->start(seed.get());
+    updateToolTip();
+}
+
+bool TrayResidence::eventFilter(QObject *watched, QEvent *event)
+{
+    // The window is in the middle of its own event handling; delete it later
+    if (trayIcon && mainWindow && watched == mainWindow.get() && event->type() == QEvent::Close) {
+        QMetaObject::invokeMethod(this, &TrayResidence::hideToTray, Qt::QueuedConnection);
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void TrayResidence::updateToolTip()
+{
+    if (!trayIcon || !backgroundMonitor) {
+        return;
+    }
+    const StateCache& cache = backgroundMonitor->cache();
+    QString text = "Galaxy Book Control";
+    if (cache.contains(DeviceControls::keyboard_backlight)) {
+        text += "\nKeyboard backlight: " + cache.value(DeviceControls::keyboard_backlight);
+    }
+    if (cache.contains(DeviceControls::performance_mode)) {
+        text += "\nPerformance mode: " + cache.value(DeviceControls::performance_mode);
+    }
+    trayIcon->setToolTip(text);
+}
@@ -0,0 +1,53 @@
+#ifndef TRAYRESIDENCE_H
+#define TRAYRESIDENCE_H
+
+#include <QObject>
+#include <memory>
+#include "ChangeJournal.h"
+
+class BackgroundMonitor;
+class MainWindow;
+class QMenu;
+class QSystemTrayIcon;
+
+// Keeps the application running without its window. Closing the window
+// destroys it, with its widgets, worker threads and write scheduler; a
+// BackgroundMonitor seeded from the window's cache takes over watching,
+// and the window is built again when the tray icon is clicked. Where no
+// tray is available the window behaves as without one: closing it quits.
+class TrayResidence : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TrayResidence(QObject *parent = nullptr);
+    ~TrayResidence();
+
+    // Builds the window if needed and raises it
+    MainWindow *showWindow();
+    // Tears the window down and keeps watching in the background; does
+    // nothing without a tray
+    void hideToTray();
+    bool hasTray() const { return trayIcon != nullptr; }
+
+    MainWindow *window() const { return mainWindow.get(); }
+    BackgroundMonitor *monitor() const { return backgroundMonitor.get(); }
+
+signals:
+    void windowCreated(MainWindow *window);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void updateToolTip();
+
+    std::unique_ptr<MainWindow> mainWindow;
+    std::unique_ptr<BackgroundMonitor> backgroundMonitor;
+    // Only open while the window, which keeps its own, is gone
+    ChangeJournal changeJournal;
+    QSystemTrayIcon *trayIcon = nullptr;
+    QMenu *trayMenu = nullptr;
+};
+
+#endif // TRAYRESIDENCE_H
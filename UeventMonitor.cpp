@@ -0,0 +1,206 @@
+#include "UeventMonitor.h"
+#include <QSocketNotifier>
+#include <QTimer>
+#include <cerrno>
+#include <cstring>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// The kernel multicast group; group 2 carries udev's re-broadcasts
+constexpr unsigned int kernel_group = 1;
+
+// Large enough for the burst of a module load while the loop is busy
+constexpr int receive_buffer_size = 1 << 20;
+
+} // namespace
+
+UeventMonitor::UeventMonitor(QObject *parent)
+    : QObject(parent)
+    , settleTimer(new QTimer(this))
+{
+    settleTimer->setSingleShot(true);
+    settleTimer->setInterval(200);
+    connect(settleTimer, &QTimer::timeout, this, [this] {
+        ++stats.notifications;
+        emit devicesChanged();
+    });
+}
+
+UeventMonitor::~UeventMonitor()
+{
+    close();
+}
+
+bool UeventMonitor::open()
+{
+    int fd = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (fd < 0) {
+        error = QString("Cannot create uevent socket: %1").arg(strerror(errno));
+        return false;
+    }
+    int size = receive_buffer_size;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+    struct sockaddr_nl address = {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = kernel_group;
+    if (::bind(fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0) {
+        error = QString("Cannot subscribe to uevents: %1").arg(strerror(errno));
+        ::close(fd);
+        return false;
+    }
+    if (!open(fd)) {
+        return false;
+    }
+    netlink = true;
+    return true;
+}
+
+bool UeventMonitor::open(int fd)
+{
+    close();
+    if (fd < 0) {
+        error = "Invalid uevent socket";
+        return false;
+    }
+    socket_fd = fd;
+    netlink = false;
+    notifier = new QSocketNotifier(socket_fd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &UeventMonitor::onActivated);
+    return true;
+}
+
+void UeventMonitor::close()
+{
+    settleTimer->stop();
+    delete notifier;
+    notifier = nullptr;
+    if (socket_fd >= 0) {
+        ::close(socket_fd);
+        socket_fd = -1;
+    }
+}
+
+void UeventMonitor::setSettleInterval(int msec)
+{
+    settleTimer->setInterval(msec);
+}
+
+void UeventMonitor::onActivated()
+{
+    bool changed = false;
+    char buffer[8192];
+    for (;;) {
+        struct sockaddr_nl sender = {};
+        struct iovec vector = {buffer, sizeof(buffer) - 1};
+        struct msghdr message = {};
+        message.msg_iov = &vector;
+        message.msg_iovlen = 1;
+        if (netlink) {
+            message.msg_name = &sender;
+            message.msg_namelen = sizeof(sender);
+        }
+        ssize_t length = ::recvmsg(socket_fd, &message, MSG_DONTWAIT);
+        if (length < 0) {
+            if (errno == ENOBUFS) {
+                // Events were lost; any of them may have been ours
+                ++stats.overflows;
+                changed = true;
+                continue;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (length == 0 && !netlink) {
+            // The replaying end was closed
+            notifier->setEnabled(false);
+            break;
+        }
+        ++stats.messages;
+        if (netlink && sender.nl_pid != 0) {
+            // Sent by a user process, not the kernel
+            ++stats.malformed;
+            continue;
+        }
+
+        buffer[length] = '\0';
+        Event event;
+        if (!parse(buffer, static_cast<size_t>(length), event)) {
+            ++stats.malformed;
+            continue;
+        }
+        if (isRelevant(event)) {
+            ++stats.relevant;
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        // Restarted by every relevant burst, so a module load reports once
+        settleTimer->start();
+    }
+}
+
+bool UeventMonitor::parse(const char *data, size_t length, Event& event)
+{
+    // udev's own messages start with "libudev" and a binary header, so
+    // they fail the "<action>@<devpath>" check
+    size_t header_length = strnlen(data, length);
+    const char *at = static_cast<const char *>(std::memchr(data, '@', header_length));
+    if (!at || header_length == length) {
+        return false;
+    }
+    event.action = QByteArray(data, static_cast<int>(at - data));
+    event.devpath = QByteArray(at + 1, static_cast<int>(data + header_length - at - 1));
+
+    for (size_t offset = header_length + 1; offset < length; ) {
+        const char *field = data + offset;
+        size_t field_length = strnlen(field, length - offset);
+        offset += field_length + 1;
+
+        const char *equals = static_cast<const char *>(std::memchr(field, '=', field_length));
+        if (!equals) {
+            continue;
+        }
+        QByteArray key(field, static_cast<int>(equals - field));
+        QByteArray value(equals + 1, static_cast<int>(field + field_length - equals - 1));
+        if (key == "SUBSYSTEM") {
+            event.subsystem = value;
+        } else if (key == "DRIVER") {
+            event.driver = value;
+        } else if (key == "SEQNUM") {
+            event.seqnum = value.toULongLong();
+        } else if (key == "ACTION") {
+            event.action = value;
+        } else if (key == "DEVPATH") {
+            event.devpath = value;
+        }
+    }
+    return !event.action.isEmpty() && event.devpath.startsWith('/');
+}
+
+bool UeventMonitor::isRelevant(const Event& event)
+{
+    if (event.driver == "samsung-galaxybook" || event.devpath == "/module/samsung_galaxybook") {
+        return true;
+    }
+    if (event.subsystem == "leds") {
+        return event.devpath.endsWith("/samsung-galaxybook::kbd_backlight");
+    }
+    if (event.subsystem == "firmware-attributes") {
+        return event.devpath.endsWith("/samsung-galaxybook");
+    }
+    if (event.subsystem == "platform-profile") {
+        return true;
+    }
+    if (event.subsystem == "power_supply") {
+        // Batteries send "change" on every charge level step
+        return event.action != "change";
+    }
+    return false;
+}
@@ -0,0 +1,82 @@
+#ifndef UEVENTMONITOR_H
+#define UEVENTMONITOR_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+class QSocketNotifier;
+class QTimer;
+
+// Listens for kernel uevents on a NETLINK_KOBJECT_UEVENT socket, read
+// through a QSocketNotifier in the owning thread's event loop. Events for
+// the devices this application drives (the samsung-galaxybook module and
+// platform device, its keyboard LED, firmware attributes, platform profile
+// and batteries) are collected, and once a burst has settled
+// devicesChanged() is emitted a single time. Everything else, including the
+// periodic power_supply "change" events, is dropped after parsing.
+//
+// open(int) adopts any datagram socket instead, so recorded messages can be
+// replayed through one end of a socketpair.
+class UeventMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    // One kernel message: "<action>@<devpath>" followed by KEY=VALUE pairs,
+    // all NUL separated
+    struct Event
+    {
+        QByteArray action;
+        QByteArray devpath;
+        QByteArray subsystem;
+        QByteArray driver;
+        quint64 seqnum = 0;
+    };
+
+    struct Statistics
+    {
+        quint64 messages = 0;       // datagrams received
+        quint64 malformed = 0;      // not a kernel uevent
+        quint64 relevant = 0;       // events about our devices
+        quint64 overflows = 0;      // receive queue overruns (ENOBUFS)
+        quint64 notifications = 0;  // devicesChanged() signals
+    };
+
+    explicit UeventMonitor(QObject *parent = nullptr);
+    ~UeventMonitor();
+
+    // Subscribes to the kernel's uevent multicast group
+    bool open();
+    // Takes ownership of fd, a datagram socket carrying kernel-format messages
+    bool open(int fd);
+    void close();
+    bool isOpen() const { return socket_fd >= 0; }
+
+    // Delay between the last relevant event and devicesChanged(): a module
+    // load adds the platform device, then binds the driver, which creates
+    // the LED, attributes and profile one after another
+    void setSettleInterval(int msec);
+
+    QString errorString() const { return error; }
+    const Statistics& statistics() const { return stats; }
+
+    static bool parse(const char *data, size_t length, Event& event);
+    static bool isRelevant(const Event& event);
+
+signals:
+    void devicesChanged();
+
+private:
+    void onActivated();
+
+    int socket_fd = -1;
+    // Only the kernel (port id 0) may send on a netlink socket we trust
+    bool netlink = false;
+    QSocketNotifier *notifier = nullptr;
+    QTimer *settleTimer = nullptr;
+    QString error;
+    Statistics stats;
+};
+
+#endif // UEVENTMONITOR_H
@@ -0,0 +1,181 @@
+#include "WriteScheduler.h"
+#include "HardwareWorker.h"
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+#include <QTimer>
+
+namespace {
+
+qint64 nowMs()
+{
+    return QDeadlineTimer::current().deadline();
+}
+
+// Retry delay when the worker's queue is full
+constexpr int retry_msec = 10;
+
+} // namespace
+
+WriteScheduler::WriteScheduler(HardwareWorker& worker, QObject *parent)
+    : QObject(parent)
+    , worker(worker)
+{
+}
+
+WriteScheduler::~WriteScheduler()
+{
+    flushAll();
+    // Queued commits call back into this object
+    worker.waitForIdle();
+}
+
+void WriteScheduler::schedule(const QString& key, const QString& value, WriteFunction write)
+{
+    QMutexLocker locker(&mutex);
+    ++stats.scheduled;
+    Lane& lane = lanes[key];
+    if (lane.pending) {
+        ++stats.coalesced;
+    }
+    lane.value = value;
+    lane.write = std::move(write);
+    lane.pending = true;
+    kick(key, lane);
+}
+
+void WriteScheduler::flush(const QString& key)
+{
+    QMutexLocker locker(&mutex);
+    auto it = lanes.find(key);
+    if (it == lanes.end()) {
+        return;
+    }
+    if (it->timer) {
+        it->timer->stop();
+    }
+    // Queues behind a write in progress; the worker keeps per-lane order
+    if (it->pending && !it->queued) {
+        post(key, it.value());
+    }
+}
+
+void WriteScheduler::flushAll()
+{
+    QMutexLocker locker(&mutex);
+    for (auto it = lanes.begin(); it != lanes.end(); ++it) {
+        if (it->timer) {
+            it->timer->stop();
+        }
+        if (it->pending && !it->queued) {
+            post(it.key(), it.value());
+        }
+    }
+}
+
+bool WriteScheduler::isBusy(const QString& key) const
+{
+    QMutexLocker locker(&mutex);
+    auto it = lanes.constFind(key);
+    return it != lanes.constEnd() && (it->pending || it->queued || it->writing);
+}
+
+WriteScheduler::Statistics WriteScheduler::statistics() const
+{
+    QMutexLocker locker(&mutex);
+    return stats;
+}
+
+// Called with the mutex held, in the scheduler's thread
+void WriteScheduler::kick(const QString& key, Lane& lane)
+{
+    // A running write calls back through finish(), which kicks again
+    if (!lane.pending || lane.queued || lane.writing || commit_interval <= 0) {
+        return;
+    }
+    if (lane.timer && lane.timer->isActive()) {
+        return;
+    }
+
+    qint64 wait = lane.last_commit_ms + commit_interval - nowMs();
+    if (wait <= 0) {
+        post(key, lane);
+    } else {
+        startTimer(key, lane, static_cast<int>(wait));
+    }
+}
+
+// Called with the mutex held, in the scheduler's thread
+void WriteScheduler::startTimer(const QString& key, Lane& lane, int msec)
+{
+    if (!lane.timer) {
+        lane.timer = new QTimer(this);
+        lane.timer->setSingleShot(true);
+        connect(lane.timer, &QTimer::timeout, this, [this, key] {
+            QMutexLocker locker(&mutex);
+            Lane& lane = lanes[key];
+            if (lane.pending && !lane.queued && !lane.writing) {
+                post(key, lane);
+            }
+        });
+    }
+    lane.timer->start(msec);
+}
+
+// Called with the mutex held, in the scheduler's thread
+void WriteScheduler::post(const QString& key, Lane& lane)
+{
+    lane.queued = true;
+    lane.last_commit_ms = nowMs();
+    bool accepted = worker.submitChecked(key, [this, key] { return commit(key); }, this,
+                                         [this, key](const HardwareReply& reply) {
+                                             finish(key, reply.ok, reply.error);
+                                         });
+    if (!accepted) {
+        // The value stays pending; try again once the queue has drained a bit
+        lane.queued = false;
+        startTimer(key, lane, retry_msec);
+    }
+}
+
+// Runs on the worker; returns the value it wrote
+ControlResult<QString> WriteScheduler::commit(const QString& key)
+{
+    QString value;
+    WriteFunction write;
+    {
+        QMutexLocker locker(&mutex);
+        Lane& lane = lanes[key];
+        lane.queued = false;
+        // Take the latest value; anything scheduled from now on waits
+        lane.pending = false;
+        lane.writing = true;
+        value = lane.value;
+        write = lane.write;
+        lane.writing_value = value;
+    }
+
+    // The worker reports a failure to finish()
+    ControlStatus status = write(value);
+    if (!status.ok()) {
+        return status;
+    }
+    return value;
+}
+
+void WriteScheduler::finish(const QString& key, bool ok, const QString& error)
+{
+    QString value;
+    {
+        QMutexLocker locker(&mutex);
+        if (ok) {
+            ++stats.committed;
+        } else {
+            ++stats.failed;
+        }
+        Lane& lane = lanes[key];
+        value = lane.writing_value;
+        lane.writing = false;
+        kick(key, lane);
+    }
+    emit committed(key, value, ok, error);
+}
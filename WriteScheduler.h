@@ -0,0 +1,86 @@
+#ifndef WRITESCHEDULER_H
+#define WRITESCHEDULER_H
+
+#include "ControlResult.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <functional>
+
+class HardwareWorker;
+class QTimer;
+
+// Commits attribute writes through a HardwareWorker so slow firmware never
+// blocks the caller. Values scheduled for the same key are coalesced: only
+// the latest one is written, at most once per commit interval, and flush()
+// (e.g. on slider release) commits it right away. The key doubles as the
+// worker lane, so these writes stay ordered with other requests for the
+// same control.
+class WriteScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Performs the write, e.g. through trySet()
+    using WriteFunction = std::function<ControlStatus(const QString& value)>;
+
+    struct Statistics
+    {
+        quint64 scheduled = 0;      // schedule() calls
+        quint64 coalesced = 0;      // values replaced before being written
+        quint64 committed = 0;      // successful writes
+        quint64 failed = 0;         // writes that reported an error
+    };
+
+    explicit WriteScheduler(HardwareWorker& worker, QObject *parent = nullptr);
+    // Commits whatever is still pending before returning
+    ~WriteScheduler();
+
+    // Minimum time between two commits of the same key; 0 commits only on flush()
+    void setCommitInterval(int msec) { commit_interval = msec; }
+    int commitInterval() const { return commit_interval; }
+
+    void schedule(const QString& key, const QString& value, WriteFunction write);
+    void flush(const QString& key);
+    // flush() for every key
+    void flushAll();
+
+    // True while key has a value that is pending or being written
+    bool isBusy(const QString& key) const;
+
+    Statistics statistics() const;
+
+signals:
+    // Emitted in the scheduler's thread after every commit
+    void committed(const QString& key, const QString& value, bool ok, const QString& error);
+
+private:
+    struct Lane
+    {
+        QString value;
+        WriteFunction write;
+        bool pending = false;       // value has not been handed to the worker
+        bool queued = false;        // a commit is queued on the worker
+        bool writing = false;
+        QString writing_value;      // what the last commit wrote or tried to
+        qint64 last_commit_ms = 0;  // monotonic, when the last commit was queued
+        QTimer *timer = nullptr;
+    };
+
+    void kick(const QString& key, Lane& lane);
+    void post(const QString& key, Lane& lane);
+    void startTimer(const QString& key, Lane& lane, int msec);
+    ControlResult<QString> commit(const QString& key);
+    void finish(const QString& key, bool ok, const QString& error);
+
+    HardwareWorker& worker;
+    int commit_interval = 50;
+    // Lanes are shared with the operations running on the worker
+    mutable QMutex mutex;
+    QHash<QString, Lane> lanes;
+    Statistics stats;
+};
+
+#endif // WRITESCHEDULER_H
@@ -0,0 +1,211 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "AmbientBacklight.h"
+#include "AttributeTable.h"
+#include "FakeSysfs.h"
+#include "SysfsAttribute.h"
+#include "SysfsRoot.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Replays a lux trace through AmbientBacklight on a fake tree. The trace
+// is sampled at --hz and written as IIO scan records into the FIFO that
+// stands in for /dev/iio:device0, --watermark records at a time as the
+// kernel would release them, so the sensor's reads, wakeups and the
+// backlight writes are counted as on the laptop. Trace time is carried
+// by the record timestamps; the replay itself runs as fast as it can.
+
+namespace {
+
+struct TraceRow
+{
+    int64_t at_ms = 0;
+    double lux = 0;
+};
+
+// "<seconds> <lux>" per line, '#' starts a comment; a row holds until the
+// next one
+const char default_trace[] =
+    "# desk under ceiling lights\n"
+    "0 320\n"
+    "# lights dimmed for a presentation\n"
+    "60 60\n"
+    "# a shadow passes over the sensor\n"
+    "90 25\n"
+    "93 60\n"
+    "# evening, a desk lamp only\n"
+    "150 15\n"
+    "# a flickering screen right at a level boundary\n"
+    "200 12\n"
+    "201 16\n"
+    "202 12\n"
+    "203 16\n"
+    "204 12\n"
+    "205 16\n"
+    "# lights off\n"
+    "240 1\n"
+    "# morning daylight\n"
+    "300 2000\n"
+    "360 2000\n";
+
+bool parseTrace(const QByteArray& text, QVector<TraceRow>& rows)
+{
+    for (const QByteArray& raw : text.split('\n')) {
+        QByteArray line = raw.left(raw.indexOf('#') < 0 ? raw.size() : raw.indexOf('#')).simplified();
+        if (line.isEmpty()) {
+            continue;
+        }
+        QList<QByteArray> fields = line.split(' ');
+        if (fields.size() != 2) {
+            return false;
+        }
+        TraceRow row;
+        row.at_ms = static_cast<int64_t>(fields.at(0).toDouble() * 1000);
+        row.lux = fields.at(1).toDouble();
+        rows.append(row);
+    }
+    return !rows.isEmpty();
+}
+
+// The fake sensor's scan record: u32 illuminance in 0.1 lx, padding, s64 ns
+void encodeRecord(char *record, double lux, int64_t timestamp_ns)
+{
+    std::memset(record, 0, 16);
+    uint32_t raw = static_cast<uint32_t>(lux * 10 + 0.5);
+    for (int i = 0; i < 4; ++i) {
+        record[i] = static_cast<char>((raw >> (8 * i)) & 0xff);
+    }
+    for (int i = 0; i < 8; ++i) {
+        record[8 + i] = static_cast<char>((static_cast<uint64_t>(timestamp_ns) >> (8 * i)) & 0xff);
+    }
+}
+
+} // namespace
+
+int runAmbientBenchmark(const QStringList& args)
+{
+    const int hz = std::max(1, intOption(args, "--hz", 4));
+    const int watermark = std::max(1, intOption(args, "--watermark", 4));
+    const int iterations = intOption(args, "--iterations", 100000);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QByteArray traceText = default_trace;
+    int traceIndex = args.indexOf("--trace");
+    if (traceIndex >= 0 && traceIndex + 1 < args.size()) {
+        QFile file(args.at(traceIndex + 1));
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << "Cannot read " << file.fileName() << "\n";
+            return 1;
+        }
+        traceText = file.readAll();
+    }
+    QVector<TraceRow> trace;
+    if (!parseTrace(traceText, trace)) {
+        err << "Trace lines must read '<seconds> <lux>'\n";
+        return 1;
+    }
+
+    QTemporaryDir root;
+    QString error;
+    FakeSysfs::Options options;
+    options.ambient_light_sensor = true;
+    if (!root.isValid() || !FakeSysfs::create(root.path(), options, &error)) {
+        err << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    SysfsRoot::setRoot(root.path());
+
+    AmbientBacklight backlight;
+    AmbientLightSensor::Settings sensorSettings;
+    sensorSettings.sampling_hz = hz;
+    sensorSettings.watermark = watermark;
+    if (!backlight.start(sensorSettings)) {
+        err << backlight.errorString() << "\n";
+        return 1;
+    }
+    const AmbientLightSensor& sensor = backlight.sensor();
+    int device = ::open(QFile::encodeName(root.path() + FakeSysfs::light_sensor_device).constData(), O_WRONLY | O_CLOEXEC);
+    if (device < 0 || sensor.recordSize() != 16) {
+        err << "Cannot feed the fake sensor (record size " << sensor.recordSize() << ")\n";
+        return 1;
+    }
+
+    int64_t now_ms = 0;
+    QObject::connect(&backlight, &AmbientBacklight::levelChanged, [&](int level, double lux) {
+        out << QString("%1 s  %2 lx  -> level %3\n").arg(now_ms / 1000.0, 7, 'f', 1).arg(lux, 7, 'f', 1).arg(level);
+    });
+
+    // One sample every 1/hz of trace time, handed over watermark at a time
+    const int64_t end_ms = trace.last().at_ms;
+    const int64_t step_ms = 1000 / hz;
+    QByteArray chunk(16 * watermark, '\0');
+    quint64 written = 0;
+    int row = 0;
+    int in_chunk = 0;
+    bool fed = true;
+    for (int64_t at = 0; at <= end_ms && fed; at += step_ms) {
+        while (row + 1 < trace.size() && trace.at(row + 1).at_ms <= at) {
+            ++row;
+        }
+        encodeRecord(chunk.data() + 16 * in_chunk, trace.at(row).lux, (at + 1000) * 1000000);
+        if (++in_chunk < watermark) {
+            continue;
+        }
+        fed = ::write(device, chunk.constData(), static_cast<size_t>(chunk.size())) == chunk.size();
+        written += static_cast<quint64>(in_chunk);
+        in_chunk = 0;
+        now_ms = at;
+        fed = fed && waitFor([&] { return sensor.statistics().samples >= written; }, 2000);
+    }
+    ::close(device);
+    if (!fed) {
+        err << "The sensor stopped taking samples after " << sensor.statistics().samples << "\n";
+        return 1;
+    }
+
+    const AmbientLightSensor::Statistics& stats = sensor.statistics();
+    const double minutes = end_ms / 60000.0;
+    int brightness = -1;
+    AttributeTable::file<AttributeTable::KeyboardBrightness>().readInt(brightness);
+    out << "\ntrace: " << end_ms / 1000 << " s at " << hz << " Hz, watermark " << watermark << "\n";
+    out << QString("samples %1, wakeups %2 (%3/min), reads %4, backlight writes %5 (%6/min)\n")
+               .arg(stats.samples)
+               .arg(stats.wakeups)
+               .arg(stats.wakeups / minutes, 0, 'f', 1)
+               .arg(stats.reads)
+               .arg(backlight.writeCount())
+               .arg(backlight.writeCount() / minutes, 0, 'f', 2);
+    out << "keyboard backlight now " << brightness << "\n\n";
+
+    // Per-sample cost of the buffered path against polling the raw value
+    AmbientBacklightPolicy policy;
+    policy.setMaximum(3);
+    char record[16];
+    encodeRecord(record, 120, 0);
+    SysfsAttribute raw(root.path() + "/sys/bus/iio/devices/iio:device0/in_illuminance_raw");
+    SyscallCounter counter;
+    QList<Measurement> results;
+    volatile double sink = 0;
+    results << measure("decode one scan record", iterations, counter, [&](int) {
+        sink = sensor.decode(record).lux;
+    });
+    results << measure("policy update", iterations, counter, [&](int i) {
+        sink = policy.update(i * step_ms, 100 + (i & 7));
+    });
+    results << measure("poll in_illuminance_raw instead", iterations, counter, [&](int) {
+        int value = 0;
+        raw.readInt(value);
+        sink = value;
+    });
+    printMeasurements(out, results, counter.scope());
+    out << "buffered reads per sample in the replay: " << static_cast<double>(stats.reads) / stats.samples << "\n";
+    return brightness == backlight.currentLevel() ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "DeviceControls.h"
+#include "FakeSysfs.h"
+#include "HardwareWorker.h"
+#include "SysfsRoot.h"
+
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <algorithm>
+#include <unistd.h>
+#include <vector>
+
+// Keeps a HardwareWorker saturated from the event loop thread while one
+// attribute (performance_mode) is made artificially slow, the way an EC
+// round trip behaves on real firmware. Measures how late the event loop's
+// ticks run, what submit() costs the caller, and the completion latency
+// of requests to the slow lane versus every other lane.
+
+namespace {
+
+struct StressOptions
+{
+    int duration_ms = 2000;
+    int tick_ms = 1;
+    int per_tick = 4;
+    int slow_ms = 30;
+    int queue_limit = 256;
+};
+
+struct StressResult
+{
+    std::vector<int64_t> tick_late;
+    std::vector<int64_t> submit_cost;
+    std::vector<int64_t> fast_latency;
+    std::vector<int64_t> slow_latency;
+    HardwareWorker::Statistics stats;
+};
+
+StressResult stress(DeviceControls& controls, int threads, const StressOptions& options)
+{
+    StressResult result;
+    QObject context;
+    HardwareWorker worker(threads, options.queue_limit);
+
+    std::vector<DeviceControl *> fast;
+    for (const auto& control : controls.all()) {
+        if (control->isSupported() && control->name() != DeviceControls::performance_mode) {
+            fast.push_back(control);
+        }
+    }
+    DeviceControl *slow = controls.find(DeviceControls::performance_mode);
+
+    int submitted = 0;
+    int64_t expected_tick = nowNs();
+    QTimer ticker;
+    ticker.setTimerType(Qt::PreciseTimer);
+    ticker.setInterval(options.tick_ms);
+    QObject::connect(&ticker, &QTimer::timeout, [&] {
+        int64_t now = nowNs();
+        result.tick_late.push_back(std::max<int64_t>(0, now - expected_tick));
+        expected_tick = now + static_cast<int64_t>(options.tick_ms) * 1000000;
+
+        for (int i = 0; i < options.per_tick; ++i, ++submitted) {
+            int64_t begin = nowNs();
+            // Every fourth request goes to the slow lane
+            if (submitted % 4 == 0 && slow) {
+                QString mode = (submitted / 4) % 2 ? "quiet" : "balanced";
+                int delay_us = options.slow_ms * 1000;
+                worker.submit(slow->name(), [slow, mode, delay_us] {
+                    usleep(delay_us);
+                    slow->set(mode);
+                    return QString();
+                }, &context, [&](const HardwareReply& reply) {
+                    result.slow_latency.push_back(reply.wait_ns + reply.run_ns);
+                });
+            } else if (!fast.empty()) {
+                DeviceControl *control = fast[submitted % fast.size()];
+                worker.get(control, &context, [&](const HardwareReply& reply) {
+                    result.fast_latency.push_back(reply.wait_ns + reply.run_ns);
+                });
+            }
+            result.submit_cost.push_back(nowNs() - begin);
+        }
+    });
+
+    ticker.start();
+    waitFor([] { return false; }, options.duration_ms);
+    ticker.stop();
+
+    // Let the callbacks of everything still queued arrive
+    worker.waitForIdle();
+    waitFor([] { return false; }, 50);
+    result.stats = worker.statistics();
+
+    std::sort(result.tick_late.begin(), result.tick_late.end());
+    std::sort(result.submit_cost.begin(), result.submit_cost.end());
+    std::sort(result.fast_latency.begin(), result.fast_latency.end());
+    std::sort(result.slow_latency.begin(), result.slow_latency.end());
+    return result;
+}
+
+QString summary(const std::vector<int64_t>& sorted)
+{
+    return QString("%1 %2 %3")
+        .arg(percentile(sorted, 0.50), 10, 'f', 1)
+        .arg(percentile(sorted, 0.99), 10, 'f', 1)
+        .arg(sorted.empty() ? 0.0 : sorted.back() / 1000.0, 10, 'f', 1);
+}
+
+} // namespace
+
+int runAsyncStressBenchmark(const QStringList& args)
+{
+    StressOptions options;
+    options.duration_ms = intOption(args, "--duration-ms", options.duration_ms);
+    options.tick_ms = std::max(1, intOption(args, "--tick-ms", options.tick_ms));
+    options.per_tick = std::max(1, intOption(args, "--per-tick", options.per_tick));
+    options.slow_ms = intOption(args, "--slow-ms", options.slow_ms);
+    options.queue_limit = intOption(args, "--queue", options.queue_limit);
+    const int threads = std::max(1, intOption(args, "--threads", 2));
+
+    QTemporaryDir root;
+    QString error;
+    if (!root.isValid() || !FakeSysfs::create(root.path(), &error)) {
+        QTextStream(stderr) << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    SysfsRoot::setRoot(root.path());
+    DeviceControls controls;
+
+    QTextStream out(stdout);
+    out << options.duration_ms << " ms, " << options.per_tick << " requests every " << options.tick_ms
+        << " ms, slow lane " << options.slow_ms << " ms per write, queue limit " << options.queue_limit << "\n";
+
+    QList<int> thread_counts{1};
+    if (threads != 1) {
+        thread_counts << threads;
+    }
+    for (int count : thread_counts) {
+        StressResult result = stress(controls, count, options);
+        out << "\n" << count << " I/O thread(s): " << result.stats.submitted << " submitted, "
+            << result.stats.rejected << " rejected (queue full), " << result.stats.completed << " completed, "
+            << result.stats.failed << " failed, max queued " << result.stats.max_queued << "\n";
+        out << QString("%1 %2 %3 %4\n").arg("(us)", -22).arg("p50", 10).arg("p99", 10).arg("max", 10);
+        out << QString("%1 %2\n").arg("UI tick lateness", -22).arg(summary(result.tick_late));
+        out << QString("%1 %2\n").arg("UI submit() cost", -22).arg(summary(result.submit_cost));
+        out << QString("%1 %2\n").arg("fast lane completion", -22).arg(summary(result.fast_latency));
+        out << QString("%1 %2\n").arg("slow lane completion", -22).arg(summary(result.slow_latency));
+    }
+    return 0;
+}
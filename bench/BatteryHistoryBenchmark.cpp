@@ -0,0 +1,146 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "BatteryHistory.h"
+#include "FakeSysfs.h"
+#include "SysfsRoot.h"
+
+#include <QDateTime>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+
+// Records --days of synthetic battery history at --interval through
+// BatteryHistory::append(), with the same compaction the daemon's recorder
+// runs, and reports the file size it settles at, what a month of history
+// costs, and the time to open the file and query a year. The battery
+// wears at a known rate for each threshold (100%, then 80%, then 60%),
+// and the wear seen by wearByThreshold() is checked against it.
+
+namespace {
+
+struct Phase
+{
+    int threshold;
+    double loss_per_month;      // health points
+};
+
+const Phase phases[] = {{100, 0.60}, {80, 0.35}, {60, 0.20}};
+constexpr int phase_count = sizeof(phases) / sizeof(phases[0]);
+constexpr int design_mwh = 69000;
+
+} // namespace
+
+int runBatteryHistoryBenchmark(const QStringList& args)
+{
+    const int days = intOption(args, "--days", 365);
+    const int interval_s = intOption(args, "--interval", 600);
+    const int iterations = intOption(args, "--iterations", 200);
+
+    QTemporaryDir root;
+    QString error;
+    if (!root.isValid() || !FakeSysfs::create(root.path(), &error)) {
+        QTextStream(stderr) << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    SysfsRoot::setRoot(root.path());
+    const QString path = root.path() + "/battery-history";
+
+    // A partial charge cycle every 8 hours, topping out at the threshold
+    const int samples = static_cast<int>(qint64(days) * 86400 / interval_s);
+    const qint64 start = (QDateTime::currentSecsSinceEpoch() - qint64(days) * 86400) / 86400 * 86400;
+    const qint64 phase_s = qint64(days) * 86400 / phase_count;
+    auto synthesize = [&](int i) {
+        BatteryHistory::Sample sample;
+        sample.time = start + qint64(i) * interval_s;
+        qint64 elapsed = sample.time - start;
+        int phase = std::min(static_cast<int>(elapsed / phase_s), phase_count - 1);
+        double health = 100;
+        for (int p = 0; p <= phase; ++p) {
+            qint64 spent = p < phase ? phase_s : elapsed - phase * phase_s;
+            health -= phases[p].loss_per_month * spent / (30.0 * 86400);
+        }
+        sample.design = design_mwh;
+        sample.full = static_cast<int>(std::lround(design_mwh * health / 100));
+        sample.cycles = static_cast<int>(elapsed / (3 * 86400));
+        sample.threshold = phases[phase].threshold;
+        double position = std::fmod(elapsed / (8.0 * 3600), 1.0);
+        sample.level = static_cast<int>(20 + (sample.threshold - 20) * (position < 0.5 ? 2 * position : 2 - 2 * position));
+        return sample;
+    };
+
+    SyscallCounter counter;
+    QList<Measurement> results;
+    int failures = 0;
+
+    BatteryHistory history;
+    if (!history.open(path)) {
+        QTextStream(stderr) << history.errorString() << "\n";
+        return 1;
+    }
+    results << measure("append (with compaction)", samples, counter, [&](int i) {
+        failures += !history.append(synthesize(i), BatteryHistory::Unit::Energy);
+    });
+    const qint64 end = start + qint64(samples) * interval_s;
+
+    QByteArray encoded;
+    BatteryHistory::Sample previous = synthesize(0);
+    results << measure("encode record", iterations * 100, counter, [&](int i) {
+        BatteryHistory::Sample sample = synthesize(i + 1);
+        encoded.clear();
+        BatteryHistory::encode(encoded, previous, sample);
+        previous = sample;
+    });
+
+    BatteryHistory reader;
+    results << measure("open and decode", iterations, counter, [&](int) {
+        failures += !reader.openReadOnly(path);
+    });
+    QVector<BatteryHistory::Sample> year;
+    results << measure("query one year", iterations, counter, [&](int) {
+        year = reader.query(end - 365 * 86400, end);
+    });
+    QVector<BatteryHistory::WearSegment> segments;
+    results << measure("wear by threshold over a year", iterations, counter, [&](int) {
+        segments = BatteryHistory::wearByThreshold(year);
+    });
+    results << measure("sample battery (fake sysfs)", iterations, counter, [&](int) {
+        failures += BatteryHistory::sampleBattery().health() < 0;
+    });
+
+    QTextStream out(stdout);
+    const int daily = history.count(BatteryHistory::Tier::Daily);
+    const int hourly = history.count(BatteryHistory::Tier::Hourly);
+    const int full = history.count(BatteryHistory::Tier::Full);
+    out << "recorded " << samples << " samples over " << days << " days, every " << interval_s << " s\n";
+    out << "tiers: " << daily << " daily, " << hourly << " hourly, " << full << " full resolution\n";
+    out << "file: " << history.fileSize() << " bytes, " << QString::number(history.fileSize() / (days / 30.0), 'f', 0)
+        << " bytes per month recorded\n";
+    // Past the first month only the daily tier grows, a record a day
+    out << "steady growth: about " << QString::number(30.0 * (history.fileSize() - 32) / std::max(1, daily + hourly + full), 'f', 0)
+        << " bytes per month\n";
+    out << "one-year query: " << year.size() << " samples\n\n";
+
+    out << QString("%1 %2 %3 %4\n").arg("threshold", -10).arg("days", 7).arg("lost/month", 11).arg("expected", 9);
+    for (const BatteryHistory::WearSegment& segment : segments) {
+        double expected = 0;
+        for (const Phase& phase : phases) {
+            if (phase.threshold == segment.threshold) {
+                expected = phase.loss_per_month;
+            }
+        }
+        out << QString("%1 %2 %3 %4\n")
+                   .arg(QString("%1%").arg(segment.threshold), -10)
+                   .arg(segment.days(), 7, 'f', 1)
+                   .arg(segment.lossPerMonth(), 11, 'f', 3)
+                   .arg(expected, 9, 'f', 3);
+        // Averaging and whole mWh blur short stretches
+        if (segment.days() >= 30 && std::abs(segment.lossPerMonth() - expected) > 0.1 * expected + 0.02) {
+            ++failures;
+        }
+    }
+    out << "\n";
+    printMeasurements(out, results, counter.scope());
+    return failures == 0 && segments.size() == phase_count ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+#include "BenchUtil.h"
+#include <QFile>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+std::atomic<uint64_t> allocations{0};
+
+long tracepointId(const char* name)
+{
+    const char* roots[] = {"/sys/kernel/tracing/events/", "/sys/kernel/debug/tracing/events/"};
+    for (const char* root : roots) {
+        QFile file(QString::fromLatin1(root) + name + "/id");
+        if (file.open(QIODevice::ReadOnly)) {
+            bool ok = false;
+            long id = file.readAll().trimmed().toLong(&ok);
+            if (ok) {
+                return id;
+            }
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+// Qt allocates with malloc directly (QArrayData, QString, QByteArray), so
+// counting operator new alone would miss most allocations. The bench binary
+// interposes the malloc family instead; operator new goes through malloc as
+// well, and shared libraries such as Qt resolve to these definitions.
+extern "C" {
+
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* p, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+
+void* malloc(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+
+void* memalign(std::size_t alignment, std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** result, std::size_t alignment, std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = __libc_memalign(alignment, size);
+    if (!p) {
+        return ENOMEM;
+    }
+    *result = p;
+    return 0;
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+} // extern "C"
+
+uint64_t allocationCount()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+SyscallCounter::SyscallCounter()
+{
+    long id = tracepointId("raw_syscalls/sys_enter");
+    if (id < 0) {
+        return;
+    }
+
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_TRACEPOINT;
+    attr.config = static_cast<uint64_t>(id);
+    attr.disabled = 1;
+    attr.exclude_hv = 1;
+    perf_fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+SyscallCounter::~SyscallCounter()
+{
+    if (perf_fd_ >= 0) {
+        close(perf_fd_);
+    }
+}
+
+void SyscallCounter::start()
+{
+    if (perf_fd_ >= 0) {
+        ioctl(perf_fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(perf_fd_, PERF_EVENT_IOC_ENABLE, 0);
+    } else {
+        start_value_ = procIoSyscalls();
+    }
+}
+
+uint64_t SyscallCounter::stop()
+{
+    if (perf_fd_ >= 0) {
+        ioctl(perf_fd_, PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t count = 0;
+        if (read(perf_fd_, &count, sizeof(count)) != sizeof(count)) {
+            return 0;
+        }
+        return count;
+    }
+    // The read of /proc/self/io itself counts once
+    uint64_t end_value = procIoSyscalls();
+    return end_value > start_value_ ? end_value - start_value_ - 1 : 0;
+}
+
+uint64_t SyscallCounter::procIoSyscalls()
+{
+    char buffer[512];
+    int fd = open("/proc/self/io", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0;
+    }
+    ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (length <= 0) {
+        return 0;
+    }
+    buffer[length] = '\0';
+
+    uint64_t total = 0;
+    for (const char* key : {"syscr: ", "syscw: "}) {
+        const char* field = std::strstr(buffer, key);
+        if (field) {
+            total += std::strtoull(field + std::strlen(key), nullptr, 10);
+        }
+    }
+    return total;
+}
+
+double percentile(const std::vector<int64_t>& sorted, double fraction)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+    return sorted[index] / 1000.0;
+}
+
+int intOption(const QStringList& args, const QString& name, int default_value)
+{
+    int index = args.indexOf(name);
+    if (index < 0 || index + 1 >= args.size()) {
+        return default_value;
+    }
+    bool ok = false;
+    int value = args.at(index + 1).toInt(&ok);
+    return ok ? value : default_value;
+}
+
+void printMeasurements(QTextStream& out, const QList<Measurement>& measurements, const char* syscall_scope)
+{
+    out << QString("%1 %2 %3 %4\n")
+               .arg("operation", -44)
+               .arg("ns/op", 12)
+               .arg(QString("syscalls/op (%1)").arg(syscall_scope), 24)
+               .arg("allocs/op", 10);
+    for (const Measurement& m : measurements) {
+        out << QString("%1 %2 %3 %4\n")
+                   .arg(m.name, -44)
+                   .arg(m.ns_per_op, 12, 'f', 1)
+                   .arg(m.syscalls_per_op, 24, 'f', 2)
+                   .arg(m.allocations_per_op, 10, 'f', 2);
+    }
+    out.flush();
+}
@@ -0,0 +1,111 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <QTimer>
+#include <cstdint>
+#include <vector>
+#include <time.h>
+
+// Monotonic clock in nanoseconds
+inline int64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Counts syscalls issued by this process. Uses the raw_syscalls:sys_enter
+// tracepoint when perf is permitted, otherwise falls back to the read and
+// write counters in /proc/self/io (which miss open/close/stat).
+class SyscallCounter
+{
+public:
+    SyscallCounter();
+    ~SyscallCounter();
+
+    SyscallCounter(const SyscallCounter&) = delete;
+    SyscallCounter& operator=(const SyscallCounter&) = delete;
+
+    void start();
+    uint64_t stop();
+
+    // "all" when every syscall is counted, "read+write" for the fallback
+    const char* scope() const { return perf_fd_ >= 0 ? "all" : "read+write"; }
+
+private:
+    static uint64_t procIoSyscalls();
+
+    int perf_fd_ = -1;
+    uint64_t start_value_ = 0;
+};
+
+// Number of heap allocations so far, from operator new and from malloc
+// calls made by Qt and libc alike; the bench binary interposes the malloc
+// family to count them (glibc only)
+uint64_t allocationCount();
+
+struct Measurement
+{
+    QString name;
+    double ns_per_op = 0;
+    double syscalls_per_op = 0;
+    double allocations_per_op = 0;
+};
+
+// Runs fn the given number of times after a short warm-up
+template <typename Fn>
+Measurement measure(const QString& name, int iterations, SyscallCounter& counter, Fn&& fn)
+{
+    for (int i = 0; i < iterations / 10 + 1; ++i) {
+        fn(i);
+    }
+
+    uint64_t allocations = allocationCount();
+    counter.start();
+    int64_t begin = nowNs();
+    for (int i = 0; i < iterations; ++i) {
+        fn(i);
+    }
+    int64_t elapsed = nowNs() - begin;
+    uint64_t syscalls = counter.stop();
+    allocations = allocationCount() - allocations;
+
+    Measurement result;
+    result.name = name;
+    result.ns_per_op = static_cast<double>(elapsed) / iterations;
+    result.syscalls_per_op = static_cast<double>(syscalls) / iterations;
+    result.allocations_per_op = static_cast<double>(allocations) / iterations;
+    return result;
+}
+
+// Processes events until condition holds or timeout_ms passes
+template <typename Condition>
+bool waitFor(Condition condition, int timeout_ms)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition()) {
+        int remaining = timeout_ms - static_cast<int>(timer.elapsed());
+        if (remaining <= 0) {
+            return false;
+        }
+        QTimer::singleShot(remaining, [] {});
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    return true;
+}
+
+// Sample at fraction (0..1) of sorted nanosecond samples, in microseconds
+double percentile(const std::vector<int64_t>& sorted, double fraction);
+
+// Value following name in args, or default_value when absent
+int intOption(const QStringList& args, const QString& name, int default_value);
+
+void printMeasurements(QTextStream& out, const QList<Measurement>& measurements, const char* syscall_scope);
+
+#endif // BENCHUTIL_H
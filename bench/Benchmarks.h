@@ -0,0 +1,29 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <QStringList>
+
+// Each scenario receives the arguments following its name and returns the
+// process exit code
+int runIoBenchmark(const QStringList& args);
+int runMakeFixture(const QStringList& args);
+int runDispatchBenchmark(const QStringList& args);
+int runWatchBenchmark(const QStringList& args);
+int runDaemonLoadBenchmark(const QStringList& args);
+int runStartupBenchmark(const QStringList& args);
+int runDragBenchmark(const QStringList& args);
+int runAsyncStressBenchmark(const QStringList& args);
+int runDiscoveryBenchmark(const QStringList& args);
+int runPowerBenchmark(const QStringList& args);
+int runGovernorBenchmark(const QStringList& args);
+int runMetricsBenchmark(const QStringList& args);
+int runHotplugBenchmark(const QStringList& args);
+int runJournalBenchmark(const QStringList& args);
+int runTableBenchmark(const QStringList& args);
+int runErrorPathBenchmark(const QStringList& args);
+int runStateSnapshotBenchmark(const QStringList& args);
+int runIdleBenchmark(const QStringList& args);
+int runAmbientBenchmark(const QStringList& args);
+int runBatteryHistoryBenchmark(const QStringList& args);
+
+#endif // BENCHMARKS_H
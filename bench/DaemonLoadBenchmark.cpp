@@ -0,0 +1,125 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "ControlClient.h"
+#include "ControlServer.h"
+#include "DeviceControls.h"
+#include "FakeSysfs.h"
+#include "SysfsRoot.h"
+
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Load generator for the control socket: several client threads issue
+// get/set requests back to back and record per-request latency. Runs an
+// in-process ControlServer on a fake tree unless --socket names a daemon.
+
+namespace {
+
+const QByteArray requests[] = {
+    "get keyboard_backlight",
+    "set keyboard_backlight 2",
+    "get performance_mode",
+    "set performance_mode quiet",
+    "get charge_end_threshold",
+    "set usb_charging 1",
+};
+
+} // namespace
+
+int runDaemonLoadBenchmark(const QStringList& args)
+{
+    const int client_count = intOption(args, "--clients", 4);
+    const int requests_per_client = intOption(args, "--requests", 20000);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QString socketPath;
+    int index = args.indexOf("--socket");
+    if (index >= 0 && index + 1 < args.size()) {
+        socketPath = args.at(index + 1);
+    }
+
+    QTemporaryDir root;
+    std::unique_ptr<DeviceControls> controls;
+    ControlServer *server = nullptr;
+    QThread serverThread;
+    if (socketPath.isEmpty()) {
+        QString error;
+        if (!root.isValid() || !FakeSysfs::create(root.path(), &error)) {
+            err << "Cannot create fake sysfs tree: " << error << "\n";
+            return 1;
+        }
+        SysfsRoot::setRoot(root.path());
+        socketPath = root.filePath("control.sock");
+
+        controls = std::make_unique<DeviceControls>();
+        server = new ControlServer(*controls);
+        server->moveToThread(&serverThread);
+        serverThread.start();
+        bool listening = false;
+        QMetaObject::invokeMethod(server, [&] { return server->listen(socketPath); },
+                                  Qt::BlockingQueuedConnection, &listening);
+        if (!listening) {
+            err << server->errorString() << "\n";
+            serverThread.quit();
+            serverThread.wait();
+            delete server;
+            return 1;
+        }
+    }
+
+    std::vector<std::vector<int64_t>> latencies(client_count);
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    int64_t begin = nowNs();
+    for (int c = 0; c < client_count; ++c) {
+        threads.emplace_back([&, c] {
+            ControlClient client;
+            if (!client.connectTo(socketPath)) {
+                failures += requests_per_client;
+                return;
+            }
+            std::vector<int64_t>& samples = latencies[c];
+            samples.reserve(requests_per_client);
+            QByteArray reply;
+            for (int i = 0; i < requests_per_client; ++i) {
+                int64_t start = nowNs();
+                if (!client.request(requests[(i + c) % std::size(requests)], reply)) {
+                    ++failures;
+                }
+                samples.push_back(nowNs() - start);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    int64_t elapsed = nowNs() - begin;
+
+    if (server) {
+        QMetaObject::invokeMethod(server, [server] { server->close(); }, Qt::BlockingQueuedConnection);
+        serverThread.quit();
+        serverThread.wait();
+        delete server;
+    }
+
+    std::vector<int64_t> all;
+    for (const auto& samples : latencies) {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    out << "clients: " << client_count << ", requests: " << all.size() << ", failures: " << failures.load() << "\n";
+    out << "throughput: " << QString::number(all.size() / (elapsed / 1e9), 'f', 0) << " requests/s\n";
+    out << "latency (us): p50 " << QString::number(percentile(all, 0.50), 'f', 1)
+        << "  p99 " << QString::number(percentile(all, 0.99), 'f', 1)
+        << "  max " << QString::number(all.empty() ? 0.0 : all.back() / 1000.0, 'f', 1) << "\n";
+    return failures.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "DeviceControls.h"
+#include "FakeSysfs.h"
+#include "FirmwareAttribute.h"
+#include "SysfsRoot.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+
+// Discovers every firmware attribute on fake trees of 10, 100 and 10000
+// attributes, once with FirmwareAttribute::discover() and once the way a
+// caller had to before: list the directory, then probe each name through
+// QDir and one QFile per metadata file.
+
+namespace {
+
+int legacyFound = 0;
+
+bool legacyRead(const QString& path, QByteArray& content)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    content = file.readAll().trimmed();
+    return true;
+}
+
+void legacyDiscover()
+{
+    const QString base = FirmwareAttribute::getBasePath();
+    for (const QString& name : QDir(base).entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+        const QString path = base + name;
+        if (!QDir(path).exists()) {
+            continue;
+        }
+        QByteArray content;
+        legacyRead(path + "/display_name", content);
+        legacyRead(path + "/default_value", content);
+        legacyRead(path + "/type", content);
+        if (content == "integer") {
+            legacyRead(path + "/min_value", content);
+            legacyRead(path + "/max_value", content);
+            legacyRead(path + "/scalar_increment", content);
+        } else if (!legacyRead(path + "/possible_values", content)) {
+            continue;
+        }
+        ++legacyFound;
+    }
+}
+
+} // namespace
+
+int runDiscoveryBenchmark(const QStringList& args)
+{
+    // Total work per size, so the large tree is not scanned thousands of times
+    const int budget = intOption(args, "--budget", 20000);
+    const int sizes[] = {10, 100, 10000};
+    const int builtin_attributes = 3;
+
+    SyscallCounter counter;
+    QList<Measurement> results;
+    QStringList perAttribute;
+    for (int size : sizes) {
+        FakeSysfs::Options options;
+        options.synthetic_attributes = size - builtin_attributes;
+
+        QTemporaryDir root;
+        QString error;
+        if (!root.isValid() || !FakeSysfs::create(root.path(), options, &error)) {
+            QTextStream(stderr) << "Cannot create fake sysfs tree: " << error << "\n";
+            return 1;
+        }
+        SysfsRoot::setRoot(root.path());
+
+        int found = FirmwareAttribute::discover().size();
+        if (found != size) {
+            QTextStream(stderr) << "Discovered " << found << " attributes, expected " << size << "\n";
+            return 1;
+        }
+
+        const int iterations = std::max(2, budget / size);
+        Measurement legacy = measure(QString("legacy  per-name probe (%1)").arg(size), iterations, counter, [](int) {
+            legacyDiscover();
+        });
+        Measurement single = measure(QString("single  pass discover() (%1)").arg(size), iterations, counter, [](int) {
+            FirmwareAttribute::discover();
+        });
+        // Includes building the controls and their lookup table
+        Measurement controls = measure(QString("DeviceControls::all() (%1)").arg(size), iterations, counter, [](int) {
+            DeviceControls().all();
+        });
+        results << legacy << single << controls;
+
+        for (const Measurement& m : {legacy, single, controls}) {
+            perAttribute << QString("%1 %2 %3")
+                                .arg(m.name, -44)
+                                .arg(m.ns_per_op / size, 12, 'f', 1)
+                                .arg(m.syscalls_per_op / size, 24, 'f', 2);
+        }
+    }
+
+    QTextStream out(stdout);
+    out << "one operation discovers every attribute of the tree\n";
+    printMeasurements(out, results, counter.scope());
+    out << "\n" << QString("%1 %2 %3\n").arg("per attribute", -44).arg("ns", 12).arg("syscalls", 24);
+    for (const QString& line : perAttribute) {
+        out << line << "\n";
+    }
+    return legacyFound > 0 ? 0 : 1;
+}
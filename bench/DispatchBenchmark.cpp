@@ -0,0 +1,105 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "BatteryChargeControl.h"
+#include "ChangeDispatcher.h"
+#include "FakeSysfs.h"
+#include "FirmwareAttribute.h"
+#include "KeyboardBacklight.h"
+#include "PerformanceMode.h"
+#include "SysfsRoot.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QVector>
+
+// Replays bursts of change notifications through ChangeDispatcher and
+// through the if/else chain MainWindow::onFileChanged used before it.
+
+namespace {
+
+int legacyHits = 0;
+
+// Mirrors the original onFileChanged branch order and probing
+void legacyDispatch(const QString& path, const QVector<FirmwareAttribute>& attributes)
+{
+    if (KeyboardBacklight::isHwChangedMonitoringSupported() &&
+        path == KeyboardBacklight::getHwChangedFilePath()) {
+        ++legacyHits;
+    }
+    else if (PerformanceMode::isSupported() &&
+             path == PerformanceMode::getMonitoringFilePath()) {
+        ++legacyHits;
+    }
+    else if (BatteryChargeControl::isSupported() &&
+             path == BatteryChargeControl::getMonitoringFilePath()) {
+        ++legacyHits;
+    }
+    else {
+        for (const FirmwareAttribute& attribute : attributes) {
+            if (attribute.isSupported() && path == attribute.getMonitoringFilePath()) {
+                ++legacyHits;
+                break;
+            }
+        }
+    }
+}
+
+} // namespace
+
+int runDispatchBenchmark(const QStringList& args)
+{
+    const int events = intOption(args, "--events", 100000);
+    const int burst = intOption(args, "--burst", 32);
+
+    FakeSysfs::Options options;
+    options.synthetic_attributes = intOption(args, "--attributes", 0);
+
+    QTemporaryDir root;
+    QString error;
+    if (!root.isValid() || !FakeSysfs::create(root.path(), options, &error)) {
+        QTextStream(stderr) << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    SysfsRoot::setRoot(root.path());
+
+    QVector<FirmwareAttribute> attributes = {
+        FirmwareAttribute("power_on_lid_open"),
+        FirmwareAttribute("usb_charging"),
+        FirmwareAttribute("block_recording"),
+    };
+
+    ChangeDispatcher dispatcher;
+    int hits = 0;
+    QStringList paths = {
+        KeyboardBacklight::getHwChangedFilePath(),
+        PerformanceMode::getMonitoringFilePath(),
+        BatteryChargeControl::getMonitoringFilePath(),
+    };
+    for (const FirmwareAttribute& attribute : attributes) {
+        paths << attribute.getMonitoringFilePath();
+    }
+    for (int i = 0; i < options.synthetic_attributes; ++i) {
+        paths << FirmwareAttribute::getBasePath() + FakeSysfs::syntheticAttributeName(i) + "/current_value";
+    }
+    for (const QString& path : paths) {
+        dispatcher.watch(path, [&hits] { ++hits; });
+    }
+
+    // Bursts hit one path repeatedly, like a held hotkey, then move on
+    const int builtin_paths = 3 + attributes.size();
+    SyscallCounter counter;
+    QList<Measurement> results;
+    results << measure(QString("legacy  chain (%1 features)").arg(builtin_paths), events, counter, [&](int i) {
+        legacyDispatch(paths.at((i / burst) % builtin_paths), attributes);
+    });
+    results << measure(QString("hashed  registry (%1 paths)").arg(paths.size()), events, counter, [&](int i) {
+        dispatcher.dispatch(paths.at((i / burst) % paths.size()));
+    });
+
+    QTextStream out(stdout);
+    out << "events: " << events << ", burst length: " << burst << "\n";
+    printMeasurements(out, results, counter.scope());
+    return hits > 0 && legacyHits > 0 ? 0 : 1;
+}
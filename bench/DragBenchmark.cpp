@@ -0,0 +1,178 @@
+#include "Benchmarks.h"
+#include "BatteryChargeControl.h"
+#include "BenchUtil.h"
+#include "FakeSysfs.h"
+#include "HardwareWorker.h"
+#include "SysfsRoot.h"
+#include "WriteScheduler.h"
+
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <unistd.h>
+
+// Simulates dragging the charge threshold slider across 100 positions on a
+// fake tree whose writes are slowed down to firmware speed, once writing
+// synchronously in the slot as before and once through WriteScheduler.
+// Reports how many writes reach the attribute and how long the event loop
+// thread is blocked, per slot call and as the worst lateness of a tick.
+
+namespace {
+
+struct DragResult
+{
+    int writes = 0;
+    double worst_slot_ms = 0;
+    double mean_slot_us = 0;
+    double worst_tick_late_ms = 0;
+    double settle_ms = 0;       // from release until the last value is written
+    bool final_value_ok = false;
+};
+
+struct DragOptions
+{
+    int steps = 100;
+    int step_ms = 5;
+    int write_delay_us = 2000;
+    int interval_ms = 50;
+};
+
+int positionAt(int step, int steps)
+{
+    return 1 + (step * 99) / std::max(1, steps - 1);
+}
+
+// slot is called for every position, release once at the end; idle tells
+// when every write has landed
+DragResult drag(const DragOptions& options,
+                const std::function<void(int)>& slot,
+                const std::function<void()>& release,
+                const std::function<bool()>& idle)
+{
+    DragResult result;
+    int64_t worst_slot = 0;
+    int64_t total_slot = 0;
+    int64_t worst_late = 0;
+    int step = 0;
+    int64_t expected_tick = nowNs() + static_cast<int64_t>(options.step_ms) * 1000000;
+
+    QTimer ticker;
+    ticker.setTimerType(Qt::PreciseTimer);
+    ticker.setInterval(options.step_ms);
+    QObject::connect(&ticker, &QTimer::timeout, [&] {
+        int64_t now = nowNs();
+        worst_late = std::max(worst_late, now - expected_tick);
+        expected_tick = now + static_cast<int64_t>(options.step_ms) * 1000000;
+
+        slot(positionAt(step, options.steps));
+        int64_t spent = nowNs() - now;
+        worst_slot = std::max(worst_slot, spent);
+        total_slot += spent;
+        if (++step == options.steps) {
+            ticker.stop();
+        }
+    });
+    ticker.start();
+    waitFor([&] { return step == options.steps; }, options.steps * options.step_ms * 20 + 1000);
+
+    int64_t released = nowNs();
+    release();
+    waitFor(idle, 5000);
+    result.settle_ms = (nowNs() - released) / 1e6;
+
+    result.worst_slot_ms = worst_slot / 1e6;
+    result.mean_slot_us = static_cast<double>(total_slot) / std::max(1, step) / 1000.0;
+    result.worst_tick_late_ms = std::max<int64_t>(0, worst_late) / 1e6;
+    try {
+        result.final_value_ok = BatteryChargeControl::getChargeEndThreshold() == positionAt(options.steps - 1, options.steps);
+    } catch (const std::exception&) {
+        result.final_value_ok = false;
+    }
+    return result;
+}
+
+void print(QTextStream& out, const char* name, const DragResult& result)
+{
+    out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+               .arg(name, -12)
+               .arg(result.writes, 7)
+               .arg(result.worst_slot_ms, 15, 'f', 3)
+               .arg(result.mean_slot_us, 15, 'f', 1)
+               .arg(result.worst_tick_late_ms, 17, 'f', 3)
+               .arg(result.settle_ms, 12, 'f', 2)
+               .arg(result.final_value_ok ? "yes" : "NO", 6);
+}
+
+} // namespace
+
+int runDragBenchmark(const QStringList& args)
+{
+    DragOptions options;
+    options.steps = std::max(1, intOption(args, "--steps", options.steps));
+    options.step_ms = std::max(1, intOption(args, "--step-ms", options.step_ms));
+    options.write_delay_us = intOption(args, "--write-delay-us", options.write_delay_us);
+    options.interval_ms = intOption(args, "--interval", options.interval_ms);
+
+    QTemporaryDir root;
+    QString error;
+    if (!root.isValid() || !FakeSysfs::create(root.path(), &error)) {
+        QTextStream(stderr) << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    SysfsRoot::setRoot(root.path());
+
+    // Stands in for an ACPI/EC round trip on real firmware
+    std::atomic<int> writes{0};
+    auto slowWrite = [&](int threshold) {
+        if (options.write_delay_us > 0) {
+            usleep(options.write_delay_us);
+        }
+        BatteryChargeControl::setChargeEndThreshold(threshold);
+        ++writes;
+    };
+
+    writes = 0;
+    DragResult direct = drag(options, slowWrite, [] {}, [] { return true; });
+    direct.writes = writes;
+
+    BatteryChargeControl::setChargeEndThreshold(80);
+    writes = 0;
+    HardwareWorker worker;
+    WriteScheduler scheduler(worker);
+    scheduler.setCommitInterval(options.interval_ms);
+    const QString key = "charge_end_threshold";
+    DragResult scheduled = drag(
+        options,
+        [&](int threshold) {
+            scheduler.schedule(key, QString::number(threshold),
+                               [&](const QString& value) {
+                                   slowWrite(value.toInt());
+                                   return ControlStatus();
+                               });
+        },
+        [&] { scheduler.flush(key); },
+        [&] { return !scheduler.isBusy(key); });
+    scheduled.writes = writes;
+
+    QTextStream out(stdout);
+    out << options.steps << " steps every " << options.step_ms << " ms, " << options.write_delay_us
+        << " us per write, commit interval " << options.interval_ms << " ms\n";
+    out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+               .arg("mode", -12)
+               .arg("writes", 7)
+               .arg("worst slot ms", 15)
+               .arg("mean slot us", 15)
+               .arg("worst tick late ms", 17)
+               .arg("settle ms", 12)
+               .arg("final", 6);
+    print(out, "direct", direct);
+    print(out, "scheduled", scheduled);
+
+    WriteScheduler::Statistics stats = scheduler.statistics();
+    out << "WriteScheduler: " << stats.scheduled << " scheduled, " << stats.coalesced << " coalesced, "
+        << stats.committed << " committed, " << stats.failed << " failed\n";
+    return direct.final_value_ok && scheduled.final_value_ok ? 0 : 1;
+}
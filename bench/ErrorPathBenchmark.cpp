@@ -0,0 +1,105 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "AttributeTable.h"
+#include "DeviceControls.h"
+#include "FakeSysfs.h"
+#include "FirmwareAttribute.h"
+#include "SysfsRoot.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <exception>
+
+// Cost of the expected failures (a value out of range, an attribute that
+// disappeared, the firmware refusing a write) through the throwing
+// accessors versus their tryGet()/trySet() counterparts. The refused write
+// is simulated by turning an attribute's current_value into a directory,
+// so the open fails with EISDIR after validation has passed.
+
+int runErrorPathBenchmark(const QStringList& args)
+{
+    const int iterations = intOption(args, "--iterations", 20000);
+
+    QTemporaryDir root;
+    QString error;
+    if (!root.isValid() || !FakeSysfs::create(root.path(), &error)) {
+        QTextStream(stderr) << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    SysfsRoot::setRoot(root.path());
+
+    const QString refusing = FirmwareAttribute::getBasePath() + "block_recording/current_value";
+    QFile::remove(refusing);
+    QDir().mkpath(refusing);
+
+    DeviceControls controls;
+    DeviceControl *keyboard = controls.find(DeviceControls::keyboard_backlight);
+    FirmwareAttribute missing("no_such_attribute");
+    FirmwareAttribute blocked("block_recording");
+    FirmwareAttribute usbCharging("usb_charging");
+    using Table = AttributeTable;
+
+    SyscallCounter counter;
+    QList<Measurement> results;
+    int failures = 0;
+    auto expectThrow = [&](auto&& fn) {
+        try {
+            fn();
+        } catch (const std::exception&) {
+            ++failures;
+        }
+    };
+
+    results << measure("throw   brightness out of range", iterations, counter, [&](int) {
+        expectThrow([&] { Table::set<Table::KeyboardBrightness>(99); });
+    });
+    results << measure("result  brightness out of range", iterations, counter, [&](int) {
+        failures += !Table::trySet<Table::KeyboardBrightness>(99).ok();
+    });
+
+    results << measure("throw   control invalid value", iterations, counter, [&](int) {
+        expectThrow([&] { keyboard->set("bright"); });
+    });
+    results << measure("result  control invalid value", iterations, counter, [&](int) {
+        failures += !keyboard->trySet("bright").ok();
+    });
+
+    results << measure("throw   firmware invalid value", iterations, counter, [&](int) {
+        expectThrow([&] { usbCharging.set(7); });
+    });
+    results << measure("result  firmware invalid value", iterations, counter, [&](int) {
+        failures += !usbCharging.trySet(7).ok();
+    });
+
+    results << measure("throw   missing attribute get", iterations, counter, [&](int) {
+        expectThrow([&] { missing.get(); });
+    });
+    results << measure("result  missing attribute get", iterations, counter, [&](int) {
+        failures += !missing.tryGet().ok();
+    });
+
+    results << measure("throw   refused write", iterations, counter, [&](int i) {
+        expectThrow([&] { blocked.set(i & 1); });
+    });
+    results << measure("result  refused write", iterations, counter, [&](int i) {
+        failures += !blocked.trySet(i & 1).ok();
+    });
+
+    // The success path must not have become slower
+    results << measure("throw   brightness set", iterations, counter, [&](int i) {
+        Table::set<Table::KeyboardBrightness>(i & 3);
+    });
+    results << measure("result  brightness set", iterations, counter, [&](int i) {
+        failures += !Table::trySet<Table::KeyboardBrightness>(i & 3).ok();
+    });
+
+    QTextStream out(stdout);
+    out << "iterations: " << iterations << "\n";
+    ControlStatus refused = blocked.trySet(1);
+    out << "refused write reports " << refused.errorName() << " errno " << refused.errorNumber() << " ("
+        << refused.message(blocked.getAttributeName()) << ")\n\n";
+    printMeasurements(out, results, counter.scope());
+    return failures > 0 && refused.error() == ControlError::Io ? 0 : 1;
+}
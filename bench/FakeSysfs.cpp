@@ -0,0 +1,156 @@
+#include "FakeSysfs.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+
+namespace {
+
+struct FixtureFile
+{
+    const char* path;
+    const char* content;
+};
+
+const FixtureFile fixture_files[] = {
+    {"/sys/class/leds/samsung-galaxybook::kbd_backlight/brightness", "1\n"},
+    {"/sys/class/leds/samsung-galaxybook::kbd_backlight/max_brightness", "3\n"},
+    {"/sys/class/leds/samsung-galaxybook::kbd_backlight/brightness_hw_changed", "1\n"},
+    {"/sys/firmware/acpi/platform_profile", "balanced\n"},
+    {"/sys/firmware/acpi/platform_profile_choices", "low-power quiet balanced performance\n"},
+    {"/sys/class/power_supply/BAT1/charge_control_end_threshold", "80\n"},
+    {"/sys/class/power_supply/BAT1/type", "Battery\n"},
+    {"/sys/class/power_supply/BAT1/status", "Discharging\n"},
+    {"/sys/class/power_supply/BAT1/capacity", "72\n"},
+    {"/sys/class/power_supply/BAT1/power_now", "8250000\n"},
+    {"/sys/class/power_supply/BAT1/energy_now", "49680000\n"},
+    {"/sys/class/power_supply/BAT1/energy_full", "62730000\n"},
+    {"/sys/class/power_supply/BAT1/energy_full_design", "69000000\n"},
+    {"/sys/class/power_supply/BAT1/cycle_count", "214\n"},
+    {"/sys/class/power_supply/BAT1/voltage_now", "16500000\n"},
+    {"/sys/class/power_supply/BAT1/current_now", "500000\n"},
+    {"/sys/class/power_supply/ADP1/type", "Mains\n"},
+    {"/sys/class/power_supply/ADP1/online", "0\n"},
+    {"/sys/class/dmi/id/product_name", "960XGK\n"},
+    {"/proc/stat", "cpu  0 0 0 0 0 0 0 0 0 0\ncpu0 0 0 0 0 0 0 0 0 0 0\n"},
+};
+
+// A HID ambient light sensor with its buffered interface
+const FixtureFile light_sensor_files[] = {
+    {"/sys/bus/iio/devices/iio:device0/name", "als\n"},
+    {"/sys/bus/iio/devices/iio:device0/in_illuminance_raw", "1500\n"},
+    {"/sys/bus/iio/devices/iio:device0/in_illuminance_scale", "0.1\n"},
+    {"/sys/bus/iio/devices/iio:device0/in_illuminance_offset", "0\n"},
+    {"/sys/bus/iio/devices/iio:device0/in_illuminance_sampling_frequency", "10\n"},
+    {"/sys/bus/iio/devices/iio:device0/current_timestamp_clock", "realtime\n"},
+    {"/sys/bus/iio/devices/iio:device0/scan_elements/in_illuminance_en", "0\n"},
+    {"/sys/bus/iio/devices/iio:device0/scan_elements/in_illuminance_index", "0\n"},
+    {"/sys/bus/iio/devices/iio:device0/scan_elements/in_illuminance_type", "le:u32/32>>0\n"},
+    {"/sys/bus/iio/devices/iio:device0/scan_elements/in_intensity_both_en", "0\n"},
+    {"/sys/bus/iio/devices/iio:device0/scan_elements/in_intensity_both_index", "1\n"},
+    {"/sys/bus/iio/devices/iio:device0/scan_elements/in_intensity_both_type", "le:u32/32>>0\n"},
+    {"/sys/bus/iio/devices/iio:device0/scan_elements/in_timestamp_en", "0\n"},
+    {"/sys/bus/iio/devices/iio:device0/scan_elements/in_timestamp_index", "2\n"},
+    {"/sys/bus/iio/devices/iio:device0/scan_elements/in_timestamp_type", "le:s64/64>>0\n"},
+    {"/sys/bus/iio/devices/iio:device0/buffer/enable", "0\n"},
+    {"/sys/bus/iio/devices/iio:device0/buffer/length", "2\n"},
+    {"/sys/bus/iio/devices/iio:device0/buffer/watermark", "1\n"},
+    {"/sys/bus/iio/devices/iio:device0/trigger/current_trigger", "\n"},
+    {"/sys/bus/iio/devices/trigger0/name", "als-dev0\n"},
+};
+
+const char* const firmware_attributes[] = {"power_on_lid_open", "usb_charging", "block_recording"};
+
+bool writeFile(const QString& path, const QByteArray& content, QString* error)
+{
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        if (error) {
+            *error = "Cannot create directory for " + path;
+        }
+        return false;
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(content) != content.size()) {
+        if (error) {
+            *error = "Cannot write " + path + ": " + file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool createEnumerationAttribute(const QString& directory, const QByteArray& display_name, QString* error)
+{
+    return writeFile(directory + "/type", "enumeration\n", error)
+        && writeFile(directory + "/current_value", "0\n", error)
+        && writeFile(directory + "/default_value", "0\n", error)
+        && writeFile(directory + "/possible_values", "0;1\n", error)
+        && writeFile(directory + "/display_name", display_name + "\n", error);
+}
+
+bool createIntegerAttribute(const QString& directory, const QByteArray& display_name, QString* error)
+{
+    return writeFile(directory + "/type", "integer\n", error)
+        && writeFile(directory + "/current_value", "50\n", error)
+        && writeFile(directory + "/default_value", "50\n", error)
+        && writeFile(directory + "/min_value", "0\n", error)
+        && writeFile(directory + "/max_value", "100\n", error)
+        && writeFile(directory + "/scalar_increment", "5\n", error)
+        && writeFile(directory + "/display_name", display_name + "\n", error);
+}
+
+} // namespace
+
+bool FakeSysfs::create(const QString& root, const Options& options, QString* error)
+{
+    for (const FixtureFile& file : fixture_files) {
+        if (!writeFile(root + file.path, file.content, error)) {
+            return false;
+        }
+    }
+
+    const QString attributes = root + "/sys/class/firmware-attributes/samsung-galaxybook/attributes/";
+    for (const char* name : firmware_attributes) {
+        if (!createEnumerationAttribute(attributes + name, name, error)) {
+            return false;
+        }
+    }
+    for (int i = 0; i < options.synthetic_attributes; ++i) {
+        QString name = syntheticAttributeName(i);
+        bool created = i % 4 == 3 ? createIntegerAttribute(attributes + name, name.toLatin1(), error)
+                                  : createEnumerationAttribute(attributes + name, name.toLatin1(), error);
+        if (!created) {
+            return false;
+        }
+    }
+    if (options.ambient_light_sensor) {
+        for (const FixtureFile& file : light_sensor_files) {
+            if (!writeFile(root + file.path, file.content, error)) {
+                return false;
+            }
+        }
+        const QString device = root + light_sensor_device;
+        if (!QDir().mkpath(QFileInfo(device).absolutePath()) || ::mkfifo(QFile::encodeName(device).constData(), 0600) != 0) {
+            if (error) {
+                *error = "Cannot create " + device + ": " + strerror(errno);
+            }
+            return false;
+        }
+    }
+
+    // The class directory also holds plain files, which are not attributes
+    return writeFile(attributes + "pending_reboot", "0\n", error);
+}
+
+bool FakeSysfs::setValue(const QString& root, const QString& absolute_path, const QByteArray& value)
+{
+    return writeFile(root + absolute_path, value + "\n", nullptr);
+}
+
+QString FakeSysfs::syntheticAttributeName(int index)
+{
+    return QString("synthetic_%1").arg(index, 5, 10, QChar('0'));
+}
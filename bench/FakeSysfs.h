@@ -0,0 +1,38 @@
+#ifndef FAKESYSFS_H
+#define FAKESYSFS_H
+
+#include <QByteArray>
+#include <QString>
+
+// Builds a synthetic copy of every sysfs and procfs file the application
+// reads, laid out below a root directory the way SysfsRoot expects it.
+class FakeSysfs
+{
+public:
+    struct Options
+    {
+        // Extra attributes next to the real firmware attributes, for
+        // measuring how discovery and watching scale; every fourth one is
+        // an integer attribute, the rest are enumerations
+        int synthetic_attributes = 0;
+        // An IIO light sensor whose /dev/iio:device0 is a FIFO; the
+        // records written into it are u32 illuminance at 0.1 lx per count
+        // followed by an s64 timestamp
+        bool ambient_light_sensor = false;
+    };
+
+    static constexpr const char *light_sensor_device = "/dev/iio:device0";
+
+    static bool create(const QString& root, const Options& options, QString* error = nullptr);
+    static bool create(const QString& root, QString* error = nullptr) { return create(root, Options(), error); }
+
+    // Overwrites one attribute, given by its absolute path below root
+    static bool setValue(const QString& root, const QString& absolute_path, const QByteArray& value);
+
+    static QString syntheticAttributeName(int index);
+
+private:
+    FakeSysfs() = delete;
+};
+
+#endif // FAKESYSFS_H
@@ -0,0 +1,172 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "FakeSysfs.h"
+#include "PerformanceGovernor.h"
+#include "PerformanceMode.h"
+#include "SysfsRoot.h"
+
+#include <QFile>
+#include <QHash>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QVector>
+
+// Replays a load trace through PerformanceGovernor on a fake tree: each
+// tick rewrites the fake /proc/stat, AC and battery files so the governor
+// samples them the way it would on the laptop, then prints every profile
+// switch and the time spent in each mode. Also measures the cost of one
+// sampling tick on the fake and on the real /proc/stat.
+
+namespace {
+
+struct TraceRow
+{
+    int64_t at_ms = 0;
+    int cpu_percent = 0;
+    bool on_ac = true;
+    int battery_percent = 80;
+};
+
+// "<seconds> <cpu %> <ac 0|1> <battery %>" per line, '#' starts a comment;
+// a row holds until the next one
+const char default_trace[] =
+    "# idle on AC\n"
+    "0 4 1 80\n"
+    "# a build starts\n"
+    "60 96 1 80\n"
+    "# short pauses between compile jobs\n"
+    "120 30 1 80\n"
+    "124 97 1 80\n"
+    "150 25 1 80\n"
+    "154 95 1 80\n"
+    "# build done, a single spike while idle\n"
+    "200 3 1 80\n"
+    "260 90 1 80\n"
+    "262 3 1 80\n"
+    "# unplugged under load, then idle as the battery drains\n"
+    "300 85 0 79\n"
+    "360 6 0 40\n"
+    "420 6 0 18\n"
+    "480 6 0 17\n";
+
+bool parseTrace(const QByteArray& text, QVector<TraceRow>& rows)
+{
+    for (const QByteArray& raw : text.split('\n')) {
+        QByteArray line = raw.left(raw.indexOf('#') < 0 ? raw.size() : raw.indexOf('#')).simplified();
+        if (line.isEmpty()) {
+            continue;
+        }
+        QList<QByteArray> fields = line.split(' ');
+        if (fields.size() != 4) {
+            return false;
+        }
+        TraceRow row;
+        row.at_ms = static_cast<int64_t>(fields.at(0).toDouble() * 1000);
+        row.cpu_percent = fields.at(1).toInt();
+        row.on_ac = fields.at(2).toInt() != 0;
+        row.battery_percent = fields.at(3).toInt();
+        rows.append(row);
+    }
+    return !rows.isEmpty();
+}
+
+} // namespace
+
+int runGovernorBenchmark(const QStringList& args)
+{
+    const int interval = intOption(args, "--interval-ms", 2000);
+    const int iterations = intOption(args, "--iterations", 100000);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QByteArray traceText = default_trace;
+    int traceIndex = args.indexOf("--trace");
+    if (traceIndex >= 0 && traceIndex + 1 < args.size()) {
+        QFile file(args.at(traceIndex + 1));
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << "Cannot read " << file.fileName() << "\n";
+            return 1;
+        }
+        traceText = file.readAll();
+    }
+    QVector<TraceRow> trace;
+    if (!parseTrace(traceText, trace)) {
+        err << "Trace lines must read '<seconds> <cpu %> <ac 0|1> <battery %>'\n";
+        return 1;
+    }
+
+    // Opened before the root changes, so it samples the real /proc/stat
+    CpuLoadSampler realCpu;
+
+    QTemporaryDir root;
+    QString error;
+    if (!root.isValid() || !FakeSysfs::create(root.path(), &error)) {
+        err << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    SysfsRoot::setRoot(root.path());
+
+    PerformanceGovernor governor;
+    int64_t now = 0;
+    uint64_t busy = 0;
+    uint64_t idle = 0;
+    auto feed = [&](const TraceRow& row) {
+        // 100 jiffies per second of trace time, split by the traced load
+        uint64_t jiffies = static_cast<uint64_t>(interval) / 10;
+        busy += jiffies * row.cpu_percent / 100;
+        idle += jiffies - jiffies * row.cpu_percent / 100;
+        QByteArray stat = "cpu  " + QByteArray::number(busy) + " 0 0 " + QByteArray::number(idle) + " 0 0 0 0 0 0";
+        FakeSysfs::setValue(root.path(), "/proc/stat", stat);
+        FakeSysfs::setValue(root.path(), "/sys/class/power_supply/ADP1/online", row.on_ac ? "1" : "0");
+        FakeSysfs::setValue(root.path(), "/sys/class/power_supply/BAT1/capacity", QByteArray::number(row.battery_percent));
+    };
+
+    QHash<QString, int64_t> timeInMode;
+    QString mode;
+    int64_t modeSince = 0;
+    QObject::connect(&governor, &PerformanceGovernor::modeChanged, [&](const QString& newMode, int load) {
+        if (!mode.isEmpty()) {
+            timeInMode[mode] += now - modeSince;
+        }
+        out << QString("%1 s  load %2%  -> %3\n").arg(now / 1000.0, 7, 'f', 0).arg(load, 3).arg(newMode);
+        mode = newMode;
+        modeSince = now;
+    });
+
+    feed(trace.first());
+    if (!governor.start(interval)) {
+        err << "Fake tree has no platform_profile\n";
+        return 1;
+    }
+    governor.stop();   // driven by the trace, not by the timer
+
+    const int64_t end = trace.last().at_ms + interval;
+    int row = 0;
+    for (now = 0; now < end; now += interval) {
+        while (row + 1 < trace.size() && trace.at(row + 1).at_ms <= now) {
+            ++row;
+        }
+        feed(trace.at(row));
+        governor.tick(now);
+    }
+    if (!mode.isEmpty()) {
+        timeInMode[mode] += now - modeSince;
+    }
+
+    out << "\n" << QString("%1 %2\n").arg("mode", -14).arg("seconds", 8);
+    for (auto it = timeInMode.cbegin(); it != timeInMode.cend(); ++it) {
+        out << QString("%1 %2\n").arg(it.key(), -14).arg(it.value() / 1000.0, 8, 'f', 0);
+    }
+    out << "switches: " << governor.switchCount() << ", platform_profile now " << PerformanceMode::getPerformanceMode() << "\n\n";
+
+    // Cost of one tick; time stands still, so the dwell time keeps the
+    // profile where it is and no write is measured
+    CpuLoadSampler fakeCpu;
+    SyscallCounter counter;
+    QList<Measurement> results;
+    results << measure("CpuLoadSampler::sample() fake /proc/stat", iterations, counter, [&](int) { fakeCpu.sample(); });
+    results << measure("CpuLoadSampler::sample() real /proc/stat", iterations, counter, [&](int) { realCpu.sample(); });
+    results << measure("PerformanceGovernor::tick() no switch", iterations, counter, [&](int) { governor.tick(now); });
+    printMeasurements(out, results, counter.scope());
+    return PerformanceMode::getPerformanceMode() == governor.currentMode() ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "DeviceSupport.h"
+#include "FakeSysfs.h"
+#include "KeyboardBacklight.h"
+#include "SysfsRoot.h"
+#include "UeventMonitor.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <initializer_list>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+// Replays uevents recorded while samsung-galaxybook was unloaded and
+// loaded again, through a socketpair standing in for the netlink socket,
+// against a fake tree whose keyboard LED is removed and re-created to
+// match. Reports the latency from the last message of a burst to
+// devicesChanged(), checks that the cached support flags follow the tree,
+// measures how cheaply unrelated traffic (battery "change" events) is
+// dropped, and compares a cached isSupported() with the stat it replaced.
+
+namespace {
+
+QByteArray uevent(std::initializer_list<const char*> fields)
+{
+    QByteArray message;
+    for (const char* field : fields) {
+        message += field;
+        message += '\0';
+    }
+    return message;
+}
+
+QVector<QByteArray> unloadMessages()
+{
+    return {
+        uevent({"remove@/devices/platform/SAM0429:00/leds/samsung-galaxybook::kbd_backlight", "ACTION=remove",
+                "DEVPATH=/devices/platform/SAM0429:00/leds/samsung-galaxybook::kbd_backlight", "SUBSYSTEM=leds",
+                "SEQNUM=5012"}),
+        uevent({"remove@/devices/virtual/firmware-attributes/samsung-galaxybook", "ACTION=remove",
+                "DEVPATH=/devices/virtual/firmware-attributes/samsung-galaxybook", "SUBSYSTEM=firmware-attributes",
+                "SEQNUM=5013"}),
+        uevent({"unbind@/devices/platform/SAM0429:00", "ACTION=unbind", "DEVPATH=/devices/platform/SAM0429:00",
+                "SUBSYSTEM=platform", "SEQNUM=5014"}),
+        uevent({"remove@/module/samsung_galaxybook", "ACTION=remove", "DEVPATH=/module/samsung_galaxybook",
+                "SUBSYSTEM=module", "SEQNUM=5015"}),
+    };
+}
+
+QVector<QByteArray> loadMessages()
+{
+    return {
+        uevent({"add@/module/samsung_galaxybook", "ACTION=add", "DEVPATH=/module/samsung_galaxybook",
+                "SUBSYSTEM=module", "SEQNUM=5016"}),
+        uevent({"add@/devices/virtual/firmware-attributes/samsung-galaxybook", "ACTION=add",
+                "DEVPATH=/devices/virtual/firmware-attributes/samsung-galaxybook", "SUBSYSTEM=firmware-attributes",
+                "SEQNUM=5017"}),
+        uevent({"add@/devices/platform/SAM0429:00/leds/samsung-galaxybook::kbd_backlight", "ACTION=add",
+                "DEVPATH=/devices/platform/SAM0429:00/leds/samsung-galaxybook::kbd_backlight", "SUBSYSTEM=leds",
+                "SEQNUM=5018"}),
+        uevent({"bind@/devices/platform/SAM0429:00", "ACTION=bind", "DEVPATH=/devices/platform/SAM0429:00",
+                "SUBSYSTEM=platform", "DRIVER=samsung-galaxybook", "MODALIAS=acpi:SAM0429:", "SEQNUM=5019"}),
+    };
+}
+
+QByteArray batteryChange(int capacity)
+{
+    QByteArray capacityField = "POWER_SUPPLY_CAPACITY=" + QByteArray::number(capacity);
+    return uevent({"change@/devices/LNXSYSTM:00/LNXSYBUS:00/PNP0A08:00/device:4c/PNP0C09:00/PNP0C0A:00/power_supply/BAT1",
+                   "ACTION=change",
+                   "DEVPATH=/devices/LNXSYSTM:00/LNXSYBUS:00/PNP0A08:00/device:4c/PNP0C09:00/PNP0C0A:00/power_supply/BAT1",
+                   "SUBSYSTEM=power_supply", "POWER_SUPPLY_NAME=BAT1", "POWER_SUPPLY_STATUS=Discharging",
+                   capacityField.constData(), "SEQNUM=6000"});
+}
+
+// udev re-broadcasts on another group with a binary header; must be ignored
+QByteArray libudevMessage()
+{
+    return uevent({"libudev", "\xfe\xed\xca\xfe"});
+}
+
+bool inject(int fd, const QVector<QByteArray>& messages)
+{
+    for (const QByteArray& message : messages) {
+        if (::send(fd, message.constData(), message.size(), MSG_NOSIGNAL) != message.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int runHotplugBenchmark(const QStringList& args)
+{
+    const int cycles = intOption(args, "--cycles", 200);
+    const int noise = intOption(args, "--noise", 20000);
+
+    QTemporaryDir root;
+    QString error;
+    if (!root.isValid() || !FakeSysfs::create(root.path(), &error)) {
+        QTextStream(stderr) << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    SysfsRoot::setRoot(root.path());
+    const QString ledDirectory = SysfsRoot::path("/sys/class/leds/samsung-galaxybook::kbd_backlight");
+
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) != 0) {
+        QTextStream(stderr) << "Cannot create socketpair\n";
+        return 1;
+    }
+    // The monitor owns fds[0]
+    UeventMonitor monitor;
+    monitor.setSettleInterval(0);
+    monitor.open(fds[0]);
+    int notifications = 0;
+    int64_t notified_at = 0;
+    QObject::connect(&monitor, &UeventMonitor::devicesChanged, [&] {
+        ++notifications;
+        notified_at = nowNs();
+    });
+
+    QTextStream out(stdout);
+    int failures = 0;
+    std::vector<int64_t> latencies;
+    const QVector<QByteArray> unload = unloadMessages();
+    const QVector<QByteArray> load = loadMessages();
+    for (int cycle = 0; cycle < cycles; ++cycle) {
+        const bool removing = cycle % 2 == 0;
+        if (removing) {
+            QDir(ledDirectory).removeRecursively();
+        } else {
+            FakeSysfs::create(root.path(), &error);
+        }
+
+        int before = notifications;
+        inject(fds[1], removing ? unload : load);
+        int64_t sent_at = nowNs();
+        if (!waitFor([&] { return notifications > before; }, 1000)) {
+            ++failures;
+            continue;
+        }
+        latencies.push_back(notified_at - sent_at);
+
+        DeviceSupport::refresh();
+        if (KeyboardBacklight::isSupported() == removing) {
+            ++failures;
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    // Unrelated traffic: parsed and dropped, no notification
+    int before = notifications;
+    quint64 received = monitor.statistics().messages;
+    QVector<QByteArray> batch;
+    for (int i = 0; i < 64; ++i) {
+        batch.append(i == 0 ? libudevMessage() : batteryChange(i % 100));
+    }
+    int64_t noise_start = nowNs();
+    for (int sent = 0; sent < noise; sent += batch.size()) {
+        inject(fds[1], batch);
+        // Stay below the socket buffer
+        waitFor([&] { return monitor.statistics().messages >= received + static_cast<quint64>(sent + batch.size()); }, 1000);
+    }
+    int64_t noise_ns = nowNs() - noise_start;
+    waitFor([] { return false; }, 20);
+    if (notifications != before) {
+        ++failures;
+    }
+    const quint64 noise_messages = monitor.statistics().messages - received;
+
+    SyscallCounter counter;
+    QList<Measurement> results;
+    const QString brightness = KeyboardBacklight::getBrightnessFilePath();
+    int sink = 0;
+    results << measure("legacy  QFile::exists() per check", 200000, counter, [&](int) {
+        sink += QFile::exists(brightness);
+    });
+    results << measure("cached  KeyboardBacklight::isSupported()", 200000, counter, [&](int) {
+        sink += KeyboardBacklight::isSupported();
+    });
+
+    const UeventMonitor::Statistics& stats = monitor.statistics();
+    out << "replayed " << cycles << " unload/load bursts of " << unload.size() << " uevents\n"
+        << QString("burst to devicesChanged()  p50 %1 us  p99 %2 us  max %3 us\n")
+               .arg(percentile(latencies, 0.50), 0, 'f', 1)
+               .arg(percentile(latencies, 0.99), 0, 'f', 1)
+               .arg(latencies.empty() ? 0.0 : latencies.back() / 1e3, 0, 'f', 1)
+        << QString("unrelated uevents  %1 ns each  (%2 messages, %3 notifications)\n")
+               .arg(noise_messages ? static_cast<double>(noise_ns) / noise_messages : 0.0, 0, 'f', 0)
+               .arg(noise_messages)
+               .arg(notifications - before)
+        << QString("messages %1  malformed %2  relevant %3  overflows %4  notifications %5\n")
+               .arg(stats.messages).arg(stats.malformed).arg(stats.relevant).arg(stats.overflows).arg(stats.notifications)
+        << "support flags followed the tree: " << (failures == 0 ? "yes" : "NO") << "\n\n";
+    printMeasurements(out, results, counter.scope());
+
+    ::close(fds[1]);
+    return failures == 0 && sink >= 0 ? 0 : 1;
+}
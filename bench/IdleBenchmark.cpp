@@ -0,0 +1,210 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "AttributeTable.h"
+#include "BackgroundMonitor.h"
+#include "DeviceControls.h"
+#include "FakeSysfs.h"
+#include "SysfsRoot.h"
+
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QPair>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern char **environ;
+
+// Resident footprint and idle wakeups over a fixed window on a fake tree.
+// The in-process part runs the BackgroundMonitor the tray keeps, idles
+// for --window milliseconds and then checks that a backlight change is
+// still picked up. With --gui PATH the GUI is also spawned on the
+// offscreen platform, once with its window and once with --background,
+// and sampled from /proc after --settle milliseconds.
+//
+// Wakeups are context switches summed over every thread of the process:
+// each time a thread blocks and is later woken counts once.
+
+namespace {
+
+struct ProcessSample
+{
+    qint64 rss_kb = -1;
+    quint64 switches = 0;
+    int threads = 0;
+};
+
+qint64 statusField(const QByteArray& status, const QByteArray& field)
+{
+    int at = status.indexOf("\n" + field + ":");
+    if (at < 0) {
+        return -1;
+    }
+    int end = status.indexOf('\n', at + 1);
+    return status.mid(at + field.size() + 2, end - at - field.size() - 2).trimmed().split(' ').first().toLongLong();
+}
+
+ProcessSample sampleProcess(qint64 pid)
+{
+    ProcessSample sample;
+    QString base = QString("/proc/%1").arg(pid);
+    QFile status(base + "/status");
+    if (!status.open(QIODevice::ReadOnly)) {
+        return sample;
+    }
+    sample.rss_kb = statusField(status.readAll(), "VmRSS");
+    const QStringList tasks = QDir(base + "/task").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& task : tasks) {
+        QFile taskStatus(base + "/task/" + task + "/status");
+        if (!taskStatus.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        QByteArray text = taskStatus.readAll();
+        sample.switches += static_cast<quint64>(qMax<qint64>(0, statusField(text, "voluntary_ctxt_switches")))
+                           + static_cast<quint64>(qMax<qint64>(0, statusField(text, "nonvoluntary_ctxt_switches")));
+        ++sample.threads;
+    }
+    return sample;
+}
+
+// Runs the event loop for msec with nothing but the one timer that ends it
+void idle(int msec)
+{
+    QEventLoop loop;
+    QTimer::singleShot(msec, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+qint64 spawnQuiet(const QStringList& arguments)
+{
+    std::vector<QByteArray> storage;
+    for (const QString& argument : arguments) {
+        storage.push_back(QFile::encodeName(argument));
+    }
+    std::vector<char *> argv;
+    for (QByteArray& argument : storage) {
+        argv.push_back(argument.data());
+    }
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    pid_t pid;
+    int status = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    return status == 0 ? pid : -1;
+}
+
+void printRow(QTextStream& out, const QString& label, const ProcessSample& before, const ProcessSample& after,
+              int window_ms)
+{
+    if (before.rss_kb < 0 || after.rss_kb < 0) {
+        out << QString("%1 failed\n").arg(label, -28);
+        return;
+    }
+    quint64 wakeups = after.switches - before.switches;
+    out << QString("%1 %2 %3 %4 %5\n")
+               .arg(label, -28)
+               .arg(after.rss_kb / 1024.0, 9, 'f', 1)
+               .arg(after.threads, 8)
+               .arg(wakeups, 9)
+               .arg(wakeups * 1000.0 / window_ms, 10, 'f', 2);
+}
+
+} // namespace
+
+int runIdleBenchmark(const QStringList& args)
+{
+    const int window_ms = intOption(args, "--window", 10000);
+    const int settle_ms = intOption(args, "--settle", 3000);
+    int index = args.indexOf("--gui");
+    const QString gui = index >= 0 && index + 1 < args.size() ? args.at(index + 1) : QString();
+    QTextStream out(stdout);
+
+    QTemporaryDir root;
+    QTemporaryDir home;
+    QString error;
+    if (!root.isValid() || !home.isValid() || !FakeSysfs::create(root.path(), &error)) {
+        QTextStream(stderr) << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    SysfsRoot::setRoot(root.path());
+
+    out << QString("%1 %2 %3 %4 %5\n")
+               .arg("process", -28)
+               .arg("RSS (MiB)", 9)
+               .arg("threads", 8)
+               .arg("wakeups", 9)
+               .arg("per second", 10);
+
+    const qint64 self = QCoreApplication::applicationPid();
+    BackgroundMonitor monitor;
+    monitor.start();
+    QString seen;
+    QObject::connect(&monitor, &BackgroundMonitor::valueChanged, [&seen](const QString& name, const QString& value) {
+        if (name == DeviceControls::keyboard_backlight) {
+            seen = value;
+        }
+    });
+    // Let anything left over from startup run first
+    idle(100);
+
+    quint64 monitorWakeups = monitor.wakeups();
+    ProcessSample before = sampleProcess(self);
+    idle(window_ms);
+    ProcessSample after = sampleProcess(self);
+    monitorWakeups = monitor.wakeups() - monitorWakeups;
+    printRow(out, "bench, BackgroundMonitor", before, after, window_ms);
+
+    // Still awake to the hotkey after all that sleeping
+    QFile brightness(AttributeTable::path<AttributeTable::KeyboardBrightness>());
+    QFile announce(AttributeTable::monitoringPath<AttributeTable::KeyboardBrightness>());
+    bool reacted = brightness.open(QIODevice::WriteOnly | QIODevice::Truncate) && brightness.write("3\n") > 0;
+    brightness.close();
+    if (announce.fileName() != brightness.fileName() && announce.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        announce.write("3\n");
+        announce.close();
+    }
+    reacted = reacted && waitFor([&] { return seen == "3"; }, 2000);
+
+    bool guiOk = true;
+    if (!gui.isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+        qputenv("XDG_CACHE_HOME", QFile::encodeName(home.path() + "/cache"));
+        qputenv("XDG_DATA_HOME", QFile::encodeName(home.path() + "/data"));
+        const QList<QPair<QString, QStringList>> modes = {
+            {"GUI, window", {gui, "--sysfs-root", root.path()}},
+            {"GUI, --background", {gui, "--sysfs-root", root.path(), "--background"}},
+        };
+        for (const auto& mode : modes) {
+            qint64 pid = spawnQuiet(mode.second);
+            if (pid < 0) {
+                out << QString("%1 failed to start\n").arg(mode.first, -28);
+                guiOk = false;
+                continue;
+            }
+            QThread::msleep(static_cast<unsigned long>(settle_ms));
+            ProcessSample guiBefore = sampleProcess(pid);
+            QThread::msleep(static_cast<unsigned long>(window_ms));
+            ProcessSample guiAfter = sampleProcess(pid);
+            printRow(out, mode.first, guiBefore, guiAfter, window_ms);
+            guiOk = guiOk && guiAfter.rss_kb >= 0;
+            ::kill(static_cast<pid_t>(pid), SIGTERM);
+            ::waitpid(static_cast<pid_t>(pid), nullptr, 0);
+        }
+    }
+
+    out << "\nidle window: " << window_ms << " ms; watcher and uevent wakeups in it: " << monitorWakeups
+        << "; backlight change after idling " << (reacted ? "seen" : "MISSED") << "\n";
+    // Kernel uevents (a battery's periodic change) also count; not a failure
+    return reacted && guiOk ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "BatteryChargeControl.h"
+#include "FakeSysfs.h"
+#include "FirmwareAttribute.h"
+#include "KeyboardBacklight.h"
+#include "PerformanceMode.h"
+#include "SysfsRoot.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+// Compares the original per-call QFile/QTextStream access pattern against
+// the feature classes on a fake sysfs tree in a temporary directory.
+
+namespace {
+
+// The access pattern used before SysfsAttribute existed
+int legacyGetInt(const QString& path)
+{
+    QFile file(path);
+    int value = 0;
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream in(&file);
+        in >> value;
+        file.close();
+    }
+    return value;
+}
+
+void legacySetInt(const QString& path, int value)
+{
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QTextStream out(&file);
+        out << value;
+        file.close();
+    }
+}
+
+QString legacyGetString(const QString& path)
+{
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream in(&file);
+        QString content = in.readAll().trimmed();
+        file.close();
+        return content;
+    }
+    return "";
+}
+
+void legacySetProfile(const QString& dir, const QString& mode)
+{
+    QStringList modes = legacyGetString(dir + "/platform_profile_choices").split(' ', Qt::SkipEmptyParts);
+    if (!QFile::exists(dir + "/platform_profile") || !modes.contains(mode)) {
+        return;
+    }
+    QFile file(dir + "/platform_profile");
+    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QTextStream out(&file);
+        out << mode;
+        file.close();
+    }
+}
+
+void legacySetFirmwareAttribute(const QString& dir, int value)
+{
+    if (!QDir(dir).exists()) {
+        return;
+    }
+    QStringList tokens = legacyGetString(dir + "/possible_values").split(';', Qt::SkipEmptyParts);
+    bool valid = false;
+    for (const QString& token : tokens) {
+        bool ok;
+        if (token.toInt(&ok) == value && ok) {
+            valid = true;
+        }
+    }
+    if (valid) {
+        legacySetInt(dir + "/current_value", value);
+    }
+}
+
+} // namespace
+
+int runIoBenchmark(const QStringList& args)
+{
+    int iterations = intOption(args, "--iterations", 20000);
+
+    QTemporaryDir root;
+    QString error;
+    if (!root.isValid() || !FakeSysfs::create(root.path(), &error)) {
+        QTextStream(stderr) << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    SysfsRoot::setRoot(root.path());
+
+    const QString led = SysfsRoot::path("/sys/class/leds/samsung-galaxybook::kbd_backlight");
+    const QString acpi = SysfsRoot::path("/sys/firmware/acpi");
+    const QString threshold = SysfsRoot::path("/sys/class/power_supply/BAT1/charge_control_end_threshold");
+    const QString attribute = FirmwareAttribute::getBasePath() + "usb_charging";
+
+    SyscallCounter counter;
+    QList<Measurement> results;
+    volatile int sink = 0;
+
+    results << measure("legacy  brightness get", iterations, counter, [&](int) {
+        sink = legacyGetInt(led + "/brightness");
+    });
+    results << measure("legacy  brightness set", iterations, counter, [&](int i) {
+        legacySetInt(led + "/brightness", i & 3);
+    });
+    results << measure("legacy  charge threshold get", iterations, counter, [&](int) {
+        sink = legacyGetInt(threshold);
+    });
+    results << measure("legacy  platform_profile get", iterations, counter, [&](int) {
+        sink = legacyGetString(acpi + "/platform_profile").size();
+    });
+    results << measure("legacy  platform_profile set", iterations, counter, [&](int i) {
+        legacySetProfile(acpi, (i & 1) ? "quiet" : "balanced");
+    });
+    results << measure("legacy  firmware attribute set", iterations, counter, [&](int i) {
+        legacySetFirmwareAttribute(attribute, i & 1);
+    });
+
+    FirmwareAttribute usbCharging("usb_charging");
+
+    results << measure("current brightness get", iterations, counter, [&](int) {
+        sink = KeyboardBacklight::getBrightness();
+    });
+    results << measure("current brightness set", iterations, counter, [&](int i) {
+        KeyboardBacklight::setBrightness(i & 3);
+    });
+    results << measure("current charge threshold get", iterations, counter, [&](int) {
+        sink = BatteryChargeControl::getChargeEndThreshold();
+    });
+    results << measure("current platform_profile get", iterations, counter, [&](int) {
+        sink = PerformanceMode::getPerformanceMode().size();
+    });
+    results << measure("current platform_profile set", iterations, counter, [&](int i) {
+        PerformanceMode::setPerformanceMode((i & 1) ? "quiet" : "balanced");
+    });
+    results << measure("current firmware attribute validate", iterations, counter, [&](int i) {
+        sink = usbCharging.isValidValue(i & 1);
+    });
+    results << measure("current firmware attribute set", iterations, counter, [&](int i) {
+        usbCharging.set(i & 1);
+    });
+
+    QTextStream out(stdout);
+    out << "iterations: " << iterations << "\n";
+    printMeasurements(out, results, counter.scope());
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "ChangeJournal.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Appends to a change journal on a temporary file, against writing one
+// text log line per change, then fills the ring and measures how fast a
+// query scans it: a full per-control count and a single-control timeline.
+
+namespace {
+
+const char* const controls[] = {"keyboard_backlight", "performance_mode", "charge_end_threshold",
+                                "power_on_lid_open", "usb_charging", "block_recording"};
+const char* const values[] = {"0", "1", "2", "3", "quiet", "balanced", "performance", "80"};
+
+} // namespace
+
+int runJournalBenchmark(const QStringList& args)
+{
+    const int records = intOption(args, "--records", 1 << 21);
+    const int appends = intOption(args, "--appends", 1000000);
+
+    QTemporaryDir directory;
+    ChangeJournal journal;
+    quint64 capacity = 1;
+    while (capacity < static_cast<quint64>(records)) {
+        capacity <<= 1;
+    }
+    if (!directory.isValid() || !journal.open(directory.filePath("journal"), capacity)) {
+        QTextStream(stderr) << "Cannot create journal: " << journal.errorString() << "\n";
+        return 1;
+    }
+    int ids[6];
+    for (int i = 0; i < 6; ++i) {
+        ids[i] = journal.attributeId(controls[i]);
+    }
+    const QString valueStrings[] = {values[0], values[1], values[2], values[3],
+                                    values[4], values[5], values[6], values[7]};
+
+    int log = ::open(QFile::encodeName(directory.filePath("log")).constData(),
+                     O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    SyscallCounter counter;
+    QList<Measurement> results;
+    results << measure("text log line per change", appends, counter, [&](int i) {
+        QByteArray line = QByteArray::number(nowNs()) + " " + controls[i % 6] + " " + values[i & 7] + " "
+                        + values[(i + 1) & 7] + " hardware\n";
+        ssize_t written = ::write(log, line.constData(), line.size());
+        Q_UNUSED(written);
+    });
+    ::close(log);
+    results << measure("journal append", appends, counter, [&](int i) {
+        journal.append(ids[i % 6], valueStrings[i & 7], valueStrings[(i + 1) & 7],
+                       static_cast<ChangeJournal::Origin>(i % 6), 1234);
+    });
+
+    // Top up so the ring holds the requested number of records
+    for (quint64 i = journal.head(); i < static_cast<quint64>(records); ++i) {
+        journal.append(ids[i % 6], valueStrings[i & 7], valueStrings[(i + 1) & 7],
+                       static_cast<ChangeJournal::Origin>(i % 6));
+    }
+    const quint64 retained = journal.head() - journal.firstSequence();
+
+    ChangeJournal reader;
+    reader.openReadOnly(directory.filePath("journal"));
+    quint64 counts[ChangeJournal::max_attributes] = {};
+    results << measure(QString("count per control (%1 records)").arg(retained), 5, counter, [&](int) {
+        reader.scan(0, [&](const ChangeJournal::Record& record) { ++counts[record.attribute % ChangeJournal::max_attributes]; });
+    });
+    const int performance = reader.attributeId("performance_mode");
+    quint64 timeline = 0;
+    results << measure(QString("performance_mode timeline (%1 records)").arg(retained), 5, counter, [&](int) {
+        reader.scan(0, [&](const ChangeJournal::Record& record) {
+            if (record.attribute == performance && record.origin == ChangeJournal::Origin::Hardware) {
+                ++timeline;
+            }
+        });
+    });
+
+    QTextStream out(stdout);
+    printMeasurements(out, results, counter.scope());
+    const Measurement& scan = results.at(2);
+    out << "\n" << QString("scan rate %1 M records/s, %2 ns per record\n")
+                       .arg(retained / scan.ns_per_op * 1e3, 0, 'f', 1)
+                       .arg(scan.ns_per_op / retained, 0, 'f', 2);
+    return counts[ids[0]] > 0 && timeline > 0 ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "FakeSysfs.h"
+#include "SysfsRoot.h"
+
+#include <QTextStream>
+
+int runMakeFixture(const QStringList& args)
+{
+    QTextStream err(stderr);
+    if (args.isEmpty() || args.first().startsWith("--")) {
+        err << "Usage: galaxybook-bench mkfixture <directory> [--attributes N]\n";
+        return 2;
+    }
+
+    FakeSysfs::Options options;
+    options.synthetic_attributes = intOption(args, "--attributes", 0);
+
+    QString error;
+    if (!FakeSysfs::create(args.first(), options, &error)) {
+        err << error << "\n";
+        return 1;
+    }
+    QTextStream(stdout) << "Run against it with " << SysfsRoot::environment_variable << "=" << args.first() << "\n";
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "FakeSysfs.h"
+#include "FirmwareAttribute.h"
+#include "KeyboardBacklight.h"
+#include "Metrics.h"
+#include "SysfsRoot.h"
+
+#include <QTemporaryDir>
+#include <QTextStream>
+
+// What the instrumentation costs on the hardware paths: the same reads,
+// writes and validations with recording off, on, and on with a trace
+// capture running. Build once plain and once with CONFIG+=galaxybook_trace
+// to compare against the uninstrumented code.
+
+int runMetricsBenchmark(const QStringList& args)
+{
+    const int iterations = intOption(args, "--iterations", 20000);
+
+    QTemporaryDir root;
+    QString error;
+    if (!root.isValid() || !FakeSysfs::create(root.path(), &error)) {
+        QTextStream(stderr) << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    SysfsRoot::setRoot(root.path());
+
+    FirmwareAttribute usbCharging("usb_charging");
+    int sink = 0;
+    auto read = [&](int) { sink += usbCharging.get(); };
+    auto write = [&](int i) { usbCharging.set(i & 1); };
+    auto validate = [&](int i) { sink += usbCharging.isValidValue(i & 3); };
+    auto backlight = [&](int) { sink += KeyboardBacklight::getBrightness(); };
+
+    SyscallCounter counter;
+    QList<Measurement> results;
+    const struct {
+        const char* label;
+        bool recording;
+        bool capturing;
+    } modes[] = {
+        {"off    ", false, false},
+        {"on     ", true, false},
+        {"capture", true, true},
+    };
+    for (const auto& mode : modes) {
+        Metrics::setEnabled(mode.recording);
+        if (mode.capturing) {
+            Metrics::startCapture(iterations * 8);
+        }
+        results << measure(QString("%1 FirmwareAttribute::get()").arg(mode.label), iterations, counter, read)
+                << measure(QString("%1 FirmwareAttribute::set()").arg(mode.label), iterations, counter, write)
+                << measure(QString("%1 FirmwareAttribute::isValidValue()").arg(mode.label), iterations, counter, validate)
+                << measure(QString("%1 KeyboardBacklight::getBrightness()").arg(mode.label), iterations, counter, backlight);
+    }
+    QByteArray trace = Metrics::stopCapture();
+    Metrics::setEnabled(false);
+
+    QTextStream out(stdout);
+    out << "instrumentation " << (Metrics::compiledIn() ? "compiled in" : "not compiled in") << "\n";
+    printMeasurements(out, results, counter.scope());
+    out << "\ncaptured " << trace.count("\"ph\":\"X\"") << " trace events (" << trace.size() << " bytes)\n\n"
+        << Metrics::prometheusText();
+    return sink >= 0 ? 0 : 1;
+}
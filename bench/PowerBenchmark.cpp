@@ -0,0 +1,112 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "BatteryChargeControl.h"
+#include "FakeSysfs.h"
+#include "PowerSampler.h"
+#include "SysfsRoot.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <memory>
+#include <time.h>
+
+// Measures what one battery sample costs: PowerSampler::sample() on held
+// descriptors against opening each attribute with QFile, the ring buffer
+// hand-off, and the CPU time of the sampler thread running on its timerfd.
+
+namespace {
+
+int64_t processCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+int legacyRead(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    return file.readAll().trimmed().toInt();
+}
+
+int legacySink = 0;
+
+void legacySample(const QString& battery)
+{
+    legacySink += legacyRead(battery + "/power_now") + legacyRead(battery + "/energy_now")
+                + legacyRead(battery + "/voltage_now") + legacyRead(battery + "/current_now");
+    QFile status(battery + "/status");
+    if (status.open(QIODevice::ReadOnly)) {
+        legacySink += status.readAll().trimmed() == "Charging";
+    }
+}
+
+} // namespace
+
+int runPowerBenchmark(const QStringList& args)
+{
+    const int samples = intOption(args, "--samples", 100000);
+    const int rate = intOption(args, "--rate-hz", 100);
+    const int duration = intOption(args, "--duration-ms", 2000);
+
+    QTemporaryDir root;
+    QString error;
+    if (!root.isValid() || !FakeSysfs::create(root.path(), &error)) {
+        QTextStream(stderr) << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    SysfsRoot::setRoot(root.path());
+    const QString battery = BatteryChargeControl::getBasePath();
+
+    auto sampler = std::make_unique<PowerSampler>();
+    if (!sampler->isSupported()) {
+        QTextStream(stderr) << "Fake battery has no power attributes\n";
+        return 1;
+    }
+
+    SyscallCounter counter;
+    QList<Measurement> results;
+    results << measure("legacy  QFile per attribute", samples, counter, [&](int) { legacySample(battery); });
+    results << measure("held    PowerSampler::sample()", samples, counter, [&](int) { sampler->sample(); });
+
+    auto ring = std::make_unique<SpscRing<PowerSample, PowerSampler::ring_capacity>>();
+    PowerSample sample = sampler->sample();
+    results << measure("ring    push + pop", samples, counter, [&](int) {
+        ring->push(sample);
+        ring->pop(sample);
+    });
+
+    // The thread on its timerfd, while this thread sleeps
+    int64_t cpu_before = processCpuNs();
+    if (!sampler->start(1000 / std::max(1, rate))) {
+        QTextStream(stderr) << sampler->errorString() << "\n";
+        return 1;
+    }
+    QThread::msleep(duration);
+    sampler->stop();
+    int64_t cpu = processCpuNs() - cpu_before;
+
+    int collected = 0;
+    while (sampler->pop(sample)) {
+        ++collected;
+    }
+
+    QTextStream out(stdout);
+    out << "samples: " << samples << "\n";
+    printMeasurements(out, results, counter.scope());
+
+    double cpu_per_sample = collected > 0 ? static_cast<double>(cpu) / collected : 0;
+    out << "\n" << QString("sampler thread at %1 Hz for %2 ms\n").arg(rate).arg(duration);
+    out << QString("  samples collected      %1 (dropped %2, missed ticks %3)\n")
+               .arg(collected).arg(sampler->droppedCount()).arg(sampler->missedTicks());
+    out << QString("  cpu per sample         %1 us\n").arg(cpu_per_sample / 1000, 0, 'f', 2);
+    out << QString("  cpu at %1 Hz            %2 %\n").arg(rate, -3).arg(100.0 * cpu / (duration * 1e6), 0, 'f', 4);
+    out << QString("  cpu at 1 Hz (derived)  %1 %\n").arg(100.0 * cpu_per_sample / 1e9, 0, 'f', 6);
+    return collected > 0 ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "FakeSysfs.h"
+#include "SysfsRoot.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern char **environ;
+
+// Cold-start comparison of galaxybook-ctl against the GUI. Each run spawns
+// the program against a fake tree and waits for it to exit; the GUI runs on
+// the offscreen platform with --quit-after-show --report-startup and its
+// time to first paint and to interactive are taken from that report.
+// "cold" runs start without a capability snapshot, "warm" runs with the
+// one the previous run left behind (XDG_CACHE_HOME points at a temporary
+// directory). Neither drops the kernel's page cache.
+
+namespace {
+
+struct Command
+{
+    QString label;
+    QStringList arguments;
+};
+
+// Wall time of one spawn-to-exit in microseconds, or -1 on failure
+double runOnce(const QStringList& arguments)
+{
+    std::vector<QByteArray> storage;
+    for (const QString& argument : arguments) {
+        storage.push_back(QFile::encodeName(argument));
+    }
+    std::vector<char *> argv;
+    for (QByteArray& argument : storage) {
+        argv.push_back(argument.data());
+    }
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    int64_t start = nowNs();
+    pid_t pid;
+    int status = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (status != 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return -1;
+    }
+    return (nowNs() - start) / 1000.0;
+}
+
+struct GuiTimes
+{
+    double first_paint_us = -1;
+    double interactive_us = -1;
+    double exit_us = -1;
+};
+
+// Like runOnce, but reads the milestones the GUI prints on stdout
+bool runGuiOnce(const QStringList& arguments, GuiTimes& times)
+{
+    std::vector<QByteArray> storage;
+    for (const QString& argument : arguments) {
+        storage.push_back(QFile::encodeName(argument));
+    }
+    std::vector<char *> argv;
+    for (QByteArray& argument : storage) {
+        argv.push_back(argument.data());
+    }
+    argv.push_back(nullptr);
+
+    int pipe_fds[2];
+    if (::pipe2(pipe_fds, O_CLOEXEC) != 0) {
+        return false;
+    }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    int64_t start = nowNs();
+    pid_t pid;
+    int status = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    ::close(pipe_fds[1]);
+    if (status != 0) {
+        ::close(pipe_fds[0]);
+        return false;
+    }
+
+    QByteArray output;
+    char buffer[512];
+    ssize_t length;
+    while ((length = ::read(pipe_fds[0], buffer, sizeof(buffer))) > 0 || (length < 0 && errno == EINTR)) {
+        if (length > 0) {
+            output.append(buffer, length);
+        }
+    }
+    ::close(pipe_fds[0]);
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return false;
+    }
+    times.exit_us = (nowNs() - start) / 1000.0;
+
+    for (const QByteArray& line : output.split('\n')) {
+        QList<QByteArray> fields = line.split(' ');
+        if (fields.size() != 2) {
+            continue;
+        }
+        double at = (fields.at(1).toLongLong() - start) / 1000.0;
+        if (fields.at(0) == "first-paint") {
+            times.first_paint_us = at;
+        } else if (fields.at(0) == "interactive") {
+            times.interactive_us = at;
+        }
+    }
+    return times.first_paint_us >= 0 && times.interactive_us >= 0;
+}
+
+void printRow(QTextStream& out, const QString& label, std::vector<double> samples)
+{
+    if (samples.empty()) {
+        out << QString("%1 failed\n").arg(label, -30);
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    out << QString("%1 %2 %3 %4\n")
+               .arg(label, -30)
+               .arg(samples.front() / 1000.0, 10, 'f', 2)
+               .arg(samples[samples.size() / 2] / 1000.0, 12, 'f', 2)
+               .arg(samples.back() / 1000.0, 10, 'f', 2);
+}
+
+QString option(const QStringList& args, const QString& name, const QString& default_value)
+{
+    int index = args.indexOf(name);
+    return index >= 0 && index + 1 < args.size() ? args.at(index + 1) : default_value;
+}
+
+} // namespace
+
+int runStartupBenchmark(const QStringList& args)
+{
+    const int runs = intOption(args, "--runs", 20);
+    const QString ctl = option(args, "--ctl", "galaxybook-ctl");
+    const QString gui = option(args, "--gui", "galaxybook-control");
+
+    QTemporaryDir root;
+    QString error;
+    if (!root.isValid() || !FakeSysfs::create(root.path(), &error)) {
+        QTextStream(stderr) << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    QTemporaryDir cache;
+    if (!cache.isValid()) {
+        QTextStream(stderr) << "Cannot create a cache directory\n";
+        return 1;
+    }
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    qputenv("XDG_CACHE_HOME", QFile::encodeName(cache.path()));
+    qputenv(SysfsRoot::environment_variable, QFile::encodeName(root.path()));
+
+    const QList<Command> commands = {
+        {"ctl get keyboard_backlight", {ctl, "--direct", "get", "keyboard_backlight"}},
+        {"ctl set keyboard_backlight", {ctl, "--direct", "set", "keyboard_backlight", "2"}},
+        {"ctl list", {ctl, "--direct", "list"}},
+    };
+
+    QTextStream out(stdout);
+    out << QString("%1 %2 %3 %4\n").arg("command", -30).arg("min (ms)", 10).arg("median (ms)", 12).arg("max (ms)", 10);
+    for (const Command& command : commands) {
+        std::vector<double> samples;
+        for (int i = 0; i < runs; ++i) {
+            double elapsed = runOnce(command.arguments);
+            if (elapsed < 0) {
+                break;
+            }
+            samples.push_back(elapsed);
+        }
+        printRow(out, command.label, samples);
+    }
+
+    const QStringList guiArguments = {gui, "--quit-after-show", "--report-startup"};
+    const QString snapshot = cache.path() + "/galaxybook-control/capabilities";
+    for (bool warm : {false, true}) {
+        std::vector<double> first_paint, interactive, exited;
+        for (int i = 0; i < runs; ++i) {
+            if (!warm) {
+                QFile::remove(snapshot);
+            }
+            GuiTimes times;
+            if (!runGuiOnce(guiArguments, times)) {
+                break;
+            }
+            first_paint.push_back(times.first_paint_us);
+            interactive.push_back(times.interactive_us);
+            exited.push_back(times.exit_us);
+        }
+        QString mode = warm ? "warm" : "cold";
+        printRow(out, "gui " + mode + " first paint", first_paint);
+        printRow(out, "gui " + mode + " interactive", interactive);
+        printRow(out, "gui " + mode + " exit", exited);
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "AttributeTable.h"
+#include "FakeSysfs.h"
+#include "StatePublisher.h"
+#include "StateSnapshotReader.h"
+#include "SysfsRoot.h"
+
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+// Reads of the shared-memory state snapshot, alone and with many reader
+// threads while the publisher updates it as fast as --rate allows, against
+// reading the same value from sysfs. The publisher writes each entry's own
+// change count as its value, so a reader that ever sees the two differ has
+// been handed a torn copy.
+
+namespace {
+
+struct ReaderResult
+{
+    uint64_t reads = 0;
+    uint64_t failures = 0;
+    uint64_t torn = 0;
+    uint64_t versions_seen = 0;
+};
+
+} // namespace
+
+int runStateSnapshotBenchmark(const QStringList& args)
+{
+    const int iterations = intOption(args, "--iterations", 200000);
+    const int reader_count = std::max(1, intOption(args, "--readers", 8));
+    const int duration_ms = intOption(args, "--duration", 2000);
+    const int rate = intOption(args, "--rate", 100000);
+    QTextStream out(stdout);
+
+    QTemporaryDir root;
+    QString error;
+    if (!root.isValid() || !FakeSysfs::create(root.path(), &error)) {
+        QTextStream(stderr) << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    SysfsRoot::setRoot(root.path());
+
+    const QString name = QString("/galaxybook-bench-state-%1").arg(::getpid());
+    StatePublisher publisher;
+    if (!publisher.open(name)) {
+        QTextStream(stderr) << publisher.errorString() << "\n";
+        return 1;
+    }
+    // The entries the daemon publishes, plus the counter the readers check
+    publisher.publish("keyboard_backlight", "2");
+    publisher.publish("performance_mode", "balanced");
+    publisher.publish("charge_end_threshold", "80");
+    publisher.publish("usb_charging", "1");
+    publisher.publish("counter", "1");
+
+    StateSnapshotReader reader;
+    if (!reader.open(name.toLocal8Bit().constData())) {
+        QTextStream(stderr) << "Cannot open " << name << "\n";
+        return 1;
+    }
+
+    using Table = AttributeTable;
+    SyscallCounter counter;
+    QList<Measurement> results;
+    StateSnapshotReader::Snapshot snapshot;
+    char value[StateSnapshotReader::value_size];
+    volatile int sink = 0;
+
+    results << measure("sysfs     keyboard_backlight tryGet", iterations, counter, [&](int) {
+        sink = Table::tryGet<Table::KeyboardBrightness>().valueOr(-1);
+    });
+    results << measure("snapshot  keyboard_backlight get", iterations, counter, [&](int) {
+        sink = reader.get("keyboard_backlight", value, sizeof(value)) ? value[0] : -1;
+    });
+    results << measure("snapshot  version poll", iterations, counter, [&](int) {
+        sink = static_cast<int>(reader.version());
+    });
+    results << measure("snapshot  full read", iterations, counter, [&](int) {
+        sink = reader.read(snapshot) ? static_cast<int>(snapshot.count) : -1;
+    });
+    int published = 1;
+    results << measure("publisher update", iterations, counter, [&](int) {
+        ++published;
+        publisher.publish("counter", QString::number(published));
+    });
+
+    // Concurrent phase: one publisher, reader_count readers
+    std::atomic<bool> running{true};
+    std::vector<ReaderResult> readerResults(reader_count);
+    std::vector<std::thread> threads;
+    for (int r = 0; r < reader_count; ++r) {
+        threads.emplace_back([&, r] {
+            StateSnapshotReader local;
+            if (!local.open(name.toLocal8Bit().constData())) {
+                ++readerResults[r].failures;
+                return;
+            }
+            ReaderResult& result = readerResults[r];
+            StateSnapshotReader::Snapshot copy;
+            uint64_t last_version = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                if (!local.read(copy)) {
+                    ++result.failures;
+                    continue;
+                }
+                ++result.reads;
+                if (copy.version != last_version) {
+                    last_version = copy.version;
+                    ++result.versions_seen;
+                }
+                const StateSnapshotReader::Entry *entry = copy.find("counter");
+                if (!entry || std::strtoul(entry->value, nullptr, 10) != entry->changes) {
+                    ++result.torn;
+                }
+            }
+        });
+    }
+
+    const int64_t interval_ns = rate > 0 ? 1000000000LL / rate : 0;
+    uint64_t updates = 0;
+    int64_t begin = nowNs();
+    int64_t next = begin;
+    while (nowNs() - begin < static_cast<int64_t>(duration_ms) * 1000000) {
+        if (nowNs() < next) {
+            continue;
+        }
+        next += interval_ns;
+        ++published;
+        publisher.publish("counter", QString::number(published));
+        ++updates;
+    }
+    running = false;
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double seconds = static_cast<double>(nowNs() - begin) / 1e9;
+
+    ReaderResult total;
+    for (const ReaderResult& result : readerResults) {
+        total.reads += result.reads;
+        total.failures += result.failures;
+        total.torn += result.torn;
+        total.versions_seen += result.versions_seen;
+    }
+
+    out << "iterations: " << iterations << "\n\n";
+    printMeasurements(out, results, counter.scope());
+    out << "\n" << reader_count << " readers for " << duration_ms << " ms, publisher at " << updates / seconds
+        << " updates/s\n";
+    out << QString("  %1 reads/s per reader, %2 ns per read\n")
+               .arg(total.reads / seconds / reader_count, 0, 'f', 0)
+               .arg(total.reads ? seconds * 1e9 * reader_count / total.reads : 0.0, 0, 'f', 1);
+    out << "  versions seen per reader: " << total.versions_seen / reader_count << " of " << updates << "\n";
+    out << "  gave up: " << total.failures << ", torn copies: " << total.torn << "\n";
+    return total.torn == 0 && sink != -2 ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "AttributeTable.h"
+#include "DeviceControls.h"
+#include "FakeSysfs.h"
+#include "SysfsAttribute.h"
+#include "SysfsRoot.h"
+#include "UnsupportedFeatureException.h"
+
+#include <QTemporaryDir>
+#include <QTextStream>
+
+// Get and set throughput of the fixed attributes through AttributeTable,
+// against the hand-written feature classes it replaced and against the
+// string-valued DeviceControl interface the daemon uses.
+
+namespace {
+
+// The feature classes as they were before the table: a base path joined
+// with the file name on first use, and the limit or choices file read
+// again on every validated set
+namespace handwritten {
+
+const QString& ledPath()
+{
+    static const QString path = SysfsRoot::path("/sys/class/leds/samsung-galaxybook::kbd_backlight");
+    return path;
+}
+
+const SysfsAttribute& brightnessFile()
+{
+    static const SysfsAttribute file(ledPath() + "/brightness");
+    return file;
+}
+
+const SysfsAttribute& maxBrightnessFile()
+{
+    static const SysfsAttribute file(ledPath() + "/max_brightness");
+    return file;
+}
+
+const SysfsAttribute& profileFile()
+{
+    static const SysfsAttribute file(SysfsRoot::path("/sys/firmware/acpi") + "/platform_profile");
+    return file;
+}
+
+const SysfsAttribute& choicesFile()
+{
+    static const SysfsAttribute file(SysfsRoot::path("/sys/firmware/acpi") + "/platform_profile_choices");
+    return file;
+}
+
+const SysfsAttribute& thresholdFile()
+{
+    static const SysfsAttribute file(SysfsRoot::path("/sys/class/power_supply/BAT1") + "/charge_control_end_threshold");
+    return file;
+}
+
+int getBrightness()
+{
+    if (!DeviceSupport::isPresent(DeviceSupport::Feature::KeyboardBacklight)) {
+        throw UnsupportedFeatureException("Keyboard backlight is not supported on this device");
+    }
+    int level = 0;
+    brightnessFile().readInt(level);
+    return level;
+}
+
+// Range checked against max_brightness, as KeyboardBacklightControl did
+void setBrightness(int level)
+{
+    if (!DeviceSupport::isPresent(DeviceSupport::Feature::KeyboardBacklight)) {
+        throw UnsupportedFeatureException("Keyboard backlight is not supported on this device");
+    }
+    int maximum = 0;
+    maxBrightnessFile().readInt(maximum);
+    if (level < 0 || level > maximum) {
+        throw UnsupportedFeatureException("Keyboard backlight level is out of range");
+    }
+    brightnessFile().writeInt(level);
+}
+
+void setPerformanceMode(const QString& mode)
+{
+    if (!DeviceSupport::isPresent(DeviceSupport::Feature::PerformanceMode)) {
+        throw UnsupportedFeatureException("Performance mode is not supported");
+    }
+    QByteArray modeBytes = mode.toLatin1();
+    char choices[SysfsAttribute::buffer_size];
+    ssize_t length = choicesFile().read(choices, sizeof(choices));
+    if (length < 0 || !SysfsAttribute::containsToken(choices, static_cast<size_t>(length), modeBytes.constData(),
+                                                     static_cast<size_t>(modeBytes.size()), ' ')) {
+        throw UnsupportedFeatureException("Performance mode " + mode + " is not supported");
+    }
+    profileFile().write(modeBytes.constData(), static_cast<size_t>(modeBytes.size()));
+}
+
+QString getPerformanceMode()
+{
+    if (!DeviceSupport::isPresent(DeviceSupport::Feature::PerformanceMode)) {
+        throw UnsupportedFeatureException("Performance mode is not supported");
+    }
+    char mode[64];
+    ssize_t length = profileFile().read(mode, sizeof(mode));
+    return length < 0 ? QString() : QString::fromLatin1(mode, static_cast<int>(length));
+}
+
+void setChargeEndThreshold(int threshold)
+{
+    if (!DeviceSupport::isPresent(DeviceSupport::Feature::BatteryChargeControl)) {
+        throw UnsupportedFeatureException("Battery charge control is not supported on this device");
+    }
+    if (threshold < 1 || threshold > 100) {
+        throw UnsupportedFeatureException("Charge end threshold must be between 1 and 100");
+    }
+    thresholdFile().writeInt(threshold);
+}
+
+} // namespace handwritten
+
+} // namespace
+
+int runTableBenchmark(const QStringList& args)
+{
+    const int iterations = intOption(args, "--iterations", 20000);
+
+    QTemporaryDir root;
+    QString error;
+    if (!root.isValid() || !FakeSysfs::create(root.path(), &error)) {
+        QTextStream(stderr) << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    SysfsRoot::setRoot(root.path());
+
+    using Table = AttributeTable;
+    const QString modes[] = {"quiet", "balanced"};
+    DeviceControls controls;
+    DeviceControl *keyboard = controls.find(DeviceControls::keyboard_backlight);
+    DeviceControl *profile = controls.find(DeviceControls::performance_mode);
+    const QString levels[] = {"0", "1", "2", "3"};
+
+    SyscallCounter counter;
+    QList<Measurement> results;
+    volatile int sink = 0;
+
+    results << measure("classes  brightness get", iterations, counter, [&](int) {
+        sink = handwritten::getBrightness();
+    });
+    results << measure("table    brightness get", iterations, counter, [&](int) {
+        sink = Table::get<Table::KeyboardBrightness>();
+    });
+    results << measure("control  brightness get", iterations, counter, [&](int) {
+        sink = keyboard->get().size();
+    });
+
+    results << measure("classes  brightness set (range checked)", iterations, counter, [&](int i) {
+        handwritten::setBrightness(i & 3);
+    });
+    results << measure("table    brightness set (range checked)", iterations, counter, [&](int i) {
+        Table::set<Table::KeyboardBrightness>(i & 3);
+    });
+    results << measure("control  brightness set (range checked)", iterations, counter, [&](int i) {
+        keyboard->set(levels[i & 3]);
+    });
+
+    results << measure("classes  platform_profile get", iterations, counter, [&](int) {
+        sink = handwritten::getPerformanceMode().size();
+    });
+    results << measure("table    platform_profile get", iterations, counter, [&](int) {
+        sink = Table::get<Table::PlatformProfile>().size();
+    });
+
+    results << measure("classes  platform_profile set", iterations, counter, [&](int i) {
+        handwritten::setPerformanceMode(modes[i & 1]);
+    });
+    results << measure("table    platform_profile set", iterations, counter, [&](int i) {
+        Table::set<Table::PlatformProfile>(modes[i & 1]);
+    });
+    results << measure("control  platform_profile set", iterations, counter, [&](int i) {
+        profile->set(modes[i & 1]);
+    });
+
+    results << measure("classes  charge threshold set", iterations, counter, [&](int i) {
+        handwritten::setChargeEndThreshold(80 + (i & 1));
+    });
+    results << measure("table    charge threshold set", iterations, counter, [&](int i) {
+        Table::set<Table::ChargeEndThreshold>(80 + (i & 1));
+    });
+
+    // The failure path: validation rejects before any write
+    int rejected = 0;
+    results << measure("classes  rejected brightness set", iterations, counter, [&](int) {
+        try {
+            handwritten::setBrightness(99);
+        } catch (const UnsupportedFeatureException&) {
+            ++rejected;
+        }
+    });
+    results << measure("table    rejected brightness set", iterations, counter, [&](int) {
+        try {
+            Table::set<Table::KeyboardBrightness>(99);
+        } catch (const UnsupportedFeatureException&) {
+            ++rejected;
+        }
+    });
+
+    QTextStream out(stdout);
+    out << "iterations: " << iterations << "\n";
+    printMeasurements(out, results, counter.scope());
+    return rejected > 0 && sink >= 0 ? 0 : 1;
+}
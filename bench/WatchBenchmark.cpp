@@ -0,0 +1,118 @@
+#include "Benchmarks.h"
+#include "BenchUtil.h"
+#include "FakeSysfs.h"
+#include "KeyboardBacklight.h"
+#include "SysfsAttribute.h"
+#include "SysfsRoot.h"
+#include "SysfsWatcher.h"
+
+#include <QFileSystemWatcher>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+// Writes bursts of changes to a watched attribute on a fake tree and
+// measures, for QFileSystemWatcher and SysfsWatcher, the latency from the
+// last write to the first notification and how many notifications each
+// burst produces.
+
+namespace {
+
+struct WatchResult
+{
+    double latency_us = 0;
+    double signals_per_burst = 0;
+    int missed_bursts = 0;
+};
+
+template <typename Watcher>
+WatchResult run(Watcher& watcher, const QString& path, int bursts, int burst_length)
+{
+    SysfsAttribute attribute(path);
+    int received = 0;
+    int64_t received_at = 0;
+    QMetaObject::Connection connection = QObject::connect(&watcher, &Watcher::fileChanged, [&](const QString&) {
+        if (received++ == 0) {
+            received_at = nowNs();
+        }
+    });
+
+    WatchResult result;
+    int64_t total_latency = 0;
+    int total_signals = 0;
+    for (int burst = 0; burst < bursts; ++burst) {
+        received = 0;
+        for (int i = 0; i < burst_length; ++i) {
+            attribute.writeInt((burst + i) & 3);
+        }
+        int64_t written_at = nowNs();
+
+        if (!waitFor([&] { return received > 0; }, 500)) {
+            ++result.missed_bursts;
+            continue;
+        }
+        total_latency += received_at - written_at;
+
+        // Let any trailing notifications for this burst arrive
+        waitFor([] { return false; }, 30);
+        total_signals += received;
+    }
+
+    QObject::disconnect(connection);
+
+    int delivered = bursts - result.missed_bursts;
+    if (delivered > 0) {
+        result.latency_us = static_cast<double>(total_latency) / delivered / 1000.0;
+        result.signals_per_burst = static_cast<double>(total_signals) / delivered;
+    }
+    return result;
+}
+
+void print(QTextStream& out, const char* name, const WatchResult& result)
+{
+    out << QString("%1 %2 %3 %4\n")
+               .arg(name, -20)
+               .arg(result.latency_us, 14, 'f', 1)
+               .arg(result.signals_per_burst, 18, 'f', 2)
+               .arg(result.missed_bursts, 14);
+}
+
+} // namespace
+
+int runWatchBenchmark(const QStringList& args)
+{
+    const int bursts = intOption(args, "--bursts", 50);
+    const int burst_length = intOption(args, "--burst", 10);
+
+    QTemporaryDir root;
+    QString error;
+    if (!root.isValid() || !FakeSysfs::create(root.path(), &error)) {
+        QTextStream(stderr) << "Cannot create fake sysfs tree: " << error << "\n";
+        return 1;
+    }
+    SysfsRoot::setRoot(root.path());
+    const QString path = KeyboardBacklight::getHwChangedFilePath();
+
+    QFileSystemWatcher qtWatcher;
+    qtWatcher.addPath(path);
+    WatchResult qtResult = run(qtWatcher, path, bursts, burst_length);
+    qtWatcher.removePath(path);
+
+    SysfsWatcher sysfsWatcher;
+    sysfsWatcher.addPath(path);
+    WatchResult sysfsResult = run(sysfsWatcher, path, bursts, burst_length);
+
+    QTextStream out(stdout);
+    out << "bursts: " << bursts << " of " << burst_length << " writes\n";
+    out << QString("%1 %2 %3 %4\n")
+               .arg("watcher", -20)
+               .arg("latency (us)", 14)
+               .arg("signals/burst", 18)
+               .arg("missed bursts", 14);
+    print(out, "QFileSystemWatcher", qtResult);
+    print(out, "SysfsWatcher", sysfsResult);
+
+    const SysfsWatcher::Statistics& stats = sysfsWatcher.statistics();
+    out << "SysfsWatcher: " << stats.wakeups << " wakeups, " << stats.raw_events << " raw events, "
+        << stats.emitted << " signals, " << stats.overflows << " overflows\n";
+    return 0;
+}
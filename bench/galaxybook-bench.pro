@@ -0,0 +1,38 @@
+QT = core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = galaxybook-bench
+
+include(../core.pri)
+
+SOURCES += \
+    AmbientBenchmark.cpp \
+    AsyncStressBenchmark.cpp \
+    BatteryHistoryBenchmark.cpp \
+    BenchUtil.cpp \
+    DaemonLoadBenchmark.cpp \
+    DiscoveryBenchmark.cpp \
+    DispatchBenchmark.cpp \
+    DragBenchmark.cpp \
+    ErrorPathBenchmark.cpp \
+    FakeSysfs.cpp \
+    GovernorBenchmark.cpp \
+    HotplugBenchmark.cpp \
+    IdleBenchmark.cpp \
+    IoBenchmark.cpp \
+    JournalBenchmark.cpp \
+    MakeFixture.cpp \
+    MetricsBenchmark.cpp \
+    PowerBenchmark.cpp \
+    StartupBenchmark.cpp \
+    StateSnapshotBenchmark.cpp \
+    TableBenchmark.cpp \
+    WatchBenchmark.cpp \
+    main.cpp
+
+HEADERS += \
+    BenchUtil.h \
+    Benchmarks.h \
+    FakeSysfs.h
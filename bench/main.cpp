@@ -0,0 +1,66 @@
+#include "Benchmarks.h"
+
+#include <QCoreApplication>
+#include <QTextStream>
+#include <functional>
+
+namespace {
+
+struct Scenario
+{
+    const char* name;
+    const char* description;
+    std::function<int(const QStringList&)> run;
+};
+
+const Scenario scenarios[] = {
+    {"mkfixture", "create a fake sysfs tree for GALAXYBOOK_SYSFS_ROOT", runMakeFixture},
+    {"io", "per-call QFile I/O versus held-open pread/pwrite attributes", runIoBenchmark},
+    {"dispatch", "change notification dispatch latency per event", runDispatchBenchmark},
+    {"watch", "notification latency and coalescing, QFileSystemWatcher vs SysfsWatcher", runWatchBenchmark},
+    {"daemon-load", "request throughput and p50/p99 latency against the control socket", runDaemonLoadBenchmark},
+    {"startup", "cold start of galaxybook-ctl versus the GUI (--ctl/--gui PATH)", runStartupBenchmark},
+    {"drag", "writes and UI-thread stalls for a 100-step slider drag, direct vs WriteScheduler", runDragBenchmark},
+    {"async-stress", "UI-thread latency with HardwareWorker under load and a slow attribute", runAsyncStressBenchmark},
+    {"discovery", "firmware attribute discovery cost for 10, 100 and 10000 attributes", runDiscoveryBenchmark},
+    {"power", "per-sample cost of the battery power sampler and its ring buffer", runPowerBenchmark},
+    {"governor", "replay a load trace through the performance governor (--trace FILE)", runGovernorBenchmark},
+    {"metrics", "overhead of the latency metrics and trace capture on the hardware paths", runMetricsBenchmark},
+    {"hotplug", "replay recorded uevents through a socketpair and check the cached support flags", runHotplugBenchmark},
+    {"journal", "change journal append cost and query scan rate over millions of records", runJournalBenchmark},
+    {"table", "attribute table accessors versus the hand-written feature classes", runTableBenchmark},
+    {"errors", "expected failures through exceptions versus ControlResult", runErrorPathBenchmark},
+    {"state", "shared-memory state snapshot reads with many concurrent readers (--readers N)", runStateSnapshotBenchmark},
+    {"idle", "RSS and wakeups over an idle window, background monitor and GUI (--gui PATH)", runIdleBenchmark},
+    {"ambient", "replay a lux trace through the IIO buffer into the keyboard backlight (--trace FILE)", runAmbientBenchmark},
+    {"battery", "a year of battery history: file size, compaction and year queries (--days N)", runBatteryHistoryBenchmark},
+};
+
+int usage()
+{
+    QTextStream err(stderr);
+    err << "Usage: galaxybook-bench <scenario> [options]\n\nScenarios:\n";
+    for (const Scenario& scenario : scenarios) {
+        err << QString("  %1 %2\n").arg(scenario.name, -16).arg(scenario.description);
+    }
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments().mid(1);
+    if (args.isEmpty()) {
+        return usage();
+    }
+
+    QString name = args.takeFirst();
+    for (const Scenario& scenario : scenarios) {
+        if (name == scenario.name) {
+            return scenario.run(args);
+        }
+    }
+    return usage();
+}
@@ -0,0 +1,80 @@
+# Hardware access layer shared by the GUI and the command-line tools
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+# qmake CONFIG+=galaxybook_trace compiles in the Metrics instrumentation
+galaxybook_trace: DEFINES += GALAXYBOOK_TRACE
+
+SOURCES += \
+    $$PWD/AmbientBacklight.cpp \
+    $$PWD/AmbientLightSensor.cpp \
+    $$PWD/AttributeTable.cpp \
+    $$PWD/BackgroundMonitor.cpp \
+    $$PWD/BatteryChargeControl.cpp \
+    $$PWD/BatteryHistory.cpp \
+    $$PWD/CapabilitySnapshot.cpp \
+    $$PWD/ChangeDispatcher.cpp \
+    $$PWD/ChangeJournal.cpp \
+    $$PWD/ControlClient.cpp \
+    $$PWD/ControlProtocol.cpp \
+    $$PWD/ControlResult.cpp \
+    $$PWD/ControlServer.cpp \
+    $$PWD/DaemonWriter.cpp \
+    $$PWD/DeviceControls.cpp \
+    $$PWD/DeviceSupport.cpp \
+    $$PWD/FirmwareAttribute.cpp \
+    $$PWD/HardwareWorker.cpp \
+    $$PWD/KeyboardBacklight.cpp \
+    $$PWD/Metrics.cpp \
+    $$PWD/MetricsExporter.cpp \
+    $$PWD/PerformanceGovernor.cpp \
+    $$PWD/PerformanceMode.cpp \
+    $$PWD/PowerSampler.cpp \
+    $$PWD/Profiles.cpp \
+    $$PWD/StateCache.cpp \
+    $$PWD/StatePublisher.cpp \
+    $$PWD/StateSnapshotReader.cpp \
+    $$PWD/SysfsAttribute.cpp \
+    $$PWD/SysfsRoot.cpp \
+    $$PWD/SysfsWatcher.cpp \
+    $$PWD/UeventMonitor.cpp \
+    $$PWD/UnsupportedFeatureException.cpp \
+    $$PWD/WriteScheduler.cpp
+
+HEADERS += \
+    $$PWD/AmbientBacklight.h \
+    $$PWD/AmbientLightSensor.h \
+    $$PWD/AttributeTable.h \
+    $$PWD/BackgroundMonitor.h \
+    $$PWD/BatteryChargeControl.h \
+    $$PWD/BatteryHistory.h \
+    $$PWD/CapabilitySnapshot.h \
+    $$PWD/ChangeDispatcher.h \
+    $$PWD/ChangeJournal.h \
+    $$PWD/ControlClient.h \
+    $$PWD/ControlProtocol.h \
+    $$PWD/ControlResult.h \
+    $$PWD/ControlServer.h \
+    $$PWD/DaemonWriter.h \
+    $$PWD/DeviceControls.h \
+    $$PWD/DeviceSupport.h \
+    $$PWD/FirmwareAttribute.h \
+    $$PWD/HardwareWorker.h \
+    $$PWD/KeyboardBacklight.h \
+    $$PWD/Metrics.h \
+    $$PWD/MetricsExporter.h \
+    $$PWD/PerformanceGovernor.h \
+    $$PWD/PerformanceMode.h \
+    $$PWD/PowerSampler.h \
+    $$PWD/Profiles.h \
+    $$PWD/SpscRing.h \
+    $$PWD/StateCache.h \
+    $$PWD/StatePublisher.h \
+    $$PWD/StateSnapshotReader.h \
+    $$PWD/SysfsAttribute.h \
+    $$PWD/SysfsRoot.h \
+    $$PWD/SysfsWatcher.h \
+    $$PWD/UeventMonitor.h \
+    $$PWD/UnsupportedFeatureException.h \
+    $$PWD/WriteScheduler.h
@@ -0,0 +1,288 @@
+#include "WorkloadBenchmark.h"
+#include "PerformanceMode.h"
+#include "PowerSampler.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThread>
+#include <cerrno>
+#include <cmath>
+#include <memory>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+double seconds(const struct timeval& time)
+{
+    return time.tv_sec + time.tv_usec / 1e6;
+}
+
+double monotonicSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// JSON null for readings the battery could not provide
+QJsonValue reading(double value)
+{
+    return value < 0 ? QJsonValue() : QJsonValue(value);
+}
+
+QString cell(double value, int precision)
+{
+    return value < 0 ? QString("-") : QString::number(value, 'f', precision);
+}
+
+} // namespace
+
+double WorkloadBenchmark::ModeResult::meanWall() const
+{
+    double sum = 0;
+    for (const Run& run : runs) {
+        sum += run.wall_s;
+    }
+    return runs.isEmpty() ? 0 : sum / runs.size();
+}
+
+double WorkloadBenchmark::ModeResult::stddevWall() const
+{
+    if (runs.size() < 2) {
+        return 0;
+    }
+    double mean = meanWall();
+    double sum = 0;
+    for (const Run& run : runs) {
+        sum += (run.wall_s - mean) * (run.wall_s - mean);
+    }
+    return std::sqrt(sum / (runs.size() - 1));
+}
+
+double WorkloadBenchmark::ModeResult::meanCpu() const
+{
+    double sum = 0;
+    for (const Run& run : runs) {
+        sum += run.cpu_s;
+    }
+    return runs.isEmpty() ? 0 : sum / runs.size();
+}
+
+double WorkloadBenchmark::ModeResult::meanEnergy() const
+{
+    double sum = 0;
+    for (const Run& run : runs) {
+        if (run.energy_wh < 0) {
+            return -1;
+        }
+        sum += run.energy_wh;
+    }
+    return runs.isEmpty() ? -1 : sum / runs.size();
+}
+
+double WorkloadBenchmark::ModeResult::meanPower() const
+{
+    double sum = 0;
+    for (const Run& run : runs) {
+        if (run.average_w < 0) {
+            return -1;
+        }
+        sum += run.average_w;
+    }
+    return runs.isEmpty() ? -1 : sum / runs.size();
+}
+
+WorkloadBenchmark::WorkloadBenchmark(const Options& options)
+    : options(options)
+{
+}
+
+WorkloadBenchmark::Run WorkloadBenchmark::runOnce(PowerSampler& sampler) const
+{
+    std::vector<QByteArray> arguments;
+    for (const QString& argument : options.command) {
+        arguments.push_back(argument.toLocal8Bit());
+    }
+    std::vector<char *> argv;
+    for (QByteArray& argument : arguments) {
+        argv.push_back(argument.data());
+    }
+    argv.push_back(nullptr);
+
+    Run run;
+    PowerSample before = sampler.sample();
+    double started = monotonicSeconds();
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        ::execvp(argv[0], argv.data());
+        ::_exit(127);
+    }
+    if (pid < 0) {
+        run.exit_code = -1;
+        return run;
+    }
+    bool sampling = sampler.isSupported() && sampler.start(1000);
+
+    int status = 0;
+    struct rusage usage = {};
+    while (::wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+    }
+    run.wall_s = monotonicSeconds() - started;
+    run.cpu_s = seconds(usage.ru_utime) + seconds(usage.ru_stime);
+    run.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+
+    if (sampling) {
+        sampler.stop();
+    }
+    PowerSample after = sampler.sample();
+
+    // Readings mean something only while the battery alone powers the machine
+    const bool discharging = before.status == PowerSample::Status::Discharging
+                          && after.status == PowerSample::Status::Discharging;
+    if (discharging && before.energy_uwh >= 0 && after.energy_uwh >= 0) {
+        run.energy_wh = (before.energy_uwh - after.energy_uwh) / 1e6;
+    }
+    PowerSample sample;
+    double power_sum = 0;
+    int power_samples = 0;
+    while (sampler.pop(sample)) {
+        if (sample.status == PowerSample::Status::Discharging && sample.power_uw >= 0) {
+            power_sum += sample.power_uw / 1e6;
+            ++power_samples;
+        }
+    }
+    if (discharging && power_samples > 0) {
+        run.average_w = power_sum / power_samples;
+    }
+    return run;
+}
+
+QVector<WorkloadBenchmark::ModeResult> WorkloadBenchmark::run(const SetMode& set_mode, QTextStream& progress)
+{
+    QVector<ModeResult> results;
+    QStringList modes = options.modes;
+    QString original;
+    try {
+        if (modes.isEmpty()) {
+            modes = PerformanceMode::getSupportedPerformanceModes();
+        }
+        original = PerformanceMode::getPerformanceMode();
+    } catch (const std::exception& e) {
+        progress << e.what() << Qt::endl;
+        return results;
+    }
+
+    auto sampler = std::make_unique<PowerSampler>();
+    for (const QString& mode : modes) {
+        ModeResult result;
+        result.mode = mode;
+        QString error;
+        if (!set_mode(mode, error)) {
+            result.error = error;
+            progress << mode << ": " << error << Qt::endl;
+            results.append(result);
+            continue;
+        }
+
+        progress << mode << ": settling for " << options.settle_ms << " ms" << Qt::endl;
+        QThread::msleep(options.settle_ms);
+        for (int i = 0; i < options.warmup_runs + options.runs && result.error.isEmpty(); ++i) {
+            Run run = runOnce(*sampler);
+            if (run.exit_code != 0) {
+                result.error = QString("workload exited with %1").arg(run.exit_code);
+            } else if (i >= options.warmup_runs) {
+                result.runs.append(run);
+            }
+            progress << QString("  %1 %2/%3  %4 s  %5")
+                            .arg(i < options.warmup_runs ? "warm-up" : "run    ")
+                            .arg(i < options.warmup_runs ? i + 1 : i - options.warmup_runs + 1)
+                            .arg(i < options.warmup_runs ? options.warmup_runs : options.runs)
+                            .arg(run.wall_s, 0, 'f', 3)
+                            .arg(run.exit_code == 0 ? QString() : result.error)
+                     << Qt::endl;
+        }
+        results.append(result);
+    }
+
+    QString error;
+    if (!original.isEmpty() && !set_mode(original, error)) {
+        progress << "Could not restore " << original << ": " << error << Qt::endl;
+    }
+    return results;
+}
+
+QString WorkloadBenchmark::table(const QVector<ModeResult>& results) const
+{
+    // Wall time relative to the fastest mode that completed
+    double fastest = 0;
+    for (const ModeResult& result : results) {
+        if (result.error.isEmpty() && !result.runs.isEmpty() && (fastest == 0 || result.meanWall() < fastest)) {
+            fastest = result.meanWall();
+        }
+    }
+
+    QString text = QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+                       .arg("mode", -22).arg("runs", 4).arg("wall_s", 10).arg("stddev", 8)
+                       .arg("cpu_s", 10).arg("energy_Wh", 10).arg("avg_W", 8).arg("vs_fastest", 10);
+    for (const ModeResult& result : results) {
+        if (!result.error.isEmpty()) {
+            text += QString("%1 %2\n").arg(result.mode, -22).arg(result.error);
+            continue;
+        }
+        text += QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+                    .arg(result.mode, -22)
+                    .arg(result.runs.size(), 4)
+                    .arg(result.meanWall(), 10, 'f', 3)
+                    .arg(result.stddevWall(), 8, 'f', 3)
+                    .arg(result.meanCpu(), 10, 'f', 3)
+                    .arg(cell(result.meanEnergy(), 4), 10)
+                    .arg(cell(result.meanPower(), 2), 8)
+                    .arg(fastest > 0 ? QString::number(result.meanWall() / fastest, 'f', 2) + "x" : QString("-"), 10);
+    }
+    return text;
+}
+
+QByteArray WorkloadBenchmark::json(const QVector<ModeResult>& results) const
+{
+    QJsonArray modes;
+    for (const ModeResult& result : results) {
+        QJsonArray runs;
+        for (const Run& run : result.runs) {
+            runs.append(QJsonObject{
+                {"wall_s", run.wall_s},
+                {"cpu_s", run.cpu_s},
+                {"energy_wh", reading(run.energy_wh)},
+                {"average_w", reading(run.average_w)},
+                {"exit_code", run.exit_code},
+            });
+        }
+        QJsonObject mode{
+            {"mode", result.mode},
+            {"runs", runs},
+            {"wall_mean_s", result.meanWall()},
+            {"wall_stddev_s", result.stddevWall()},
+            {"cpu_mean_s", result.meanCpu()},
+            {"energy_mean_wh", reading(result.meanEnergy())},
+            {"power_mean_w", reading(result.meanPower())},
+        };
+        if (!result.error.isEmpty()) {
+            mode.insert("error", result.error);
+        }
+        modes.append(mode);
+    }
+
+    QJsonObject document{
+        {"command", QJsonArray::fromStringList(options.command)},
+        {"runs", options.runs},
+        {"warmup_runs", options.warmup_runs},
+        {"settle_ms", options.settle_ms},
+        {"modes", modes},
+    };
+    return QJsonDocument(document).toJson();
+}
@@ -0,0 +1,68 @@
+#ifndef WORKLOADBENCHMARK_H
+#define WORKLOADBENCHMARK_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+class PowerSampler;
+class QTextStream;
+
+// Runs a user-supplied workload under every performance mode and compares
+// wall time, CPU time and battery energy. Modes are switched through a
+// callback, so galaxybook-ctl can route the switch through the daemon;
+// everything else only reads sysfs and works on a fake tree as well.
+class WorkloadBenchmark
+{
+public:
+    struct Options
+    {
+        QStringList command;        // program and arguments, run without a shell
+        QStringList modes;          // empty for every supported mode
+        int runs = 3;
+        int warmup_runs = 1;
+        int settle_ms = 2000;       // after each switch, before the warm-up
+    };
+
+    struct Run
+    {
+        double wall_s = 0;
+        double cpu_s = 0;           // user + system time of the workload
+        double energy_wh = -1;      // -1 unless discharging throughout
+        double average_w = -1;      // mean power_now while it ran
+        int exit_code = 0;
+    };
+
+    struct ModeResult
+    {
+        QString mode;
+        QVector<Run> runs;
+        QString error;              // empty when every run succeeded
+
+        double meanWall() const;
+        double stddevWall() const;
+        double meanCpu() const;
+        double meanEnergy() const;  // -1 when any run lacks a reading
+        double meanPower() const;
+    };
+
+    using SetMode = std::function<bool(const QString& mode, QString& error)>;
+
+    explicit WorkloadBenchmark(const Options& options);
+
+    // Benchmarks each mode in turn, reporting progress as it goes, then
+    // switches back to the mode that was active before
+    QVector<ModeResult> run(const SetMode& set_mode, QTextStream& progress);
+
+    QString table(const QVector<ModeResult>& results) const;
+    QByteArray json(const QVector<ModeResult>& results) const;
+
+private:
+    Run runOnce(PowerSampler& sampler) const;
+
+    Options options;
+};
+
+#endif // WORKLOADBENCHMARK_H
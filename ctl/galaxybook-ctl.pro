@@ -0,0 +1,19 @@
+QT = core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = galaxybook-ctl
+
+include(../core.pri)
+
+SOURCES += \
+    WorkloadBenchmark.cpp \
+    main.cpp
+
+HEADERS += \
+    WorkloadBenchmark.h
+
+# Default rules for deployment.
+unix:!android: target.path = /opt/galaxybook-control/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,841 @@
+#include "BatteryHistory.h"
+#include "ChangeDispatcher.h"
+#include "ChangeJournal.h"
+#include "ControlClient.h"
+#include "ControlProtocol.h"
+#include "DeviceControls.h"
+#include "PowerSampler.h"
+#include "Profiles.h"
+#include "StateCache.h"
+#include "StateSnapshotReader.h"
+#include "SysfsRoot.h"
+#include "WorkloadBenchmark.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <time.h>
+#include <vector>
+
+// Command-line front end. Short-lived commands run without a
+// QCoreApplication; only watch starts an event loop. Requests go to
+// galaxybook-controld when its socket is reachable, so the daemon stays the
+// single writer, and fall back to direct sysfs access otherwise.
+
+namespace {
+
+QTextStream& out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+QTextStream& err()
+{
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+int usage()
+{
+    err() << "Usage: galaxybook-ctl [--direct] [--socket PATH] [--sysfs-root DIR] <command>\n"
+             "\n"
+             "Commands:\n"
+             "  list                  show every supported control, its value and accepted values\n"
+             "  get <name>            print the current value\n"
+             "  set <name> <value>    change a value\n"
+             "  watch [<name>...]     print '<name> <value>' whenever a control changes\n"
+             "  stats                 show the daemon's own-write and hardware change counters\n"
+             "  power [MS] [COUNT]    print battery power every MS milliseconds (default 1000)\n"
+             "  profile list          show the stored profiles\n"
+             "  profile save <name>   store the current settings as a profile\n"
+             "  profile apply <name>  apply a stored profile as one transaction\n"
+             "  profile delete <name> remove a stored profile\n"
+             "  benchmark [--runs N] [--warmup N] [--settle MS] [--modes A,B] [--json FILE] -- <command...>\n"
+             "                        run a workload under every performance mode and compare\n"
+             "  journal [--file PATH] [--attribute NAME] [--origin ORIGIN] [--since SECONDS] [--tail N] [--counts]\n"
+             "                        show recorded value changes, or count them per control and origin\n"
+             "  state [--shm NAME]    print the values galaxybook-controld publishes in shared memory\n"
+             "  battery [--file PATH] [--days N]\n"
+             "                        show recorded battery health and the wear seen at each charge threshold\n"
+             "\n"
+             "  --direct              access sysfs even if galaxybook-controld is running\n";
+    return 2;
+}
+
+// The operations every command needs, served by the daemon or by sysfs
+class Backend
+{
+public:
+    virtual ~Backend() = default;
+    virtual bool list(QStringList& names) = 0;
+    virtual bool get(const QString& name, QString& value) = 0;
+    virtual bool set(const QString& name, const QString& value) = 0;
+    virtual bool describe(const QString& name, QString& description) = 0;
+    virtual int watch(const QStringList& names) = 0;
+    // Applies all settings or none; reports writes, skips and latency
+    virtual bool apply(const Profile& profile, QString& summary) = 0;
+    virtual bool stats(QString& counters) = 0;
+    QString error;
+};
+
+class DaemonBackend : public Backend
+{
+public:
+    bool connect(const QString& socket_path) { return client.connectTo(socket_path); }
+
+    bool list(QStringList& names) override
+    {
+        QByteArray reply;
+        if (!call("list", reply)) {
+            return false;
+        }
+        names = QString::fromUtf8(reply).split(' ', Qt::SkipEmptyParts);
+        return true;
+    }
+
+    bool get(const QString& name, QString& value) override
+    {
+        QByteArray reply;
+        if (!call("get " + name.toUtf8(), reply)) {
+            return false;
+        }
+        value = QString::fromUtf8(reply);
+        return true;
+    }
+
+    bool set(const QString& name, const QString& value) override
+    {
+        QByteArray reply;
+        return call("set " + name.toUtf8() + " " + value.toUtf8(), reply);
+    }
+
+    bool describe(const QString& name, QString& description) override
+    {
+        QByteArray reply;
+        if (!call("describe " + name.toUtf8(), reply)) {
+            return false;
+        }
+        description = QString::fromUtf8(reply);
+        return true;
+    }
+
+    int watch(const QStringList& names) override
+    {
+        QByteArray reply;
+        if (!call("subscribe", reply)) {
+            err() << error << "\n";
+            return 1;
+        }
+        QByteArray event;
+        while (client.readEvent(event)) {
+            QString line = QString::fromUtf8(event);
+            if (names.isEmpty() || names.contains(line.section(' ', 0, 0))) {
+                out() << line << Qt::endl;
+            }
+        }
+        err() << client.errorString() << "\n";
+        return 1;
+    }
+
+    bool apply(const Profile& profile, QString& summary) override
+    {
+        QByteArray request = "apply";
+        for (const auto& setting : profile.settings) {
+            request += ' ' + setting.first.toUtf8() + '=' + setting.second.toUtf8();
+        }
+        QByteArray reply;
+        if (!call(request, reply)) {
+            return false;
+        }
+        QList<QByteArray> fields = reply.split(' ');
+        if (fields.size() >= 3) {
+            summary = QString("%1 written, %2 unchanged in %3 ms")
+                          .arg(QString::fromUtf8(fields.at(0)), QString::fromUtf8(fields.at(1)))
+                          .arg(fields.at(2).toLongLong() / 1e6, 0, 'f', 3);
+        }
+        return true;
+    }
+
+    bool stats(QString& counters) override
+    {
+        QByteArray reply;
+        if (!call("stats", reply)) {
+            return false;
+        }
+        counters = QString::fromUtf8(reply).replace(' ', '\n');
+        return true;
+    }
+
+private:
+    bool call(const QByteArray& request, QByteArray& reply)
+    {
+        if (client.request(request, reply)) {
+            return true;
+        }
+        error = client.errorString();
+        return false;
+    }
+
+    ControlClient client;
+};
+
+class DirectBackend : public Backend
+{
+public:
+    bool list(QStringList& names) override
+    {
+        for (const auto& control : controls.all()) {
+            if (control->isSupported()) {
+                names << control->name();
+            }
+        }
+        return true;
+    }
+
+    bool get(const QString& name, QString& value) override
+    {
+        DeviceControl *control = find(name);
+        if (!control) {
+            return false;
+        }
+        ControlResult<QString> result = control->tryGet();
+        if (!result.ok()) {
+            error = control->failureMessage(result.status());
+            return false;
+        }
+        value = result.value();
+        return true;
+    }
+
+    bool set(const QString& name, const QString& value) override
+    {
+        DeviceControl *control = find(name);
+        if (!control) {
+            return false;
+        }
+        ControlStatus status = control->trySet(value);
+        if (!status.ok()) {
+            error = control->failureMessage(status, value);
+            return false;
+        }
+        return true;
+    }
+
+    bool describe(const QString& name, QString& description) override
+    {
+        DeviceControl *control = find(name);
+        if (!control) {
+            return false;
+        }
+        description = control->describe();
+        return true;
+    }
+
+    int watch(const QStringList& names) override
+    {
+        int argc = 1;
+        char name[] = "galaxybook-ctl";
+        char *argv[] = {name, nullptr};
+        QCoreApplication app(argc, argv);
+
+        ChangeDispatcher dispatcher;
+        StateCache cache;
+        for (const auto& control : controls.all()) {
+            if (!control->isSupported() || (!names.isEmpty() && !names.contains(control->name()))) {
+                continue;
+            }
+            DeviceControl *watched = control;
+            // Otherwise printed on its first notification
+            ControlResult<QString> initial = watched->tryGet();
+            if (initial.ok()) {
+                cache.prime(watched->name(), initial.value());
+            }
+            dispatcher.watch(watched->monitoringFilePath(), [watched, &cache] {
+                ControlResult<QString> value = watched->tryGet();
+                if (!value.ok()) {
+                    err() << watched->failureMessage(value.status()) << Qt::endl;
+                    return;
+                }
+                // A notification that did not change the value prints nothing
+                if (cache.update(watched->name(), value.value())) {
+                    out() << watched->name() << " " << value.value() << Qt::endl;
+                }
+            });
+        }
+        if (dispatcher.watchedPaths().isEmpty()) {
+            err() << "Nothing to watch\n";
+            return 1;
+        }
+        return app.exec();
+    }
+
+    bool apply(const Profile& profile, QString& summary) override
+    {
+        ProfileApplier::Result result = ProfileApplier(controls).apply(profile);
+        if (!result.ok) {
+            error = result.error + (result.rolled_back ? " (rolled back)" : "");
+            return false;
+        }
+        summary = QString("%1 written, %2 unchanged in %3 ms (validate %4 ms, write %5 ms)")
+                      .arg(result.written)
+                      .arg(result.unchanged)
+                      .arg(result.total_ns / 1e6, 0, 'f', 3)
+                      .arg(result.validate_ns / 1e6, 0, 'f', 3)
+                      .arg(result.write_ns / 1e6, 0, 'f', 3);
+        return true;
+    }
+
+    bool stats(QString&) override
+    {
+        error = "Change counters are kept by galaxybook-controld, which is not running";
+        return false;
+    }
+
+private:
+    DeviceControl *find(const QString& name)
+    {
+        DeviceControl *control = controls.find(name);
+        if (!control) {
+            error = "Unknown control " + name;
+        }
+        return control;
+    }
+
+    DeviceControls controls;
+};
+
+int profileCommand(Backend& backend, const QStringList& args)
+{
+    ProfileStore store;
+    if (!store.load()) {
+        err() << store.errorString() << "\n";
+        return 1;
+    }
+
+    const QString action = args.value(0);
+    const QString name = args.value(1);
+    if (action == "list" && args.size() == 1) {
+        for (const Profile& profile : store.profiles()) {
+            QStringList settings;
+            for (const auto& setting : profile.settings) {
+                settings << setting.first + "=" + setting.second;
+            }
+            out() << QString("%1 %2\n").arg(profile.name, -16).arg(settings.join(' '));
+        }
+        return 0;
+    }
+    if (args.size() != 2 || name.isEmpty()) {
+        return usage();
+    }
+
+    if (action == "save") {
+        Profile profile;
+        profile.name = name;
+        QStringList names;
+        if (!backend.list(names)) {
+            err() << backend.error << "\n";
+            return 1;
+        }
+        for (const QString& control : names) {
+            QString value;
+            if (backend.get(control, value)) {
+                profile.settings.append({control, value});
+            }
+        }
+        store.insert(profile);
+    } else if (action == "delete") {
+        if (!store.remove(name)) {
+            err() << "No profile named " << name << "\n";
+            return 1;
+        }
+    } else if (action == "apply") {
+        const Profile *profile = store.find(name);
+        if (!profile) {
+            err() << "No profile named " << name << "\n";
+            return 1;
+        }
+        QString summary;
+        if (!backend.apply(*profile, summary)) {
+            err() << backend.error << "\n";
+            return 1;
+        }
+        out() << "Applied " << name << ": " << summary << "\n";
+        return 0;
+    } else {
+        return usage();
+    }
+
+    if (!store.save()) {
+        err() << store.errorString() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Scaled sysfs reading, or "-" when the battery does not report it
+QString scaled(int value, double divisor)
+{
+    return value < 0 ? QString("-") : QString::number(value / divisor, 'f', 3);
+}
+
+// Reads sysfs directly in every mode: sampling never writes, so it does
+// not need to go through the daemon
+int powerCommand(const QStringList& args)
+{
+    bool ok = true;
+    const int interval = args.isEmpty() ? 1000 : args.at(0).toInt(&ok);
+    const int count = args.size() < 2 ? 0 : args.at(1).toInt(&ok);
+    if (!ok || interval <= 0 || count < 0 || args.size() > 2) {
+        return usage();
+    }
+
+    auto sampler = std::make_unique<PowerSampler>();
+    if (!sampler->isSupported()) {
+        err() << "The battery reports neither power nor voltage and current\n";
+        return 1;
+    }
+    if (!sampler->start(interval)) {
+        err() << sampler->errorString() << "\n";
+        return 1;
+    }
+
+    out() << QString("%1 %2 %3 %4 %5 %6\n")
+                 .arg("time_s", 10).arg("power_W", 9).arg("energy_Wh", 10)
+                 .arg("voltage_V", 10).arg("current_A", 10).arg("status");
+    int64_t first = -1;
+    int printed = 0;
+    while (count == 0 || printed < count) {
+        // Drain in batches so fast captures do not wake this thread per sample
+        QThread::msleep(std::max(interval, 200));
+        PowerSample sample;
+        while ((count == 0 || printed < count) && sampler->pop(sample)) {
+            if (first < 0) {
+                first = sample.timestamp_ns;
+            }
+            out() << QString("%1 %2 %3 %4 %5 %6\n")
+                         .arg((sample.timestamp_ns - first) / 1e9, 10, 'f', 3)
+                         .arg(scaled(sample.power_uw, 1e6), 9)
+                         .arg(scaled(sample.energy_uwh, 1e6), 10)
+                         .arg(scaled(sample.voltage_uv, 1e6), 10)
+                         .arg(scaled(sample.current_ua, 1e6), 10)
+                         .arg(PowerSampler::statusName(sample.status));
+            ++printed;
+        }
+        out().flush();
+    }
+    if (sampler->droppedCount() > 0) {
+        err() << sampler->droppedCount() << " samples dropped\n";
+    }
+    return 0;
+}
+
+// Reads the journal file directly; the daemon's when it exists, the
+// window's otherwise
+int journalCommand(QStringList args)
+{
+    QString path = QFile::exists(ChangeJournal::system_path) ? QString(ChangeJournal::system_path)
+                                                              : ChangeJournal::defaultPath();
+    QString attribute;
+    QString originName;
+    qint64 since_s = -1;
+    int tail = 50;
+    bool counts = false;
+    bool ok = true;
+    while (!args.isEmpty()) {
+        QString option = args.takeFirst();
+        if (option == "--counts") {
+            counts = true;
+            continue;
+        }
+        if (args.isEmpty()) {
+            return usage();
+        }
+        QString value = args.takeFirst();
+        if (option == "--file") {
+            path = value;
+        } else if (option == "--attribute") {
+            attribute = value;
+        } else if (option == "--origin") {
+            originName = value;
+        } else if (option == "--since") {
+            since_s = value.toLongLong(&ok);
+        } else if (option == "--tail") {
+            tail = value.toInt(&ok);
+        } else {
+            return usage();
+        }
+        if (!ok) {
+            return usage();
+        }
+    }
+
+    ChangeJournal journal;
+    if (!journal.openReadOnly(path)) {
+        err() << journal.errorString() << "\n";
+        return 1;
+    }
+
+    // Filters compare integers, so the scan never touches strings
+    int attributeId = -1;
+    if (!attribute.isEmpty()) {
+        attributeId = journal.attributeId(attribute);
+        if (attributeId < 0) {
+            err() << "No changes of " << attribute << " recorded\n";
+            return 1;
+        }
+    }
+    ChangeJournal::Origin origin = ChangeJournal::Origin::Unknown;
+    if (!originName.isEmpty() && !ChangeJournal::parseOrigin(originName, origin)) {
+        err() << "Unknown origin " << originName << "\n";
+        return 2;
+    }
+    qint64 since_ns = 0;
+    if (since_s >= 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        since_ns = (static_cast<qint64>(now.tv_sec) - since_s) * 1000000000;
+    }
+
+    constexpr int origin_count = static_cast<int>(ChangeJournal::Origin::Governor) + 1;
+    std::vector<std::array<quint64, origin_count>> totals(ChangeJournal::max_attributes);
+    std::deque<ChangeJournal::Record> timeline;
+    quint64 matched = 0;
+    journal.scan(0, [&](const ChangeJournal::Record& record) {
+        if ((attributeId >= 0 && record.attribute != attributeId)
+            || (!originName.isEmpty() && record.origin != origin)
+            || record.timestamp_ns < since_ns) {
+            return;
+        }
+        ++matched;
+        if (counts) {
+            int index = std::min(static_cast<int>(record.origin), origin_count - 1);
+            ++totals[record.attribute % ChangeJournal::max_attributes][index];
+            return;
+        }
+        timeline.push_back(record);
+        if (static_cast<int>(timeline.size()) > tail) {
+            timeline.pop_front();
+        }
+    });
+
+    if (counts) {
+        QString header = QString("%1 %2").arg("control", -24).arg("total", 9);
+        for (int i = 0; i < origin_count; ++i) {
+            header += QString(" %1").arg(ChangeJournal::originName(static_cast<ChangeJournal::Origin>(i)), 9);
+        }
+        out() << header << "\n";
+        for (int id = 0; id < journal.attributeCount(); ++id) {
+            quint64 total = 0;
+            for (quint64 count : totals[id]) {
+                total += count;
+            }
+            if (total == 0) {
+                continue;
+            }
+            QString line = QString("%1 %2").arg(journal.attributeName(id), -24).arg(total, 9);
+            for (quint64 count : totals[id]) {
+                line += QString(" %1").arg(count, 9);
+            }
+            out() << line << "\n";
+        }
+    } else {
+        for (const ChangeJournal::Record& record : timeline) {
+            QString time = QDateTime::fromMSecsSinceEpoch(record.timestamp_ns / 1000000).toString("yyyy-MM-dd hh:mm:ss.zzz");
+            QString line = QString("%1  %2 %3 -> %4  %5")
+                               .arg(time)
+                               .arg(journal.attributeName(record.attribute), -22)
+                               .arg(record.oldValue().isEmpty() ? QString("?") : record.oldValue())
+                               .arg(record.newValue())
+                               .arg(ChangeJournal::originName(record.origin));
+            if (record.pid != 0) {
+                line += QString(" (pid %1)").arg(record.pid);
+            }
+            out() << line << "\n";
+        }
+    }
+    err() << matched << " of " << (journal.head() - journal.firstSequence()) << " records matched\n";
+    return 0;
+}
+
+// Reads the daemon's shared-memory snapshot; no socket and no sysfs access
+int stateCommand(const QStringList& args)
+{
+    QByteArray name = StateSnapshotReader::default_name;
+    if (args.size() == 2 && args.first() == "--shm") {
+        name = QFile::encodeName(args.at(1));
+    } else if (!args.isEmpty()) {
+        return usage();
+    }
+
+    StateSnapshotReader reader;
+    if (!reader.open(name.constData())) {
+        err() << "No state published in " << QString::fromLocal8Bit(name) << "; is galaxybook-controld running?\n";
+        return 1;
+    }
+    StateSnapshotReader::Snapshot snapshot;
+    if (!reader.read(snapshot)) {
+        err() << "The publisher did not finish an update; try again\n";
+        return 1;
+    }
+    auto text = [](const char *field, size_t size) {
+        return QString::fromUtf8(field, static_cast<int>(strnlen(field, size)));
+    };
+    out() << "publisher " << reader.publisherPid() << ", version " << snapshot.version << "\n";
+    for (uint32_t i = 0; i < snapshot.count; ++i) {
+        const StateSnapshotReader::Entry& entry = snapshot.entries[i];
+        QDateTime changed = QDateTime::fromMSecsSinceEpoch(entry.changed_ns / 1000000);
+        out() << QString("%1 %2 changed %3 (%4 times)\n")
+                     .arg(text(entry.name, StateSnapshotReader::name_size), -22)
+                     .arg(text(entry.value, StateSnapshotReader::value_size), -12)
+                     .arg(changed.toString(Qt::ISODateWithMs))
+                     .arg(entry.changes);
+    }
+    return 0;
+}
+
+int benchmarkCommand(Backend& backend, QStringList args)
+{
+    WorkloadBenchmark::Options options;
+    QString jsonPath;
+    bool ok = true;
+    while (!args.isEmpty() && args.first().startsWith("--")) {
+        QString option = args.takeFirst();
+        if (option == "--") {
+            break;
+        }
+        if (args.isEmpty()) {
+            return usage();
+        }
+        QString value = args.takeFirst();
+        if (option == "--runs") {
+            options.runs = value.toInt(&ok);
+        } else if (option == "--warmup") {
+            options.warmup_runs = value.toInt(&ok);
+        } else if (option == "--settle") {
+            options.settle_ms = value.toInt(&ok);
+        } else if (option == "--modes") {
+            options.modes = value.split(',', Qt::SkipEmptyParts);
+        } else if (option == "--json") {
+            jsonPath = value;
+        } else {
+            return usage();
+        }
+        if (!ok) {
+            return usage();
+        }
+    }
+    if (args.isEmpty() || options.runs < 1 || options.warmup_runs < 0 || options.settle_ms < 0) {
+        return usage();
+    }
+    options.command = args;
+
+    WorkloadBenchmark benchmark(options);
+    QVector<WorkloadBenchmark::ModeResult> results = benchmark.run(
+        [&backend](const QString& mode, QString& error) {
+            if (backend.set(DeviceControls::performance_mode, mode)) {
+                return true;
+            }
+            error = backend.error;
+            return false;
+        },
+        err());
+    if (results.isEmpty()) {
+        return 1;
+    }
+
+    out() << "\n" << benchmark.table(results);
+    if (!jsonPath.isEmpty()) {
+        QFile file(jsonPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(benchmark.json(results)) < 0) {
+            err() << "Cannot write " << jsonPath << ": " << file.errorString() << "\n";
+            return 1;
+        }
+    }
+    for (const WorkloadBenchmark::ModeResult& result : results) {
+        if (!result.error.isEmpty()) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Reads the history galaxybook-controld records; the battery itself is
+// only read for the current value
+int batteryCommand(QStringList args)
+{
+    QString path = BatteryHistory::defaultPath();
+    int days = 0;
+    bool ok = true;
+    while (!args.isEmpty()) {
+        QString option = args.takeFirst();
+        if (args.isEmpty()) {
+            return usage();
+        }
+        QString value = args.takeFirst();
+        if (option == "--file") {
+            path = value;
+        } else if (option == "--days") {
+            days = value.toInt(&ok);
+        } else {
+            return usage();
+        }
+        if (!ok || days < 0) {
+            return usage();
+        }
+    }
+
+    BatteryHistory history;
+    if (!history.openReadOnly(path)) {
+        err() << history.errorString() << "\n";
+        return 1;
+    }
+    const char *unit = history.unit() == BatteryHistory::Unit::Charge ? "mAh" : "mWh";
+    BatteryHistory::Sample now = BatteryHistory::sampleBattery();
+    if (now.health() >= 0) {
+        out() << QString("now: %1 of %2 %3 (%4%), %5 cycles, threshold %6%\n")
+                     .arg(now.full)
+                     .arg(now.design)
+                     .arg(unit)
+                     .arg(now.health(), 0, 'f', 1)
+                     .arg(now.cycles)
+                     .arg(now.threshold);
+    }
+    out() << QString("history: %1 daily, %2 hourly, %3 full-resolution samples in %4 bytes\n")
+                 .arg(history.count(BatteryHistory::Tier::Daily))
+                 .arg(history.count(BatteryHistory::Tier::Hourly))
+                 .arg(history.count(BatteryHistory::Tier::Full))
+                 .arg(history.fileSize());
+
+    qint64 to = QDateTime::currentSecsSinceEpoch() + 1;
+    qint64 from = days > 0 ? to - qint64(days) * 86400 : 0;
+    const QVector<BatteryHistory::Sample> samples = history.query(from, to);
+    const QVector<BatteryHistory::WearSegment> segments = BatteryHistory::wearByThreshold(samples);
+    if (segments.isEmpty()) {
+        err() << "No health samples recorded\n";
+        return 0;
+    }
+    out() << QString("\n%1 %2 %3 %4 %5 %6\n")
+                 .arg("threshold", -10)
+                 .arg("from", -10)
+                 .arg("days", 7)
+                 .arg("health", 15)
+                 .arg("lost/month", 11)
+                 .arg("lost/100cyc", 12);
+    for (const BatteryHistory::WearSegment& segment : segments) {
+        QString threshold = segment.threshold < 0 ? QString("?") : QString("%1%").arg(segment.threshold);
+        out() << QString("%1 %2 %3 %4 -> %5 %6 %7\n")
+                     .arg(threshold, -10)
+                     .arg(QDateTime::fromSecsSinceEpoch(segment.first.time).toString("yyyy-MM-dd"), -10)
+                     .arg(segment.days(), 7, 'f', 1)
+                     .arg(segment.first.health(), 6, 'f', 1)
+                     .arg(segment.last.health(), -5, 'f', 1)
+                     .arg(segment.lossPerMonth(), 11, 'f', 2)
+                     .arg(segment.lossPer100Cycles(), 12, 'f', 2);
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QStringList args;
+    for (int i = 1; i < argc; ++i) {
+        args << QString::fromLocal8Bit(argv[i]);
+    }
+
+    bool direct = false;
+    QString socketPath = ControlProtocol::clientSocketPath();
+    while (!args.isEmpty() && args.first().startsWith("--")) {
+        QString option = args.takeFirst();
+        if (option == "--direct") {
+            direct = true;
+        } else if (option == "--socket" && !args.isEmpty()) {
+            socketPath = args.takeFirst();
+        } else if (option == "--sysfs-root" && !args.isEmpty()) {
+            SysfsRoot::setRoot(args.takeFirst());
+            direct = true;
+        } else {
+            return usage();
+        }
+    }
+    if (args.isEmpty()) {
+        return usage();
+    }
+
+    if (args.first() == "power") {
+        return powerCommand(args.mid(1));
+    }
+    if (args.first() == "journal") {
+        return journalCommand(args.mid(1));
+    }
+    if (args.first() == "state") {
+        return stateCommand(args.mid(1));
+    }
+    if (args.first() == "battery") {
+        return batteryCommand(args.mid(1));
+    }
+
+    std::unique_ptr<Backend> backend;
+    if (!direct) {
+        auto daemon = std::make_unique<DaemonBackend>();
+        if (daemon->connect(socketPath)) {
+            backend = std::move(daemon);
+        }
+    }
+    if (!backend) {
+        backend = std::make_unique<DirectBackend>();
+    }
+
+    const QString command = args.takeFirst();
+    bool ok = false;
+    if (command == "get" && args.size() == 1) {
+        QString value;
+        ok = backend->get(args.first(), value);
+        if (ok) {
+            out() << value << "\n";
+        }
+    } else if (command == "set" && args.size() == 2) {
+        ok = backend->set(args.at(0), args.at(1));
+    } else if (command == "list" && args.isEmpty()) {
+        QStringList names;
+        ok = backend->list(names);
+        for (const QString& name : names) {
+            QString value;
+            QString description;
+            if (!backend->get(name, value) || !backend->describe(name, description)) {
+                value = "?";
+            }
+            out() << QString("%1 %2 [%3]\n").arg(name, -22).arg(value, -12).arg(description);
+        }
+    } else if (command == "stats" && args.isEmpty()) {
+        QString counters;
+        ok = backend->stats(counters);
+        if (ok) {
+            out() << counters << "\n";
+        }
+    } else if (command == "watch") {
+        return backend->watch(args);
+    } else if (command == "profile") {
+        return profileCommand(*backend, args);
+    } else if (command == "benchmark") {
+        return benchmarkCommand(*backend, args);
+    } else {
+        return usage();
+    }
+
+    if (!ok) {
+        err() << backend->error << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include "AmbientBacklight.h"
+#include "BatteryHistory.h"
+#include "ChangeJournal.h"
+#include "ControlProtocol.h"
+#include "ControlServer.h"
+#include "DeviceControls.h"
+#include "Metrics.h"
+#include "MetricsExporter.h"
+#include "PerformanceGovernor.h"
+#include "StatePublisher.h"
+#include "SysfsRoot.h"
+#include "UeventMonitor.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QTextStream>
+#include <csignal>
+#include <grp.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+namespace {
+
+// Reads a whole number option of at least minimum; complains otherwise
+bool numberOption(const QCommandLineParser& parser, const QCommandLineOption& option, int minimum, int& value)
+{
+    bool ok = false;
+    value = parser.value(option).toInt(&ok);
+    if (!ok || value < minimum) {
+        QTextStream(stderr) << "--" << option.names().first() << " must be a whole number of at least " << minimum
+                            << ", not \"" << parser.value(option) << "\"\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("galaxybook-controld");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Owns the Galaxy Book hardware settings and serves them over a Unix socket.");
+    parser.addHelpOption();
+    QCommandLineOption socketOption("socket", "Path of the control socket.", "path", ControlProtocol::defaultSocketPath());
+    // Root serves the desktop users through the group; see ControlProtocol.h
+    QCommandLineOption socketGroupOption("socket-group",
+        QString("Group allowed to use the control socket (default: %1 when run as root).").arg(ControlProtocol::socket_group),
+        "group", geteuid() == 0 ? ControlProtocol::socket_group : "");
+    QCommandLineOption sysfsRootOption("sysfs-root",
+        QString("Prefix for all /sys paths, e.g. a fake device tree (default: $%1).").arg(SysfsRoot::environment_variable),
+        "directory");
+    QCommandLineOption governorOption("governor", "Switch the performance mode automatically with CPU load, AC and battery.");
+    QCommandLineOption governorIntervalOption("governor-interval", "Governor sampling interval (default 2000).", "ms", "2000");
+    parser.addOption(socketOption);
+    parser.addOption(socketGroupOption);
+    parser.addOption(sysfsRootOption);
+    QCommandLineOption metricsSocketOption("metrics-socket", "Serve Prometheus metrics over HTTP on this Unix socket.", "path");
+    QCommandLineOption metricsFileOption("metrics-file", "Rewrite Prometheus metrics into this file every 15 s.", "path");
+    QCommandLineOption traceCaptureOption("trace-capture", "Record every hardware operation and write a Chrome trace on exit.", "path");
+    parser.addOption(governorOption);
+    parser.addOption(governorIntervalOption);
+    parser.addOption(metricsSocketOption);
+    parser.addOption(metricsFileOption);
+    parser.addOption(traceCaptureOption);
+    QCommandLineOption journalOption("journal", "Record every value change in this journal file (empty to disable).", "path",
+                                     ChangeJournal::system_path);
+    parser.addOption(journalOption);
+    QCommandLineOption stateOption("state-shm", "Publish the current values in this shared-memory segment (empty to disable).",
+                                   "name", StateSnapshotReader::default_name);
+    parser.addOption(stateOption);
+    QCommandLineOption ambientOption("ambient-backlight", "Follow the ambient light sensor with the keyboard backlight.");
+    QCommandLineOption ambientRateOption("ambient-rate", "Sensor sampling rate (default 4).", "hz", "4");
+    parser.addOption(ambientOption);
+    parser.addOption(ambientRateOption);
+    QCommandLineOption batteryHistoryOption("battery-history", "Record battery health in this history file (empty to disable).",
+                                            "path", BatteryHistory::system_path);
+    QCommandLineOption batteryIntervalOption("battery-interval", "Battery sampling interval, at least 60 (default 600).", "seconds", "600");
+    parser.addOption(batteryHistoryOption);
+    parser.addOption(batteryIntervalOption);
+    parser.process(app);
+
+    int governor_interval_ms = 0;
+    int battery_interval_s = 0;
+    AmbientLightSensor::Settings sensorSettings;
+    if (!numberOption(parser, governorIntervalOption, 1, governor_interval_ms)
+        || !numberOption(parser, ambientRateOption, 1, sensorSettings.sampling_hz)
+        // Health moves over weeks; finer samples only grow the file
+        || !numberOption(parser, batteryIntervalOption, 60, battery_interval_s)) {
+        return 2;
+    }
+
+    if (parser.isSet(sysfsRootOption)) {
+        SysfsRoot::setRoot(parser.value(sysfsRootOption));
+    }
+
+    // Quit cleanly on SIGINT/SIGTERM so the socket file is removed
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &signals, nullptr);
+    int signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    QSocketNotifier signalNotifier(signal_fd, QSocketNotifier::Read);
+    QObject::connect(&signalNotifier, &QSocketNotifier::activated, &app, &QCoreApplication::quit);
+
+    // Recording starts before the first hardware access
+    MetricsExporter exporter;
+    if (parser.isSet(metricsSocketOption) || parser.isSet(metricsFileOption) || parser.isSet(traceCaptureOption)) {
+        if (!Metrics::compiledIn()) {
+            QTextStream(stderr) << "Built without CONFIG+=galaxybook_trace; metrics stay empty\n";
+        }
+        Metrics::setEnabled(true);
+    }
+    if (parser.isSet(traceCaptureOption)) {
+        Metrics::startCapture();
+    }
+
+    ChangeJournal journal;
+    if (!parser.value(journalOption).isEmpty() && !journal.open(parser.value(journalOption))) {
+        QTextStream(stderr) << journal.errorString() << "; changes are not journaled\n";
+    }
+
+    DeviceControls controls;
+    ControlServer server(controls);
+    server.setJournal(&journal);
+    if (!parser.value(socketGroupOption).isEmpty()) {
+        struct group *entry = ::getgrnam(QFile::encodeName(parser.value(socketGroupOption)).constData());
+        if (entry) {
+            server.setSocketGroup(entry->gr_gid);
+        } else {
+            QTextStream(stderr) << "No group " << parser.value(socketGroupOption) << "; only root can use the socket\n";
+        }
+    }
+    if (!server.listen(parser.value(socketOption))) {
+        QTextStream(stderr) << server.errorString() << "\n";
+        return 1;
+    }
+
+    // Only now: holding the socket means no other daemon publishes, so a
+    // socket, file or segment left under these names is ours to replace
+    if ((parser.isSet(metricsSocketOption) && !exporter.listen(parser.value(metricsSocketOption)))
+        || (parser.isSet(metricsFileOption) && !exporter.writeFile(parser.value(metricsFileOption)))) {
+        QTextStream(stderr) << exporter.errorString() << "\n";
+        return 1;
+    }
+    StatePublisher statePublisher;
+    if (!parser.value(stateOption).isEmpty()) {
+        if (statePublisher.open(parser.value(stateOption))) {
+            server.setStatePublisher(&statePublisher);
+        } else {
+            QTextStream(stderr) << statePublisher.errorString() << "; state is not published\n";
+        }
+    }
+
+    // Its writes are announced and journaled here; the watcher's echo is not announced again
+    PerformanceGovernor governor;
+    if (parser.isSet(governorOption)) {
+        QObject::connect(&governor, &PerformanceGovernor::modeChanged, [&server](const QString& mode, int load) {
+            QTextStream(stdout) << "governor: " << mode << " (load " << load << "%)" << Qt::endl;
+            server.noteWrite(DeviceControls::performance_mode, mode, ChangeJournal::Origin::Governor);
+        });
+        if (!governor.start(governor_interval_ms)) {
+            QTextStream(stderr) << "Performance mode is not supported; governor disabled\n";
+        }
+    }
+
+    AmbientBacklight ambient;
+    if (parser.isSet(ambientOption)) {
+        QObject::connect(&ambient, &AmbientBacklight::levelChanged, [&server](int level, double lux) {
+            QTextStream(stdout) << "ambient: keyboard backlight " << level << " (" << qRound(lux) << " lx)" << Qt::endl;
+            server.noteWrite(DeviceControls::keyboard_backlight, QString::number(level), ChangeJournal::Origin::AmbientLight);
+        });
+        if (!ambient.start(sensorSettings)) {
+            QTextStream(stderr) << ambient.errorString() << "; ambient backlight disabled\n";
+        }
+    }
+
+    BatteryHistoryRecorder batteryRecorder;
+    if (!parser.value(batteryHistoryOption).isEmpty()
+        && !batteryRecorder.start(parser.value(batteryHistoryOption), battery_interval_s)) {
+        QTextStream(stderr) << batteryRecorder.errorString() << "; battery health is not recorded\n";
+    }
+
+    // The driver may load after us, or be reloaded on resume
+    UeventMonitor hotplug;
+    if (hotplug.open()) {
+        QObject::connect(&hotplug, &UeventMonitor::devicesChanged, [&] {
+            server.refreshDevices();
+            if (parser.isSet(governorOption) && !governor.isRunning()) {
+                governor.start(governor_interval_ms);
+            }
+            if (parser.isSet(ambientOption) && !ambient.isRunning()) {
+                ambient.start(sensorSettings);
+            }
+        });
+    } else {
+        QTextStream(stderr) << hotplug.errorString() << "; devices present at start only\n";
+    }
+
+    int result = app.exec();
+    server.close();
+    exporter.close();
+    if (parser.isSet(traceCaptureOption)) {
+        QFile trace(parser.value(traceCaptureOption));
+        if (!trace.open(QIODevice::WriteOnly | QIODevice::Truncate) || trace.write(Metrics::stopCapture()) < 0) {
+            QTextStream(stderr) << "Cannot write " << trace.fileName() << "\n";
+        }
+    }
+    ::close(signal_fd);
+    return result;
+}
@@ -8,22 +8,18 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+include(core.pri)
+
 SOURCES += \
-    BatteryChargeControl.cpp \
-    FirmwareAttribute.cpp \
-    KeyboardBacklight.cpp \
-    PerformanceMode.cpp \
-    UnsupportedFeatureException.cpp \
+    BatteryHealthDialog.cpp \
     main.cpp \
-    MainWindow.cpp
+    MainWindow.cpp \
+    TrayResidence.cpp
 
 HEADERS += \
-    BatteryChargeControl.h \
-    FirmwareAttribute.h \
-    KeyboardBacklight.h \
+    BatteryHealthDialog.h \
     MainWindow.h \
-    PerformanceMode.h \
-    UnsupportedFeatureException.h
+    TrayResidence.h
 
 FORMS += \
     MainWindow.ui
@@ -1,11 +1,103 @@
 #include "MainWindow.h"
+#include "Metrics.h"
+#include "MetricsExporter.h"
+#include "SysfsRoot.h"
+#include "TrayResidence.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDeadlineTimer>
+#include <QFile>
+#include <QTextStream>
+#include <memory>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
-    MainWindow w;
-    w.show();
-    return a.exec();
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption sysfsRootOption("sysfs-root",
+        QString("Prefix for all /sys paths, e.g. a fake device tree (default: $%1).").arg(SysfsRoot::environment_variable),
+        "directory");
+    parser.addOption(sysfsRootOption);
+    QCommandLineOption quitAfterShowOption("quit-after-show", "Exit as soon as the window is painted and live (for startup measurements).");
+    parser.addOption(quitAfterShowOption);
+    QCommandLineOption reportStartupOption("report-startup", "Print the monotonic time (ns) of the first paint and of the end of startup.");
+    parser.addOption(reportStartupOption);
+    QCommandLineOption metricsFileOption("metrics-file", "Rewrite Prometheus metrics into this file every 15 s.", "path");
+    parser.addOption(metricsFileOption);
+    QCommandLineOption traceCaptureOption("trace-capture", "Record every hardware operation and write a Chrome trace on exit.", "path");
+    parser.addOption(traceCaptureOption);
+    QCommandLineOption trayOption("tray", "Keep watching from the system tray when the window is closed.");
+    parser.addOption(trayOption);
+    QCommandLineOption backgroundOption("background", "Start without a window, as with --tray after closing it.");
+    parser.addOption(backgroundOption);
+    parser.process(a);
+
+    if (parser.isSet(sysfsRootOption)) {
+        SysfsRoot::setRoot(parser.value(sysfsRootOption));
+    }
+
+    MetricsExporter exporter;
+    if (parser.isSet(metricsFileOption) || parser.isSet(traceCaptureOption)) {
+        Metrics::setEnabled(true);
+    }
+    if (parser.isSet(traceCaptureOption)) {
+        Metrics::startCapture();
+    }
+    if (parser.isSet(metricsFileOption)) {
+        exporter.writeFile(parser.value(metricsFileOption));
+    }
+
+    bool painted = false;
+    bool finished = false;
+    auto milestone = [&](bool& reached, const char *name) {
+        reached = true;
+        if (parser.isSet(reportStartupOption)) {
+            QTextStream(stdout) << name << " " << QDeadlineTimer::current().deadlineNSecs() << Qt::endl;
+        }
+        if (painted && finished && parser.isSet(quitAfterShowOption)) {
+            QCoreApplication::quit();
+        }
+    };
+    auto track = [&](MainWindow *window) {
+        QObject::connect(window, &MainWindow::firstPainted, [&] { milestone(painted, "first-paint"); });
+        QObject::connect(window, &MainWindow::startupFinished, [&] { milestone(finished, "interactive"); });
+    };
+
+    // The window lives as long as the process unless the tray takes over
+    std::unique_ptr<MainWindow> w;
+    std::unique_ptr<TrayResidence> tray;
+    if (parser.isSet(trayOption) || parser.isSet(backgroundOption)) {
+        tray = std::make_unique<TrayResidence>();
+        if (!tray->hasTray()) {
+            if (parser.isSet(backgroundOption)) {
+                QTextStream(stderr) << "No system tray is available; --background would leave no way to the window\n";
+                return 2;
+            }
+            QTextStream(stderr) << "No system tray is available; closing the window quits\n";
+        }
+        QObject::connect(tray.get(), &TrayResidence::windowCreated, track);
+        if (parser.isSet(backgroundOption)) {
+            tray->hideToTray();
+        } else {
+            tray->showWindow();
+        }
+    } else {
+        w = std::make_unique<MainWindow>();
+        track(w.get());
+        w->show();
+    }
+    int result = a.exec();
+    tray.reset();
+    w.reset();
+    exporter.close();
+    if (parser.isSet(traceCaptureOption)) {
+        QFile trace(parser.value(traceCaptureOption));
+        if (trace.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            trace.write(Metrics::stopCapture());
+        }
+    }
+    return result;
 }
@@ -0,0 +1,20 @@
+# Static library for programs that read the state galaxybook-controld
+# publishes in shared memory; needs nothing but libc
+
+TEMPLATE = lib
+CONFIG += staticlib c++17
+CONFIG -= qt
+
+TARGET = galaxybook-state
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    ../StateSnapshotReader.cpp
+
+HEADERS += \
+    ../StateSnapshotReader.h
+
+# Default rules for deployment.
+unix:!android: target.path = /opt/galaxybook-control/lib
+!isEmpty(target.path): INSTALLS += target